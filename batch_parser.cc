@@ -0,0 +1,277 @@
+#include "batch_parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace mukhi::matching_engine {
+
+namespace {
+constexpr size_t kBlockSize = 64;
+// Commas of an add order request with a symbol, any more and the line is
+// ill-formed.
+constexpr size_t kMaxCommas = 5;
+
+uint64_t StructuralMaskScalar(const char* block) {
+  uint64_t mask = 0;
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    mask |= static_cast<uint64_t>(block[i] == ',' || block[i] == '\n') << i;
+  }
+  return mask;
+}
+
+#if defined(__x86_64__)
+// SSE2 is part of x86-64, so it's always available.
+uint64_t StructuralMaskSse2(const char* block) {
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i new_line = _mm_set1_epi8('\n');
+  uint64_t mask = 0;
+  for (size_t i = 0; i < kBlockSize; i += 16) {
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+    __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(v, comma),
+                              _mm_cmpeq_epi8(v, new_line));
+    mask |= static_cast<uint64_t>(
+                static_cast<uint16_t>(_mm_movemask_epi8(eq)))
+            << i;
+  }
+  return mask;
+}
+
+__attribute__((target("avx2"))) uint64_t StructuralMaskAvx2(
+    const char* block) {
+  const __m256i comma = _mm256_set1_epi8(',');
+  const __m256i new_line = _mm256_set1_epi8('\n');
+  __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+  __m256i hi =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+  __m256i eq_lo = _mm256_or_si256(_mm256_cmpeq_epi8(lo, comma),
+                                  _mm256_cmpeq_epi8(lo, new_line));
+  __m256i eq_hi = _mm256_or_si256(_mm256_cmpeq_epi8(hi, comma),
+                                  _mm256_cmpeq_epi8(hi, new_line));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(eq_lo)) |
+         static_cast<uint64_t>(static_cast<uint32_t>(
+             _mm256_movemask_epi8(eq_hi)))
+             << 32;
+}
+#endif
+
+uint64_t (*StructuralMask(SimdLevel level))(const char*) {
+#if defined(__x86_64__)
+  switch (level) {
+    case SimdLevel::kAvx2:
+      return StructuralMaskAvx2;
+    case SimdLevel::kSse2:
+      return StructuralMaskSse2;
+    default:
+      break;
+  }
+#endif
+  return StructuralMaskScalar;
+}
+
+// Returns true if all 8 bytes of `v` are ASCII digits.
+bool IsEightDigits(uint64_t v) {
+  return ((v & 0xF0F0F0F0F0F0F0F0) |
+          (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+         0x3333333333333333;
+}
+
+// Converts 8 ASCII digits, the first one in the lowest byte, to their value.
+uint64_t EightDigitsValue(uint64_t v) {
+  v -= 0x3030303030303030;
+  // Combine pairs of digits, then pairs of pairs and so on.
+  v = (v * 10) + (v >> 8);
+  v = (((v & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+       (((v >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >>
+      32;
+  return v;
+}
+
+/*
+Decodes a field of `1` to `19` digits, which can't overflow. Returns false for
+anything else, including longer fields that `std::from_chars` might still
+accept, which are left to `parse`.
+*/
+bool ParseDigits(const char* p, size_t n, uint64_t& value) {
+  if (n == 0 || n > 19) return false;
+  uint64_t result = 0;
+  for (; n >= 8; p += 8, n -= 8) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    if (!IsEightDigits(v)) return false;
+    result = result * 100000000 + EightDigitsValue(v);
+  }
+  for (; n > 0; ++p, --n) {
+    uint32_t digit = static_cast<uint8_t>(*p) - static_cast<uint32_t>('0');
+    if (digit > 9) return false;
+    result = result * 10 + digit;
+  }
+  value = result;
+  return true;
+}
+
+// Decodes a price the way `parse` does, but without falling back on
+// `std::strtod` for the prices that aren't plain decimals, which are left to
+// `parse`.
+bool ParsePrice(const char* p, size_t n, Price& price) {
+  auto units = ParseFixedPoint(std::string_view(p, n), kPriceDecimals);
+  if (!units.has_value()) return false;
+  price = FixedPointToPrice(*units, kPriceDecimals);
+  return true;
+}
+
+// Decodes the symbol from `begin` to the end of the line.
+bool ParseSymbol(std::string_view line, size_t begin, Symbol& symbol) {
+  auto result = Symbol::FromString(line.substr(begin));
+  if (!result.has_value()) return false;
+  symbol = *result;
+  return true;
+}
+
+/*
+Decodes a well-formed line with plain decimal fields. `commas` are the offsets
+of the first `num_commas` commas of the line, at most `kMaxCommas` of them.
+*/
+bool ParseLineFast(std::string_view line, const size_t* commas,
+                   size_t num_commas, InputMessage& msg) {
+  const char* p = line.data();
+  if (num_commas == 0 || commas[0] != 1) return false;
+  if (p[0] == '0' && (num_commas == 4 || num_commas == 5)) {
+    AddOrderRequest req;
+    if (!ParseDigits(p + 2, commas[1] - 2, req.order_id)) return false;
+    if (commas[2] != commas[1] + 2) return false;
+    switch (p[commas[1] + 1]) {
+      case '0':
+        req.side = Side::kBuy;
+        break;
+      case '1':
+        req.side = Side::kSell;
+        break;
+      default:
+        return false;
+    }
+    if (!ParseDigits(p + commas[2] + 1, commas[3] - commas[2] - 1, req.qty)) {
+      return false;
+    }
+    size_t price_end = num_commas == 5 ? commas[4] : line.size();
+    if (!ParsePrice(p + commas[3] + 1, price_end - commas[3] - 1,
+                    req.price)) {
+      return false;
+    }
+    if (num_commas == 5 && !ParseSymbol(line, commas[4] + 1, req.symbol)) {
+      return false;
+    }
+    msg = req;
+    return true;
+  }
+  if (p[0] == '1' && (num_commas == 1 || num_commas == 2)) {
+    CancelOrderRequest req;
+    size_t order_id_end = num_commas == 2 ? commas[1] : line.size();
+    if (!ParseDigits(p + 2, order_id_end - 2, req.order_id)) return false;
+    if (num_commas == 2 && !ParseSymbol(line, commas[1] + 1, req.symbol)) {
+      return false;
+    }
+    msg = req;
+    return true;
+  }
+  if (p[0] == '5' && (num_commas == 3 || num_commas == 4)) {
+    ModifyOrderRequest req;
+    if (!ParseDigits(p + 2, commas[1] - 2, req.order_id)) return false;
+    if (!ParseDigits(p + commas[1] + 1, commas[2] - commas[1] - 1, req.qty)) {
+      return false;
+    }
+    size_t price_end = num_commas == 4 ? commas[3] : line.size();
+    if (!ParsePrice(p + commas[2] + 1, price_end - commas[2] - 1,
+                    req.price)) {
+      return false;
+    }
+    if (num_commas == 4 && !ParseSymbol(line, commas[3] + 1, req.symbol)) {
+      return false;
+    }
+    msg = req;
+    return true;
+  }
+  return false;
+}
+}  // namespace
+
+SimdLevel DetectSimdLevel() {
+#if defined(__x86_64__)
+  static const SimdLevel level = __builtin_cpu_supports("avx2")
+                                     ? SimdLevel::kAvx2
+                                     : SimdLevel::kSse2;
+  return level;
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+BatchParser::BatchParser(SimdLevel level)
+    : level_(std::min(level, DetectSimdLevel())),
+      structural_mask_(StructuralMask(level_)) {}
+
+size_t BatchParser::Parse(std::string_view input, size_t max_messages,
+                          std::vector<InputMessage>& out,
+                          std::ostream& es) const {
+  out.clear();
+  const char* data = input.data();
+  const size_t size = input.size();
+  size_t line_start = 0;
+  size_t commas[kMaxCommas];
+  size_t num_commas = 0;
+
+  // Parses the line ending at `line_end`, returns false to stop before it.
+  auto parse_line = [&](size_t line_end) {
+    std::string_view line(data + line_start, line_end - line_start);
+    InputMessage msg;
+    if (ParseLineFast(line, commas, num_commas, msg)) {
+      out.push_back(msg);
+    } else if (line_start == 0) {
+      if (auto req = parse(line, es); req.has_value()) out.push_back(*req);
+    } else {
+      return false;
+    }
+    line_start = line_end + 1;
+    num_commas = 0;
+    return true;
+  };
+
+  char tail[kBlockSize];
+  for (size_t block = 0; block < size; block += kBlockSize) {
+    uint64_t mask;
+    if (size - block >= kBlockSize) {
+      mask = structural_mask_(data + block);
+    } else {
+      // Pad the last block, neither commas nor new lines are found in zeros.
+      std::memset(tail, 0, kBlockSize);
+      std::memcpy(tail, data + block, size - block);
+      mask = structural_mask_(tail);
+    }
+    while (mask != 0) {
+      size_t pos = block + __builtin_ctzll(mask);
+      mask &= mask - 1;
+      if (data[pos] == ',') {
+        if (num_commas < kMaxCommas) commas[num_commas] = pos - line_start;
+        // Keep counting, so that lines with too many commas aren't mistaken
+        // for well-formed ones.
+        num_commas = std::min(num_commas + 1, kMaxCommas + 1);
+        continue;
+      }
+      if (!parse_line(pos)) return line_start;
+      if (out.size() >= max_messages) return line_start;
+    }
+  }
+  if (line_start < size) {
+    if (!parse_line(size)) return line_start;
+    // There's no new line to skip over.
+    line_start = size;
+  }
+  return line_start;
+}
+
+}  // namespace mukhi::matching_engine
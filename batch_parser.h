@@ -0,0 +1,69 @@
+#ifndef MATCHING_ENGINE_BATCH_PARSER_H
+#define MATCHING_ENGINE_BATCH_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "messages.h"
+
+namespace mukhi::matching_engine {
+
+// Instruction sets the tokenizer of `BatchParser` can use.
+enum class SimdLevel : uint8_t {
+  kScalar = 0,
+  kSse2 = 1,
+  kAvx2 = 2,
+};
+
+// Returns the best level supported by this CPU.
+SimdLevel DetectSimdLevel();
+
+/*
+Parses many lines of the text input format at once, for ingesting large
+buffers such as files mapped into memory.
+
+The buffer is tokenized 64 bytes at a time: vector compares find all the commas
+and new lines of a block at once, and the lines are then cut at those positions
+without scanning them again. Well-formed lines with plain decimal fields are
+decoded by a fast path, which converts 8 digits at a time with a few
+multiplications. Any other line, including every ill-formed one, is handed to
+`parse`, so the results and the error messages are exactly the same as parsing
+the lines one by one.
+
+This class is thread-compatible.
+*/
+class BatchParser {
+ public:
+  explicit BatchParser(SimdLevel level = DetectSimdLevel());
+
+  /**
+  Parses lines from the front of `input` into `out`, replacing its contents,
+  until either `max_messages` messages are parsed or the end of `input` is
+  reached. Returns the number of bytes consumed, which is always at the end of a
+  line, and more than zero unless `input` is empty. Same as `std::getline`, the
+  last line of `input` doesn't need to end with a new line.
+
+  Ill-formed lines are reported to `es` and skipped. So that the errors stay in
+  order with the processing of the messages around them, an ill-formed line is
+  only reported when it's the first line of `input`, otherwise parsing stops
+  right before it.
+  */
+  size_t Parse(std::string_view input, size_t max_messages,
+               std::vector<InputMessage>& out, std::ostream& es) const;
+
+  SimdLevel level() const { return level_; }
+
+ private:
+  using StructuralMaskFunction = uint64_t (*)(const char*);
+
+  const SimdLevel level_;
+  // Returns a mask of the commas and new lines in a block of 64 bytes.
+  const StructuralMaskFunction structural_mask_;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_BATCH_PARSER_H
@@ -0,0 +1,174 @@
+#include "batch_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mukhi::matching_engine {
+
+// Parses all of `input` with `parser`, the same way the matching engine does.
+std::vector<InputMessage> ParseAll(const BatchParser& parser,
+                                   std::string_view input, size_t max_messages,
+                                   std::ostream& es) {
+  std::vector<InputMessage> all;
+  std::vector<InputMessage> batch;
+  while (!input.empty()) {
+    size_t consumed = parser.Parse(input, max_messages, batch, es);
+    EXPECT_GT(consumed, 0);
+    EXPECT_LE(batch.size(), std::max<size_t>(max_messages, 1));
+    all.insert(all.end(), batch.begin(), batch.end());
+    input.remove_prefix(consumed);
+  }
+  return all;
+}
+
+// Parses all of `input` one line at a time with `parse`.
+std::vector<InputMessage> ParseLines(std::string_view input,
+                                     std::ostream& es) {
+  std::vector<InputMessage> all;
+  std::istringstream is{std::string(input)};
+  std::string line;
+  while (std::getline(is, line)) {
+    if (auto msg = parse(line, es); msg.has_value()) all.push_back(*msg);
+  }
+  return all;
+}
+
+bool operator==(const InputMessage& a, const InputMessage& b) {
+  if (a.index() != b.index()) return false;
+  if (const auto* add = std::get_if<AddOrderRequest>(&a)) {
+    const auto& other = std::get<AddOrderRequest>(b);
+    return add->order_id == other.order_id && add->side == other.side &&
+           add->qty == other.qty && add->price == other.price &&
+           add->symbol == other.symbol;
+  }
+  if (const auto* modify = std::get_if<ModifyOrderRequest>(&a)) {
+    const auto& other = std::get<ModifyOrderRequest>(b);
+    return modify->order_id == other.order_id && modify->qty == other.qty &&
+           modify->price == other.price && modify->symbol == other.symbol;
+  }
+  const auto& cancel = std::get<CancelOrderRequest>(a);
+  const auto& other = std::get<CancelOrderRequest>(b);
+  return cancel.order_id == other.order_id && cancel.symbol == other.symbol;
+}
+
+class BatchParserTest : public testing::TestWithParam<SimdLevel> {
+ protected:
+  void ExpectSameAsParse(std::string_view input, size_t max_messages = 256) {
+    std::ostringstream expected_es;
+    std::vector<InputMessage> expected = ParseLines(input, expected_es);
+    std::ostringstream es;
+    std::vector<InputMessage> actual =
+        ParseAll(BatchParser(GetParam()), input, max_messages, es);
+    EXPECT_EQ(es.str(), expected_es.str());
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+      EXPECT_TRUE(actual[i] == expected[i]) << "message " << i;
+    }
+  }
+};
+
+TEST_P(BatchParserTest, WellFormed) {
+  std::ostringstream es;
+  std::vector<InputMessage> batch;
+  std::string_view input =
+      "0,1000000,1,45,1075.5\n1,1000000\n0,12345678901234567,0,1,0.001\n";
+  EXPECT_EQ(BatchParser(GetParam()).Parse(input, 10, batch, es),
+            input.size());
+  ASSERT_EQ(batch.size(), 3);
+  EXPECT_TRUE(batch[0] == InputMessage(AddOrderRequest{.order_id = 1000000,
+                                                       .side = Side::kSell,
+                                                       .qty = 45,
+                                                       .price = 1075.5}));
+  EXPECT_TRUE(batch[1] ==
+              InputMessage(CancelOrderRequest{.order_id = 1000000}));
+  EXPECT_TRUE(batch[2] ==
+              InputMessage(AddOrderRequest{.order_id = 12345678901234567,
+                                           .side = Side::kBuy,
+                                           .qty = 1,
+                                           .price = 0.001}));
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST_P(BatchParserTest, StopsBeforeIllFormedLine) {
+  std::ostringstream es;
+  std::vector<InputMessage> batch;
+  BatchParser parser(GetParam());
+  std::string_view input = "1,1\n1,A\n1,2";
+  EXPECT_EQ(parser.Parse(input, 10, batch, es), 4);
+  EXPECT_EQ(batch.size(), 1);
+  EXPECT_EQ(es.str(), "");
+
+  // Reported when it's the first line, then parsing goes on.
+  input.remove_prefix(4);
+  EXPECT_EQ(parser.Parse(input, 10, batch, es), input.size());
+  ASSERT_EQ(batch.size(), 1);
+  EXPECT_TRUE(batch[0] == InputMessage(CancelOrderRequest{.order_id = 2}));
+  EXPECT_EQ(es.str(),
+            "Bad message: Unparsable order id in cancel order request : A\n");
+}
+
+TEST_P(BatchParserTest, MaxMessages) {
+  std::ostringstream es;
+  std::vector<InputMessage> batch;
+  std::string_view input = "1,1\n1,2\n1,3\n";
+  EXPECT_EQ(BatchParser(GetParam()).Parse(input, 2, batch, es), 8);
+  EXPECT_EQ(batch.size(), 2);
+}
+
+TEST_P(BatchParserTest, SameAsParse) {
+  ExpectSameAsParse("");
+  ExpectSameAsParse("\n\n");
+  ExpectSameAsParse("1,1");
+  // Fields the fast path leaves to `parse`.
+  ExpectSameAsParse(
+      "0,1,0,9,1e3\n0,1,0,9,+1000\n0,1,0,9, 1000\n0,1,0,9,1000 \n"
+      "0,1,00,9,1000\n00,1,0,9,1000\n0,01,1,9,.5\n0,1,1,9,5.\n0,1,1,9,.\n"
+      "0,1,1,9,\n0,1,1,,9\n0,,1,9,9\n0,1,2,9,9\n0,1,1,9,9,9\n1,1,1\n1,\n"
+      "1,-1\n1,+1\n2,1\n,\n0,1,0,9,1000\r\n1,18446744073709551615\n"
+      "1,18446744073709551616\n0,1,0,99999999999999999999,1\n"
+      "0,1,0,9,9007199254740993\n0,1,0,9,0.30000000000000004\n"
+      "0,1,0,9,123456789.123456789\n0,1,0,9,1234567890123456789012\n");
+  // Symbols.
+  ExpectSameAsParse(
+      "0,1,0,9,1000,AAPL\n1,1,AAPL\n0,1,0,9,1000,\n1,1,\n0,1,0,9,,AAPL\n"
+      "1,,AAPL\n0,1,0,9,1000,A B\n1,1,ABCDEFGHIJKLMNOPQ\n"
+      "0,1,0,9,1000,ABCDEFGHIJKLMNOP\n0,1,0,9,1000,A,B\n1,1,A,B\n");
+  // Modifies.
+  ExpectSameAsParse(
+      "5,1,9,1000\n5,1,0,1000.25,AAPL\n5,1,9,1000,\n5,1,9,,AAPL\n5,1,9\n"
+      "5,1,,1000\n5,,9,1000\n5,1,9, 1000\n5,1,-9,1000\n5,1,9,1e3\n"
+      "5,1,9,1000,A,B\n5,1,1,9,1000\n");
+}
+
+TEST_P(BatchParserTest, RandomStream) {
+  // Lines of every length straddle the block boundaries, with some corrupted.
+  std::mt19937_64 rng(7);
+  const std::string alphabet = "0123456789,.\n ae-";
+  std::string input;
+  for (int i = 0; i < 20000; ++i) {
+    std::string line;
+    if (rng() % 3 == 0) {
+      line = "1," + std::to_string(rng() >> (rng() % 64));
+    } else {
+      line = "0," + std::to_string(rng() >> (rng() % 64)) + "," +
+             std::to_string(rng() % 2) + "," +
+             std::to_string(rng() >> (rng() % 64)) + "," +
+             std::to_string(rng() % 100000) + "." +
+             std::to_string(rng() % 1000);
+    }
+    if (rng() % 10 == 0) line[rng() % line.size()] = alphabet[rng() % 17];
+    input += line + "\n";
+  }
+  ExpectSameAsParse(input);
+  ExpectSameAsParse(input, 7);
+}
+
+INSTANTIATE_TEST_SUITE_P(SimdLevels, BatchParserTest,
+                         testing::Values(SimdLevel::kScalar, SimdLevel::kSse2,
+                                         SimdLevel::kAvx2));
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,36 @@
+#include "benchmark_util.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<uint64_t> allocation_count{0};
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace mukhi::matching_engine {
+
+uint64_t AllocationCount() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+void ReportPerOp(benchmark::State& state, int64_t ops, uint64_t allocations) {
+  state.SetItemsProcessed(ops);
+  // Inverting the rate of `ops` gives the time per op.
+  state.counters["time_per_op"] = benchmark::Counter(
+      static_cast<double>(ops),
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  state.counters["allocs_per_op"] =
+      ops == 0 ? 0 : static_cast<double>(allocations) / ops;
+}
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,42 @@
+#ifndef MATCHING_ENGINE_BENCHMARK_UTIL_H
+#define MATCHING_ENGINE_BENCHMARK_UTIL_H
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+
+namespace mukhi::matching_engine {
+
+// Number of heap allocations made by the process so far. Linking this library
+// replaces the global `operator new` with a counting one.
+uint64_t AllocationCount();
+
+/**
+ Reports the usual figures of a benchmark that ran `ops` operations in total
+(across all iterations) and made `allocations` heap allocations while timed:
+`items_per_second` (ops/sec), `time_per_op` (in seconds) and `allocs_per_op`.
+*/
+void ReportPerOp(benchmark::State& state, int64_t ops, uint64_t allocations);
+
+// An output stream that formats everything written to it and then drops it.
+class NullStream : public std::ostream {
+ public:
+  NullStream() : std::ostream(&buf_) {}
+
+ private:
+  class NullBuffer : public std::streambuf {
+   protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+      return n;
+    }
+  };
+
+  NullBuffer buf_;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_BENCHMARK_UTIL_H
@@ -0,0 +1,64 @@
+// Converts the binary event feed of the engine (`--output_format=binary`) back
+// to the text output format, e.g.:
+//
+// $ bazel-bin/main --output_format=binary < input.txt 2>/dev/null |
+//     bazel-bin/event_decode > output.txt
+//
+// Gaps in the sequence numbers and frames that can't be decoded are reported
+// on stderr.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "event_sink.h"
+
+namespace {
+
+constexpr char kUsage[] = R"(Flags:
+  --input=PATH  Binary event feed to decode (default stdin).
+)";
+
+// Parses `--<name>=<value>` and returns the value, or nullptr if `arg` is not
+// `name`.
+const char* FlagValue(std::string_view arg, std::string_view name) {
+  if (arg.substr(0, 2) != "--" || arg.substr(2, name.size()) != name ||
+      arg.substr(2 + name.size(), 1) != "=") {
+    return nullptr;
+  }
+  return arg.data() + 3 + name.size();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::ios_base::sync_with_stdio(false);
+  std::string input_path;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg(argv[i]);
+    const char* v;
+    if (arg == "--help") {
+      std::cout << kUsage;
+      return 0;
+    } else if ((v = FlagValue(arg, "input"))) {
+      input_path = v;
+    } else {
+      std::cerr << "Unknown flag: " << arg << std::endl << kUsage;
+      return 1;
+    }
+  }
+
+  std::ifstream file;
+  if (!input_path.empty()) {
+    file.open(input_path, std::ios::binary);
+    if (!file.is_open()) {
+      std::cerr << "Unable to open " << input_path << std::endl;
+      return 1;
+    }
+  }
+  std::istream& is = input_path.empty() ? std::cin : file;
+  return mukhi::matching_engine::DecodeBinaryEvents(is, std::cout, std::cerr)
+             ? 0
+             : 1;
+}
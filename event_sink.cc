@@ -0,0 +1,144 @@
+#include "event_sink.h"
+
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+namespace mukhi::matching_engine {
+
+void PublishEvent(const OutputEvent& event, EventSink& sink) {
+  std::visit(
+      [&sink](const auto& e) {
+        using T = std::decay_t<decltype(e)>;
+        if constexpr (std::is_same_v<T, TradeEvent>) {
+          sink.OnTradeEvent(e);
+        } else if constexpr (std::is_same_v<T, OrderFullyFilled>) {
+          sink.OnOrderFullyFilled(e);
+        } else if constexpr (std::is_same_v<T, OrderPartiallyFilled>) {
+          sink.OnOrderPartiallyFilled(e);
+        } else if constexpr (std::is_same_v<T, DepthUpdate>) {
+          sink.OnDepthUpdate(e);
+        } else {
+          sink.OnBboUpdate(e);
+        }
+      },
+      event);
+}
+
+BufferedSink::BufferedSink(std::ostream& os, size_t flush_threshold,
+                           size_t max_event_size)
+    : os_(os), flush_threshold_(flush_threshold) {
+  buf_.reserve(flush_threshold_ + max_event_size);
+}
+
+BufferedSink::~BufferedSink() { Flush(); }
+
+void BufferedSink::Flush() {
+  if (buf_.empty()) return;
+  os_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+  os_.flush();
+  buf_.clear();
+}
+
+BufferedTextSink::BufferedTextSink(std::ostream& os, size_t flush_threshold)
+    : BufferedSink(os, flush_threshold, kMaxTextEventSize + 1) {}
+
+template <typename Event>
+void BufferedTextSink::AppendLine(const Event& event) {
+  char line[kMaxTextEventSize + 1];
+  size_t size = FormatText(event, line);
+  line[size++] = '\n';
+  Append(line, size);
+}
+
+void BufferedTextSink::OnTradeEvent(const TradeEvent& event) {
+  AppendLine(event);
+}
+
+void BufferedTextSink::OnOrderFullyFilled(const OrderFullyFilled& event) {
+  AppendLine(event);
+}
+
+void BufferedTextSink::OnOrderPartiallyFilled(
+    const OrderPartiallyFilled& event) {
+  AppendLine(event);
+}
+
+void BufferedTextSink::OnDepthUpdate(const DepthUpdate& event) {
+  AppendLine(event);
+}
+
+void BufferedTextSink::OnBboUpdate(const Bbo& event) { AppendLine(event); }
+
+BufferedBinarySink::BufferedBinarySink(std::ostream& os,
+                                       size_t flush_threshold)
+    : BufferedSink(os, flush_threshold, kMaxBinaryEventSize) {}
+
+template <typename Event>
+void BufferedBinarySink::AppendFrame(const Event& event) {
+  char frame[kMaxBinaryEventSize];
+  Append(frame, EncodeBinary(event, ++sequence_, frame));
+}
+
+void BufferedBinarySink::OnTradeEvent(const TradeEvent& event) {
+  AppendFrame(event);
+}
+
+void BufferedBinarySink::OnOrderFullyFilled(const OrderFullyFilled& event) {
+  AppendFrame(event);
+}
+
+void BufferedBinarySink::OnOrderPartiallyFilled(
+    const OrderPartiallyFilled& event) {
+  AppendFrame(event);
+}
+
+void BufferedBinarySink::OnDepthUpdate(const DepthUpdate& event) {
+  AppendFrame(event);
+}
+
+void BufferedBinarySink::OnBboUpdate(const Bbo& event) { AppendFrame(event); }
+
+std::unique_ptr<BufferedSink> MakeBufferedSink(std::ostream& os,
+                                               OutputFormat format,
+                                               size_t flush_threshold) {
+  if (format == OutputFormat::kBinary) {
+    return std::make_unique<BufferedBinarySink>(os, flush_threshold);
+  }
+  return std::make_unique<BufferedTextSink>(os, flush_threshold);
+}
+
+bool DecodeBinaryEvents(std::istream& is, std::ostream& os, std::ostream& es) {
+  BufferedTextSink sink(os);
+  char frame[std::numeric_limits<uint16_t>::max()];
+  uint64_t next_sequence = 1;
+  while (is.read(frame, kBinaryHeaderSize)) {
+    size_t length = BinaryMessageLength(frame);
+    if (length == 0) {
+      es << "Corrupt binary event header" << std::endl;
+      return false;
+    }
+    if (!is.read(frame + kBinaryHeaderSize, length - kBinaryHeaderSize)) {
+      es << "Truncated binary event" << std::endl;
+      return false;
+    }
+    std::optional<SequencedEvent> event =
+        ParseBinaryEvent(std::string_view(frame, length), es);
+    if (!event.has_value()) continue;
+    if (event->sequence != next_sequence) {
+      es << "Sequence gap: expected " << next_sequence << ", got "
+         << event->sequence << std::endl;
+    }
+    next_sequence = event->sequence + 1;
+    PublishEvent(event->event, sink);
+  }
+  if (is.gcount() != 0) {
+    es << "Truncated binary event" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace mukhi::matching_engine
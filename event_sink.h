@@ -0,0 +1,174 @@
+#ifndef MATCHING_ENGINE_EVENT_SINK_H
+#define MATCHING_ENGINE_EVENT_SINK_H
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "messages.h"
+
+namespace mukhi::matching_engine {
+
+/*
+Receives the events published by the order book. Implementations decide how,
+and when, to deliver them.
+
+Sinks are not thread-safe, they're called from the thread processing orders.
+*/
+class EventSink {
+ public:
+  virtual ~EventSink() = default;
+
+  virtual void OnTradeEvent(const TradeEvent& event) = 0;
+  virtual void OnOrderFullyFilled(const OrderFullyFilled& event) = 0;
+  virtual void OnOrderPartiallyFilled(const OrderPartiallyFilled& event) = 0;
+  // Only published by order books with depth or BBO updates enabled, see
+  // `OrderBookOptions`.
+  virtual void OnDepthUpdate(const DepthUpdate&) {}
+  virtual void OnBboUpdate(const Bbo&) {}
+
+  // Delivers any events held back so far. Called at the end of a batch of
+  // input, e.g. before waiting for more input.
+  virtual void Flush() {}
+};
+
+// Calls the method of `sink` for the type of `event`.
+void PublishEvent(const OutputEvent& event, EventSink& sink);
+
+// Wire formats of the events written out by the engines.
+enum class OutputFormat {
+  // One line per event, see `FormatText`.
+  kText = 0,
+  // One frame per event, see `EncodeBinary`.
+  kBinary = 1,
+};
+
+/*
+Base of the sinks that write events to a stream in one of the output formats.
+
+Events are collected in a buffer and written out, followed by a flush of the
+stream, whenever the buffer reaches `flush_threshold` bytes or `Flush` is
+called. A threshold of 0 writes and flushes every event as it's published.
+
+An object of this class keeps a reference to the stream and expects it to stay
+alive for the lifetime of the object. Pending events are flushed on
+destruction.
+*/
+class BufferedSink : public EventSink {
+ public:
+  static constexpr size_t kDefaultFlushThreshold = 64 << 10;
+
+  ~BufferedSink() override;
+
+  void Flush() override;
+
+ protected:
+  // Events must be at most `max_event_size` bytes long.
+  BufferedSink(std::ostream& os, size_t flush_threshold,
+               size_t max_event_size);
+
+  // Adds an event to the buffer, and writes the buffer out once it has reached
+  // the threshold.
+  void Append(const char* event, size_t size) {
+    buf_.append(event, size);
+    if (buf_.size() >= flush_threshold_) Flush();
+  }
+
+ private:
+  std::ostream& os_;
+  const size_t flush_threshold_;
+  std::string buf_;
+};
+
+// Writes events in the text output format, one per line, see `FormatText`.
+// Prices are exact whatever the precision of the stream.
+class BufferedTextSink : public BufferedSink {
+ public:
+  explicit BufferedTextSink(std::ostream& os,
+                            size_t flush_threshold = kDefaultFlushThreshold);
+
+  void OnTradeEvent(const TradeEvent& event) override;
+  void OnOrderFullyFilled(const OrderFullyFilled& event) override;
+  void OnOrderPartiallyFilled(const OrderPartiallyFilled& event) override;
+  void OnDepthUpdate(const DepthUpdate& event) override;
+  void OnBboUpdate(const Bbo& event) override;
+
+ private:
+  template <typename Event>
+  void AppendLine(const Event& event);
+};
+
+// Writes events in the binary output format, see `EncodeBinary`, numbered from
+// 1 in the order they're published.
+class BufferedBinarySink : public BufferedSink {
+ public:
+  explicit BufferedBinarySink(std::ostream& os,
+                              size_t flush_threshold = kDefaultFlushThreshold);
+
+  void OnTradeEvent(const TradeEvent& event) override;
+  void OnOrderFullyFilled(const OrderFullyFilled& event) override;
+  void OnOrderPartiallyFilled(const OrderPartiallyFilled& event) override;
+  void OnDepthUpdate(const DepthUpdate& event) override;
+  void OnBboUpdate(const Bbo& event) override;
+
+  // The sequence number of the last event published, 0 if none was.
+  uint64_t sequence() const { return sequence_; }
+
+ private:
+  template <typename Event>
+  void AppendFrame(const Event& event);
+
+  uint64_t sequence_ = 0;
+};
+
+// Returns a sink that writes events to `os` in `format`.
+std::unique_ptr<BufferedSink> MakeBufferedSink(
+    std::ostream& os, OutputFormat format,
+    size_t flush_threshold = BufferedSink::kDefaultFlushThreshold);
+
+/**
+ Converts a stream of events in the binary output format back to the text
+format, e.g. to diff the output of an engine in either format. Gaps in the
+sequence numbers are reported on `es`, and so are frames that can't be decoded,
+which are skipped. Returns false after reporting it on `es` if a frame header
+is corrupt or `is` ends in the middle of a frame.
+*/
+bool DecodeBinaryEvents(std::istream& is, std::ostream& os, std::ostream& es);
+
+// Drops all events, e.g. for benchmarks of the order book alone.
+class NullEventSink : public EventSink {
+ public:
+  void OnTradeEvent(const TradeEvent&) override {}
+  void OnOrderFullyFilled(const OrderFullyFilled&) override {}
+  void OnOrderPartiallyFilled(const OrderPartiallyFilled&) override {}
+};
+
+// Hands every event to a callback, for embedding the order book in another
+// application.
+class CallbackEventSink : public EventSink {
+ public:
+  using Callback = std::function<void(const OutputEvent&)>;
+
+  explicit CallbackEventSink(Callback callback)
+      : callback_(std::move(callback)) {}
+
+  void OnTradeEvent(const TradeEvent& event) override { callback_(event); }
+  void OnOrderFullyFilled(const OrderFullyFilled& event) override {
+    callback_(event);
+  }
+  void OnOrderPartiallyFilled(const OrderPartiallyFilled& event) override {
+    callback_(event);
+  }
+  void OnDepthUpdate(const DepthUpdate& event) override { callback_(event); }
+  void OnBboUpdate(const Bbo& event) override { callback_(event); }
+
+ private:
+  Callback callback_;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_EVENT_SINK_H
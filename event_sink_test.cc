@@ -0,0 +1,203 @@
+#include "event_sink.h"
+
+#include <gtest/gtest.h>
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mukhi::matching_engine {
+
+// Same output as the stream operators of the events.
+std::string Streamed(const TradeEvent& te, const OrderFullyFilled& off,
+                     const OrderPartiallyFilled& opf) {
+  std::ostringstream os;
+  os << te << "\n" << off << "\n" << opf << "\n";
+  return os.str();
+}
+
+TEST(BufferedTextSink, SameAsStreamOperators) {
+  for (Price price : {1000.0, 1075.5, 0.1, 1234567.0, 1e-7, 99999.25}) {
+    TradeEvent te{.qty = 18446744073709551615u, .price = price};
+    OrderFullyFilled off{.order_id = 1000000};
+    OrderPartiallyFilled opf{.order_id = 1000001, .remaining = 7};
+
+    std::ostringstream os;
+    BufferedTextSink sink(os, /*flush_threshold=*/0);
+    sink.OnTradeEvent(te);
+    sink.OnOrderFullyFilled(off);
+    sink.OnOrderPartiallyFilled(opf);
+    EXPECT_EQ(os.str(), Streamed(te, off, opf));
+  }
+}
+
+TEST(BufferedTextSink, DepthUpdate) {
+  for (Price price : {1000.0, 1075.5, 1e-7}) {
+    for (const Symbol& symbol : {Symbol(), *Symbol::FromString("AAPL")}) {
+      DepthUpdate du{.side = Side::kBuy,
+                     .price = price,
+                     .qty = 18446744073709551615u,
+                     .num_orders = 3,
+                     .symbol = symbol};
+      std::ostringstream expected;
+      expected << du << "\n";
+
+      std::ostringstream os;
+      BufferedTextSink sink(os, /*flush_threshold=*/0);
+      sink.OnDepthUpdate(du);
+      EXPECT_EQ(os.str(), expected.str());
+    }
+  }
+}
+
+TEST(BufferedTextSink, Bbo) {
+  for (const Symbol& symbol : {Symbol(), *Symbol::FromString("AAPL")}) {
+    // An empty side and a full one.
+    Bbo bbo{.ask = {.price = 1e-7, .qty = 18446744073709551615u,
+                    .num_orders = 18446744073709551615u},
+            .symbol = symbol};
+    std::ostringstream expected;
+    expected << std::setprecision(17) << bbo << "\n";
+
+    std::ostringstream os;
+    os << std::setprecision(17);
+    BufferedTextSink sink(os, /*flush_threshold=*/0);
+    sink.OnBboUpdate(bbo);
+    EXPECT_EQ(os.str(), expected.str());
+  }
+}
+
+TEST(BufferedTextSink, Symbol) {
+  Symbol symbol = *Symbol::FromString("ABCDEFGHIJKLMNOP");
+  TradeEvent te{.qty = 1, .price = 1075.5, .symbol = symbol};
+  OrderFullyFilled off{.order_id = 2, .symbol = symbol};
+  OrderPartiallyFilled opf{.order_id = 3, .remaining = 4, .symbol = symbol};
+
+  std::ostringstream os;
+  BufferedTextSink sink(os, /*flush_threshold=*/0);
+  sink.OnTradeEvent(te);
+  sink.OnOrderFullyFilled(off);
+  sink.OnOrderPartiallyFilled(opf);
+  EXPECT_EQ(os.str(), Streamed(te, off, opf));
+}
+
+TEST(BufferedTextSink, ExactPrices) {
+  std::ostringstream os;
+  os << std::setprecision(4);
+  BufferedTextSink sink(os, /*flush_threshold=*/0);
+  sink.OnTradeEvent(TradeEvent{.qty = 1, .price = 1075.123456789});
+  sink.OnTradeEvent(TradeEvent{.qty = 1, .price = 1234567.25});
+  EXPECT_EQ(os.str(), "2,1,1075.123456789\n2,1,1234567.25\n");
+}
+
+TEST(BufferedTextSink, FlushThreshold) {
+  std::ostringstream os;
+  {
+    BufferedTextSink sink(os, /*flush_threshold=*/8);
+    sink.OnOrderFullyFilled(OrderFullyFilled{.order_id = 1});
+    EXPECT_EQ(os.str(), "");
+    sink.OnOrderFullyFilled(OrderFullyFilled{.order_id = 2});
+    EXPECT_EQ(os.str(), "3,1\n3,2\n");
+    sink.OnOrderFullyFilled(OrderFullyFilled{.order_id = 3});
+    EXPECT_EQ(os.str(), "3,1\n3,2\n");
+    sink.Flush();
+    EXPECT_EQ(os.str(), "3,1\n3,2\n3,3\n");
+    sink.OnOrderFullyFilled(OrderFullyFilled{.order_id = 4});
+  }
+  // Flushed on destruction.
+  EXPECT_EQ(os.str(), "3,1\n3,2\n3,3\n3,4\n");
+}
+
+// Publishes one event of every type to `sink`.
+void PublishAll(EventSink& sink) {
+  Symbol symbol = *Symbol::FromString("AAPL");
+  sink.OnTradeEvent(TradeEvent{.qty = 2, .price = 1075.5});
+  sink.OnOrderFullyFilled(OrderFullyFilled{.order_id = 1, .symbol = symbol});
+  sink.OnOrderPartiallyFilled(
+      OrderPartiallyFilled{.order_id = 2, .remaining = 3});
+  sink.OnDepthUpdate(DepthUpdate{
+      .side = Side::kSell, .price = 1234567.25, .qty = 4, .num_orders = 1});
+  sink.OnBboUpdate(Bbo{.bid = {.price = 1000, .qty = 5, .num_orders = 2}});
+}
+
+TEST(BufferedBinarySink, DecodesToText) {
+  std::ostringstream text;
+  {
+    BufferedTextSink sink(text);
+    PublishAll(sink);
+  }
+  std::ostringstream binary;
+  {
+    BufferedBinarySink sink(binary);
+    PublishAll(sink);
+    PublishAll(sink);
+    EXPECT_EQ(sink.sequence(), 10);
+  }
+
+  std::istringstream is(binary.str());
+  std::ostringstream os;
+  std::ostringstream es;
+  EXPECT_TRUE(DecodeBinaryEvents(is, os, es));
+  EXPECT_EQ(os.str(), text.str() + text.str());
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST(BufferedBinarySink, FlushThreshold) {
+  std::ostringstream os;
+  BufferedBinarySink sink(os, /*flush_threshold=*/kBinaryTradeEventSize + 1);
+  sink.OnTradeEvent(TradeEvent{.qty = 1, .price = 1});
+  EXPECT_EQ(os.str().size(), 0);
+  sink.OnTradeEvent(TradeEvent{.qty = 1, .price = 1});
+  EXPECT_EQ(os.str().size(), 2 * kBinaryTradeEventSize);
+}
+
+TEST(DecodeBinaryEvents, SequenceGap) {
+  std::string input;
+  char buf[kMaxBinaryEventSize];
+  input.append(buf, EncodeBinary(OrderFullyFilled{.order_id = 1}, 1, buf));
+  input.append(buf, EncodeBinary(OrderFullyFilled{.order_id = 2}, 4, buf));
+  input.append(buf, EncodeBinary(OrderFullyFilled{.order_id = 3}, 5, buf));
+
+  std::istringstream is(input);
+  std::ostringstream os;
+  std::ostringstream es;
+  EXPECT_TRUE(DecodeBinaryEvents(is, os, es));
+  EXPECT_EQ(os.str(), "3,1\n3,2\n3,3\n");
+  EXPECT_EQ(es.str(), "Sequence gap: expected 2, got 4\n");
+}
+
+TEST(DecodeBinaryEvents, Truncated) {
+  char buf[kMaxBinaryEventSize];
+  std::string input(buf, EncodeBinary(OrderFullyFilled{.order_id = 1}, 1, buf));
+  for (size_t size : {size_t{2}, input.size() - 1}) {
+    std::istringstream is(input + input.substr(0, size));
+    std::ostringstream os;
+    std::ostringstream es;
+    EXPECT_FALSE(DecodeBinaryEvents(is, os, es));
+    EXPECT_EQ(os.str(), "3,1\n");
+    EXPECT_EQ(es.str(), "Truncated binary event\n");
+  }
+}
+
+TEST(CallbackEventSink, ForwardsEvents) {
+  std::vector<OutputEvent> events;
+  CallbackEventSink sink(
+      [&events](const OutputEvent& event) { events.push_back(event); });
+  sink.OnTradeEvent(TradeEvent{.qty = 2, .price = 1000});
+  sink.OnOrderFullyFilled(OrderFullyFilled{.order_id = 1});
+  sink.OnOrderPartiallyFilled(
+      OrderPartiallyFilled{.order_id = 2, .remaining = 3});
+  sink.OnDepthUpdate(DepthUpdate{.side = Side::kSell, .qty = 4});
+  sink.Flush();
+
+  ASSERT_EQ(events.size(), 4);
+  EXPECT_EQ(std::get<TradeEvent>(events[0]).qty, 2);
+  EXPECT_EQ(std::get<TradeEvent>(events[0]).price, 1000);
+  EXPECT_EQ(std::get<OrderFullyFilled>(events[1]).order_id, 1);
+  EXPECT_EQ(std::get<OrderPartiallyFilled>(events[2]).order_id, 2);
+  EXPECT_EQ(std::get<OrderPartiallyFilled>(events[2]).remaining, 3);
+  EXPECT_EQ(std::get<DepthUpdate>(events[3]).qty, 4);
+}
+
+}  // namespace mukhi::matching_engine
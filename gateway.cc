@@ -0,0 +1,475 @@
+#include "gateway.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace mukhi::matching_engine {
+
+namespace {
+// Bytes read from a socket at a time. Sessions are read from in turns of this
+// many bytes, so that a busy client can't starve the others.
+constexpr size_t kReadSize = 64 << 10;
+// A text line that doesn't end within this many bytes is ill-formed.
+constexpr size_t kMaxLineSize = 4096;
+constexpr int kMaxReadyEvents = 64;
+}  // namespace
+
+struct Gateway::Session {
+  uint64_t id;
+  int fd;
+  // Unknown until the client sends its first byte.
+  std::optional<OutputFormat> format = std::nullopt;
+  // Received, but not yet processed, bytes.
+  std::string in = {};
+  // Bytes to send, from `out_start` on.
+  std::string out = {};
+  size_t out_start = 0;
+  // Sequence number of the last binary event sent.
+  uint64_t sequence = 0;
+  // The client is done sending, the session is closed once its output is
+  // written.
+  bool eof = false;
+  // Its output went past `GatewayOptions::max_pending_output`.
+  bool overflowed = false;
+  bool dirty = false;
+  // Interest registered with epoll.
+  uint32_t interest = EPOLLIN;
+
+  size_t pending_output() const { return out.size() - out_start; }
+};
+
+/*
+Sends the events of the book to the sessions they're for. Fills go to the owner
+of the order filled, trades to the session of the request being processed and
+to the owner of the resting order, whose fill follows the trade.
+*/
+class Gateway::RoutingSink : public EventSink {
+ public:
+  explicit RoutingSink(Gateway& gateway) : gateway_(gateway) {}
+
+  // Sets the session of the request about to be processed.
+  void set_session(uint64_t id) {
+    session_ = id;
+    trade_.reset();
+  }
+
+  void OnTradeEvent(const TradeEvent& event) override {
+    trade_ = event;
+    traded_with_ = session_;
+    Send(session_, event);
+  }
+  void OnOrderFullyFilled(const OrderFullyFilled& event) override {
+    auto itr = gateway_.owners_.find(event.order_id);
+    if (itr == gateway_.owners_.end()) return;
+    uint64_t owner = itr->second;
+    gateway_.owners_.erase(itr);
+    SendFill(owner, event);
+  }
+  void OnOrderPartiallyFilled(const OrderPartiallyFilled& event) override {
+    auto itr = gateway_.owners_.find(event.order_id);
+    if (itr == gateway_.owners_.end()) return;
+    SendFill(itr->second, event);
+  }
+  // Market data goes to everyone.
+  void OnDepthUpdate(const DepthUpdate& event) override { Broadcast(event); }
+  void OnBboUpdate(const Bbo& event) override { Broadcast(event); }
+
+ private:
+  template <typename Event>
+  void SendFill(uint64_t owner, const Event& event) {
+    if (trade_.has_value() && owner != traded_with_) {
+      Send(owner, *trade_);
+      traded_with_ = owner;
+    }
+    Send(owner, event);
+  }
+
+  template <typename Event>
+  void Broadcast(const Event& event) {
+    for (auto& [id, session] : gateway_.sessions_) Send(*session, event);
+  }
+
+  template <typename Event>
+  void Send(uint64_t id, const Event& event) {
+    auto itr = gateway_.sessions_.find(id);
+    if (itr != gateway_.sessions_.end()) Send(*itr->second, event);
+  }
+
+  template <typename Event>
+  void Send(Session& session, const Event& event) {
+    if (session.overflowed) return;
+    if (session.format == OutputFormat::kBinary) {
+      char frame[kMaxBinaryEventSize];
+      session.out.append(frame,
+                         EncodeBinary(event, ++session.sequence, frame));
+    } else {
+      char line[kMaxTextEventSize + 1];
+      size_t size = FormatText(event, line);
+      line[size++] = '\n';
+      session.out.append(line, size);
+    }
+    if (session.pending_output() > gateway_.options_.max_pending_output) {
+      session.overflowed = true;
+    }
+    gateway_.MarkDirty(session);
+  }
+
+  Gateway& gateway_;
+  uint64_t session_ = 0;
+  // The last trade of the request being processed, and the last session it
+  // was sent to.
+  std::optional<TradeEvent> trade_;
+  uint64_t traded_with_ = 0;
+};
+
+Gateway::Gateway(std::ostream& es, const GatewayOptions& options)
+    : es_(es),
+      options_(options),
+      sink_(std::make_unique<RoutingSink>(*this)),
+      book_(*sink_, errors_, options.order_book) {}
+
+Gateway::~Gateway() {
+  for (auto& [id, session] : sessions_) ::close(session->fd);
+  for (int fd : {unix_listener_fd_, tcp_listener_fd_, stop_fd_, epoll_fd_}) {
+    if (fd >= 0) ::close(fd);
+  }
+  if (unix_listener_fd_ >= 0) ::unlink(options_.unix_socket_path.c_str());
+}
+
+bool Gateway::Listen() {
+  if (options_.unix_socket_path.empty() && !options_.tcp_port.has_value()) {
+    es_ << "Neither a Unix-domain socket nor a TCP port to listen on"
+        << std::endl;
+    return false;
+  }
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epoll_fd_ < 0 || stop_fd_ < 0) {
+    es_ << "Unable to create the event loop : " << std::strerror(errno)
+        << std::endl;
+    return false;
+  }
+  epoll_event event{.events = EPOLLIN, .data = {.u64 = kStopId}};
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd_, &event);
+
+  if (!options_.unix_socket_path.empty()) {
+    const std::string& path = options_.unix_socket_path;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+      es_ << "Unix-domain socket path too long : " << path << std::endl;
+      return false;
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    ::unlink(path.c_str());
+    unix_listener_fd_ =
+        ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (unix_listener_fd_ < 0 ||
+        ::bind(unix_listener_fd_, reinterpret_cast<sockaddr*>(&addr),
+               sizeof(addr)) != 0 ||
+        !ListenOn(unix_listener_fd_, kUnixListenerId)) {
+      es_ << "Unable to listen on " << path << " : " << std::strerror(errno)
+          << std::endl;
+      return false;
+    }
+  }
+
+  if (options_.tcp_port.has_value()) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(*options_.tcp_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(addr);
+    int reuse = 1;
+    tcp_listener_fd_ =
+        ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (tcp_listener_fd_ < 0 ||
+        ::setsockopt(tcp_listener_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse,
+                     sizeof(reuse)) != 0 ||
+        ::bind(tcp_listener_fd_, reinterpret_cast<sockaddr*>(&addr),
+               sizeof(addr)) != 0 ||
+        !ListenOn(tcp_listener_fd_, kTcpListenerId) ||
+        ::getsockname(tcp_listener_fd_, reinterpret_cast<sockaddr*>(&addr),
+                      &size) != 0) {
+      es_ << "Unable to listen on TCP port " << *options_.tcp_port << " : "
+          << std::strerror(errno) << std::endl;
+      return false;
+    }
+    tcp_port_ = ntohs(addr.sin_port);
+  }
+  return true;
+}
+
+bool Gateway::ListenOn(int fd, uint64_t id) {
+  if (::listen(fd, SOMAXCONN) != 0) return false;
+  epoll_event event{.events = EPOLLIN, .data = {.u64 = id}};
+  return ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+void Gateway::Run() {
+  epoll_event events[kMaxReadyEvents];
+  bool running = true;
+  while (running) {
+    int n = ::epoll_wait(epoll_fd_, events, kMaxReadyEvents, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      es_ << "Event loop failed : " << std::strerror(errno) << std::endl;
+      return;
+    }
+    for (int i = 0; i < n; ++i) {
+      uint64_t id = events[i].data.u64;
+      if (id == kStopId) {
+        running = false;
+      } else if (id == kUnixListenerId) {
+        Accept(unix_listener_fd_);
+      } else if (id == kTcpListenerId) {
+        Accept(tcp_listener_fd_);
+      } else if (auto itr = sessions_.find(id); itr != sessions_.end()) {
+        // The session may have been closed by an earlier event of the batch.
+        Session& session = *itr->second;
+        bool open = true;
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+          open = Read(session);
+        }
+        if (open && (events[i].events & EPOLLOUT)) open = Write(session);
+        if (!open) Close(session);
+      }
+    }
+    WriteAll();
+  }
+}
+
+void Gateway::Stop() {
+  uint64_t one = 1;
+  // Only fails if the counter would overflow, i.e. it's already set.
+  [[maybe_unused]] ssize_t result = ::write(stop_fd_, &one, sizeof(one));
+}
+
+void Gateway::Accept(int listener_fd) {
+  while (true) {
+    int fd = ::accept4(listener_fd, nullptr, nullptr,
+                       SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        es_ << "Unable to accept a session : " << std::strerror(errno)
+            << std::endl;
+      }
+      return;
+    }
+    if (listener_fd == tcp_listener_fd_) {
+      // Events are small and latency sensitive.
+      int one = 1;
+      ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    uint64_t id = next_session_id_++;
+    epoll_event event{.events = EPOLLIN, .data = {.u64 = id}};
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+      es_ << "Unable to accept a session : " << std::strerror(errno)
+          << std::endl;
+      ::close(fd);
+      continue;
+    }
+    sessions_.emplace(id, std::make_unique<Session>(Session{.id = id,
+                                                            .fd = fd}));
+  }
+}
+
+bool Gateway::Read(Session& session) {
+  size_t size = session.in.size();
+  session.in.resize(size + kReadSize);
+  ssize_t n;
+  do {
+    n = ::read(session.fd, session.in.data() + size, kReadSize);
+  } while (n < 0 && errno == EINTR);
+  session.in.resize(size + std::max<ssize_t>(n, 0));
+  if (n < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+    es_ << "Session " << session.id << ": unable to read : "
+        << std::strerror(errno) << std::endl;
+    return false;
+  }
+  if (n == 0) {
+    session.eof = true;
+    // A last line without a new line ends with the input.
+    if (session.format == OutputFormat::kText && !session.in.empty()) {
+      session.in.push_back('\n');
+    }
+  }
+  if (!session.format.has_value() && !session.in.empty()) {
+    session.format = static_cast<uint8_t>(session.in[0]) == kBinaryMagic
+                         ? OutputFormat::kBinary
+                         : OutputFormat::kText;
+  }
+  if (!ProcessInput(session)) return false;
+  if (session.eof) {
+    if (session.format == OutputFormat::kBinary && !session.in.empty()) {
+      es_ << "Session " << session.id << ": Bad message: Truncated binary "
+          << "message" << std::endl;
+    }
+    // Stop reading, and close once the output is written.
+    MarkDirty(session);
+  }
+  return true;
+}
+
+bool Gateway::ProcessInput(Session& session) {
+  std::string_view in = session.in;
+  size_t pos = 0;
+  while (pos < in.size()) {
+    if (session.format == OutputFormat::kBinary) {
+      if (in.size() - pos < kBinaryHeaderSize) break;
+      size_t length = BinaryMessageLength(in.data() + pos);
+      if (length == 0) {
+        // Frame boundaries are lost.
+        errors_ << "Bad message: Corrupt binary message header" << std::endl;
+        ReportErrors(session);
+        return false;
+      }
+      if (in.size() - pos < length) break;
+      std::optional<InputMessage> msg =
+          ParseBinary(in.substr(pos, length), errors_);
+      pos += length;
+      if (msg.has_value()) {
+        std::visit([&](const auto& req) { Process(session, req); }, *msg);
+      }
+    } else {
+      size_t end = in.find('\n', pos);
+      if (end == std::string_view::npos) {
+        if (in.size() - pos > kMaxLineSize) {
+          errors_ << "Bad message: Line too long" << std::endl;
+          ReportErrors(session);
+          return false;
+        }
+        break;
+      }
+      std::optional<InputMessage> msg =
+          parse(in.substr(pos, end - pos), errors_);
+      pos = end + 1;
+      if (msg.has_value()) {
+        std::visit([&](const auto& req) { Process(session, req); }, *msg);
+      }
+    }
+    ReportErrors(session);
+  }
+  session.in.erase(0, pos);
+  return true;
+}
+
+template <typename Request>
+void Gateway::Process(Session& session, const Request& req) {
+  bool owned = false;
+  if constexpr (std::is_same_v<Request, AddOrderRequest>) {
+    // A repeated order id is rejected by the book, and the order keeps its
+    // owner.
+    owned = owners_.emplace(req.order_id, session.id).second;
+  } else {
+    if (!CheckOwner(session, req.order_id)) return;
+    owned = true;
+  }
+  sink_->set_session(session.id);
+  book_.ProcessOrder(req);
+  // Forget the owners of orders that didn't stay in the book.
+  if (owned && !book_.Contains(req.order_id)) owners_.erase(req.order_id);
+}
+
+bool Gateway::CheckOwner(Session& session, OrderId id) {
+  auto itr = owners_.find(id);
+  if (itr == owners_.end() || itr->second == session.id) return true;
+  // Same as for an unknown order, so that sessions can't probe the orders of
+  // others.
+  errors_ << "No such order with id: " << id << std::endl;
+  return false;
+}
+
+void Gateway::ReportErrors(Session& session) {
+  std::string errors = errors_.str();
+  if (errors.empty()) return;
+  errors_.str("");
+  std::string_view rest = errors;
+  while (!rest.empty()) {
+    size_t end = rest.find('\n');
+    es_ << "Session " << session.id << ": " << rest.substr(0, end)
+        << std::endl;
+    rest.remove_prefix(std::min(end + 1, rest.size()));
+  }
+  if (session.format != OutputFormat::kBinary) {
+    session.out += errors;
+    MarkDirty(session);
+  }
+}
+
+void Gateway::MarkDirty(Session& session) {
+  if (session.dirty) return;
+  session.dirty = true;
+  dirty_.push_back(session.id);
+}
+
+bool Gateway::Write(Session& session) {
+  while (session.pending_output() > 0) {
+    ssize_t n = ::send(session.fd, session.out.data() + session.out_start,
+                       session.pending_output(), MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      es_ << "Session " << session.id << ": unable to write : "
+          << std::strerror(errno) << std::endl;
+      return false;
+    }
+    session.out_start += n;
+  }
+  if (session.pending_output() == 0) {
+    session.out.clear();
+    session.out_start = 0;
+    if (session.eof) return false;
+  }
+  // Wait for room in the socket while output is pending, and stop reading
+  // once the client is done sending.
+  uint32_t interest =
+      (session.eof ? 0 : static_cast<uint32_t>(EPOLLIN)) |
+      (session.pending_output() > 0 ? static_cast<uint32_t>(EPOLLOUT) : 0);
+  if (interest != session.interest) {
+    session.interest = interest;
+    epoll_event event{.events = interest, .data = {.u64 = session.id}};
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, session.fd, &event);
+  }
+  return true;
+}
+
+void Gateway::WriteAll() {
+  std::vector<uint64_t> dirty;
+  dirty.swap(dirty_);
+  for (uint64_t id : dirty) {
+    auto itr = sessions_.find(id);
+    if (itr == sessions_.end()) continue;
+    Session& session = *itr->second;
+    session.dirty = false;
+    if (session.overflowed) {
+      es_ << "Session " << id << ": too much output pending, disconnecting"
+          << std::endl;
+      Close(session);
+    } else if (!Write(session)) {
+      Close(session);
+    }
+  }
+}
+
+void Gateway::Close(Session& session) {
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, session.fd, nullptr);
+  ::close(session.fd);
+  sessions_.erase(session.id);
+}
+
+}  // namespace mukhi::matching_engine
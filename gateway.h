@@ -0,0 +1,145 @@
+#ifndef MATCHING_ENGINE_GATEWAY_H
+#define MATCHING_ENGINE_GATEWAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "event_sink.h"
+#include "messages.h"
+#include "order_book.h"
+
+namespace mukhi::matching_engine {
+
+struct GatewayOptions {
+  // Listens on a Unix-domain socket at this path, if not empty. A file left
+  // there by a previous run is replaced.
+  std::string unix_socket_path;
+  // Listens on this TCP port of the loopback interface, if set. Port 0 picks a
+  // free port, see `Gateway::tcp_port`.
+  std::optional<uint16_t> tcp_port;
+  OrderBookOptions order_book;
+  // A session whose events pile up past this many bytes, because its client
+  // doesn't read them, is disconnected.
+  size_t max_pending_output = 64 << 20;
+};
+
+/*
+Serves many order entry clients at once over Unix-domain and loopback TCP
+sockets, in front of a single order book.
+
+Every connection is a session. The format of a session is detected from the
+first byte its client sends, like `InputFormat::kAuto`: text lines or binary
+frames, see `parse` and `ParseBinary`. Events are sent back in the same format,
+numbered per session in binary.
+
+Requests are processed in the order they're read, on the thread running the
+event loop, which is a non-blocking `epoll` loop with a read and a write buffer
+per session. A session owns the orders it added: it's the only one that can
+cancel or modify them, and it receives their fills. A trade is sent to the
+sessions of both orders that traded, before their fills. Depth and BBO updates,
+if enabled, are sent to all sessions. Errors are sent back to text sessions, and
+written to `es`, along with the session they come from, for all sessions.
+
+Orders stay in the book when their session disconnects, and their fills are
+then dropped.
+
+This class is not thread-safe, except for `Stop`.
+*/
+class Gateway {
+ public:
+  explicit Gateway(std::ostream& es, const GatewayOptions& options = {});
+  ~Gateway();
+
+  Gateway(const Gateway&) = delete;
+  Gateway& operator=(const Gateway&) = delete;
+
+  /**
+  Opens the listening sockets. Returns false after reporting why on `es` if
+  one can't be opened, or if neither is configured. Must be called before
+  `Run`.
+  */
+  bool Listen();
+
+  // The TCP port listened on, once `Listen` succeeded, or 0 if none is.
+  uint16_t tcp_port() const { return tcp_port_; }
+
+  /**
+  Runs the event loop: accepts sessions, processes their requests and sends
+  them their events, until `Stop` is called.
+
+  This is a blocking call.
+  */
+  void Run();
+
+  // Makes `Run` return. May be called from any thread, or a signal handler.
+  void Stop();
+
+  const OrderBook& book() const { return book_; }
+
+ private:
+  struct Session;
+  class RoutingSink;
+
+  // Ids of the sources of readiness events in the epoll set, sessions have
+  // ids from `kFirstSessionId` on.
+  static constexpr uint64_t kUnixListenerId = 0;
+  static constexpr uint64_t kTcpListenerId = 1;
+  static constexpr uint64_t kStopId = 2;
+  static constexpr uint64_t kFirstSessionId = 16;
+
+  // Listens on the bound socket `fd`, whose readiness events carry `id`.
+  bool ListenOn(int fd, uint64_t id);
+  void Accept(int listener_fd);
+  // Reads what the client of `session` sent and processes the messages
+  // complete so far. Returns false if the session must be closed.
+  bool Read(Session& session);
+  // Processes the complete messages at the front of the read buffer.
+  bool ProcessInput(Session& session);
+  template <typename Request>
+  void Process(Session& session, const Request& req);
+  // Returns false if `session` can't modify or cancel the order `id`, after
+  // reporting it.
+  bool CheckOwner(Session& session, OrderId id);
+  // Sends the errors of the last message to `session`, and to `es_`.
+  void ReportErrors(Session& session);
+  // Queues `session` for `WriteAll`.
+  void MarkDirty(Session& session);
+  // Writes as much of the output of `session` as its socket takes. Returns
+  // false if the session must be closed.
+  bool Write(Session& session);
+  // Writes the output of all the sessions that have some.
+  void WriteAll();
+  void Close(Session& session);
+
+  std::ostream& es_;
+  const GatewayOptions options_;
+  std::unique_ptr<RoutingSink> sink_;
+  // Errors of the message being processed.
+  std::ostringstream errors_;
+  OrderBook book_;
+
+  int epoll_fd_ = -1;
+  int stop_fd_ = -1;
+  int unix_listener_fd_ = -1;
+  int tcp_listener_fd_ = -1;
+  uint16_t tcp_port_ = 0;
+
+  uint64_t next_session_id_ = kFirstSessionId;
+  std::unordered_map<uint64_t, std::unique_ptr<Session>> sessions_;
+  // Sessions with output waiting to be written.
+  std::vector<uint64_t> dirty_;
+  // The session each resting order was added by.
+  std::unordered_map<OrderId, uint64_t> owners_;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_GATEWAY_H
@@ -0,0 +1,86 @@
+// Serves order entry clients over sockets, in front of a single order book,
+// e.g.:
+//
+// $ bazel-bin/gateway --unix_socket=/tmp/orders.sock --tcp_port=9000 &
+// $ printf '0,1,0,10,100\n' | nc -U /tmp/orders.sock
+//
+// Each client gets the events of its own orders, in the format it sends its
+// requests in. Runs until SIGINT or SIGTERM.
+
+#include <signal.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "gateway.h"
+
+namespace {
+
+constexpr char kUsage[] = R"(Flags:
+  --unix_socket=PATH  Listens on a Unix-domain socket at PATH.
+  --tcp_port=N        Listens on TCP port N of the loopback interface, 0 picks
+                      a free port.
+  --depth_updates     Sends depth updates to all clients.
+  --bbo_updates       Sends BBO updates to all clients.
+)";
+
+// Parses `--<name>=<value>` and returns the value, or nullptr if `arg` is not
+// `name`.
+const char* FlagValue(std::string_view arg, std::string_view name) {
+  if (arg.substr(0, 2) != "--" || arg.substr(2, name.size()) != name ||
+      arg.substr(2 + name.size(), 1) != "=") {
+    return nullptr;
+  }
+  return arg.data() + 3 + name.size();
+}
+
+mukhi::matching_engine::Gateway* gateway = nullptr;
+
+void StopGateway(int) { gateway->Stop(); }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  mukhi::matching_engine::GatewayOptions options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg(argv[i]);
+    const char* v;
+    if (arg == "--help") {
+      std::cout << kUsage;
+      return 0;
+    } else if ((v = FlagValue(arg, "unix_socket"))) {
+      options.unix_socket_path = v;
+    } else if ((v = FlagValue(arg, "tcp_port"))) {
+      char* end;
+      unsigned long port = std::strtoul(v, &end, 10);
+      if (*v == '\0' || *end != '\0' || port > 65535) {
+        std::cerr << "--tcp_port must be a port number." << std::endl;
+        return 1;
+      }
+      options.tcp_port = port;
+    } else if (arg == "--depth_updates") {
+      options.order_book.publish_depth_updates = true;
+    } else if (arg == "--bbo_updates") {
+      options.order_book.publish_bbo_updates = true;
+    } else {
+      std::cerr << "Unknown flag: " << arg << std::endl << kUsage;
+      return 1;
+    }
+  }
+
+  mukhi::matching_engine::Gateway gw(std::cerr, options);
+  if (!gw.Listen()) return 1;
+  gateway = &gw;
+  signal(SIGINT, StopGateway);
+  signal(SIGTERM, StopGateway);
+  if (!options.unix_socket_path.empty()) {
+    std::cerr << "Listening on " << options.unix_socket_path << std::endl;
+  }
+  if (options.tcp_port.has_value()) {
+    std::cerr << "Listening on 127.0.0.1:" << gw.tcp_port() << std::endl;
+  }
+  gw.Run();
+  return 0;
+}
@@ -0,0 +1,249 @@
+#include "gateway.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mukhi::matching_engine {
+
+namespace fs = std::filesystem;
+
+// A blocking client socket, whose reads give up after a few seconds.
+class Client {
+ public:
+  static Client Unix(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return Client(AF_UNIX, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  }
+  static Client Tcp(uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return Client(AF_INET, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  }
+
+  Client(Client&& other) : fd_(other.fd_) { other.fd_ = -1; }
+  ~Client() {
+    if (fd_ >= 0) ::close(fd_);
+  }
+
+  void Send(std::string_view data) {
+    ASSERT_EQ(::write(fd_, data.data(), data.size()),
+              static_cast<ssize_t>(data.size()));
+  }
+  void Send(const InputMessage& msg) {
+    char frame[kMaxBinaryMessageSize];
+    Send(std::string_view(frame, EncodeBinary(msg, frame)));
+  }
+
+  // Reads exactly `n` bytes, or what came before the timeout.
+  std::string Read(size_t n) {
+    std::string data(n, '\0');
+    size_t size = 0;
+    while (size < n) {
+      ssize_t r = ::read(fd_, data.data() + size, n - size);
+      if (r <= 0) break;
+      size += r;
+    }
+    data.resize(size);
+    return data;
+  }
+  // Reads `n` lines, or what came before the timeout.
+  std::string ReadLines(size_t n) {
+    std::string data;
+    char c;
+    while (n > 0 && ::read(fd_, &c, 1) == 1) {
+      data.push_back(c);
+      if (c == '\n') --n;
+    }
+    return data;
+  }
+
+  // Waits for the gateway to process what was sent so far, by sending a
+  // cancel it rejects.
+  void Sync() {
+    Send("1,999999\n");
+    EXPECT_EQ(ReadLines(1), "No such order with id: 999999\n");
+  }
+
+  void ShutdownWrite() { ::shutdown(fd_, SHUT_WR); }
+
+ private:
+  Client(int domain, const sockaddr* addr, socklen_t size)
+      : fd_(::socket(domain, SOCK_STREAM, 0)) {
+    timeval timeout{.tv_sec = 5};
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    EXPECT_EQ(::connect(fd_, addr, size), 0) << std::strerror(errno);
+  }
+
+  int fd_;
+};
+
+// Runs a gateway on a thread of its own, listening on a Unix-domain socket.
+class GatewayTest : public testing::Test {
+ protected:
+  void Start(GatewayOptions options = {}) {
+    fs::path dir = fs::temp_directory_path() / "gateway_test";
+    fs::create_directories(dir);
+    path_ = dir / testing::UnitTest::GetInstance()->current_test_info()->name();
+    options.unix_socket_path = path_;
+    gateway_ = std::make_unique<Gateway>(es_, options);
+    ASSERT_TRUE(gateway_->Listen()) << es_.str();
+    thread_ = std::thread([this] { gateway_->Run(); });
+  }
+
+  void TearDown() override {
+    if (gateway_ == nullptr) return;
+    gateway_->Stop();
+    thread_.join();
+    gateway_.reset();
+    // The socket file is removed with the gateway.
+    EXPECT_FALSE(fs::exists(path_));
+  }
+
+  std::string path_;
+  std::ostringstream es_;
+  std::unique_ptr<Gateway> gateway_;
+  std::thread thread_;
+};
+
+TEST_F(GatewayTest, RoutesFillsToOwners) {
+  Start();
+  Client seller = Client::Unix(path_);
+  Client buyer = Client::Unix(path_);
+  seller.Send("0,1,1,10,100.5\n");
+  seller.Sync();
+  buyer.Send("0,2,0,4,101\n");
+  // The trade goes to both, followed by the fill of their own order.
+  EXPECT_EQ(buyer.ReadLines(2), "2,4,100.5\n3,2\n");
+  EXPECT_EQ(seller.ReadLines(2), "2,4,100.5\n4,1,6\n");
+
+  // Only the seller can cancel its order.
+  buyer.Send("1,1\n");
+  EXPECT_EQ(buyer.ReadLines(1), "No such order with id: 1\n");
+  seller.Send("1,1\n");
+  seller.Sync();
+  buyer.Sync();
+  EXPECT_FALSE(gateway_->book().Contains(1));
+}
+
+TEST_F(GatewayTest, TradesWithManyRestingOrders) {
+  Start();
+  Client a = Client::Unix(path_);
+  Client b = Client::Unix(path_);
+  Client c = Client::Unix(path_);
+  a.Send("0,1,1,3,100\n0,2,1,3,101\n");
+  a.Sync();
+  b.Send("0,3,1,3,100\n");
+  b.Sync();
+  c.Send("0,4,0,8,101\n");
+  EXPECT_EQ(c.ReadLines(6), "2,3,100\n4,4,5\n2,3,100\n4,4,2\n2,2,101\n3,4\n");
+  EXPECT_EQ(a.ReadLines(4), "2,3,100\n3,1\n2,2,101\n4,2,1\n");
+  EXPECT_EQ(b.ReadLines(2), "2,3,100\n3,3\n");
+}
+
+TEST_F(GatewayTest, OrdersOutliveTheirSession) {
+  Start();
+  {
+    Client seller = Client::Unix(path_);
+    seller.Send("0,1,1,10,100\n");
+    seller.Sync();
+  }
+  Client buyer = Client::Unix(path_);
+  buyer.Send("0,2,0,10,100\n");
+  EXPECT_EQ(buyer.ReadLines(2), "2,10,100\n3,2\n");
+}
+
+TEST_F(GatewayTest, BinarySession) {
+  Start();
+  Client seller = Client::Unix(path_);
+  Client buyer = Client::Unix(path_);
+  seller.Send("0,1,1,10,100\n");
+  seller.Sync();
+  buyer.Send(AddOrderRequest{
+      .order_id = 2, .side = Side::kBuy, .qty = 10, .price = 100});
+  std::ostringstream es;
+  std::optional<SequencedEvent> trade =
+      ParseBinaryEvent(buyer.Read(kBinaryTradeEventSize), es);
+  ASSERT_TRUE(trade.has_value()) << es.str();
+  EXPECT_EQ(trade->sequence, 1);
+  ASSERT_TRUE(std::holds_alternative<TradeEvent>(trade->event));
+  EXPECT_EQ(std::get<TradeEvent>(trade->event).qty, 10);
+  std::optional<SequencedEvent> fill =
+      ParseBinaryEvent(buyer.Read(kBinaryOrderFullyFilledSize), es);
+  ASSERT_TRUE(fill.has_value()) << es.str();
+  EXPECT_EQ(fill->sequence, 2);
+  ASSERT_TRUE(std::holds_alternative<OrderFullyFilled>(fill->event));
+  EXPECT_EQ(std::get<OrderFullyFilled>(fill->event).order_id, 2);
+  EXPECT_EQ(seller.ReadLines(2), "2,10,100\n3,1\n");
+}
+
+TEST_F(GatewayTest, BroadcastsDepthUpdates) {
+  Start({.order_book = {.publish_depth_updates = true}});
+  Client a = Client::Unix(path_);
+  Client b = Client::Unix(path_);
+  b.Sync();
+  a.Send("0,1,0,10,100\n");
+  EXPECT_EQ(a.ReadLines(1), b.ReadLines(1));
+}
+
+TEST_F(GatewayTest, LastLineWithoutNewLine) {
+  Start();
+  Client a = Client::Unix(path_);
+  a.Send("1,7");
+  a.ShutdownWrite();
+  // The session is closed once its output is written.
+  EXPECT_EQ(a.Read(100), "No such order with id: 7\n");
+}
+
+TEST_F(GatewayTest, CorruptBinaryHeaderClosesSession) {
+  Start();
+  Client a = Client::Unix(path_);
+  a.Send(CancelOrderRequest{.order_id = 7});
+  a.Send(std::string(kBinaryHeaderSize, 'x'));
+  EXPECT_EQ(a.Read(100), "");
+  gateway_->Stop();
+  thread_.join();
+  gateway_.reset();
+  EXPECT_NE(es_.str().find("Corrupt binary message header"),
+            std::string::npos)
+      << es_.str();
+}
+
+TEST(Gateway, ListensOnTcp) {
+  std::ostringstream es;
+  Gateway gateway(es, {.tcp_port = 0});
+  ASSERT_TRUE(gateway.Listen()) << es.str();
+  ASSERT_NE(gateway.tcp_port(), 0);
+  std::thread thread([&] { gateway.Run(); });
+  {
+    Client client = Client::Tcp(gateway.tcp_port());
+    client.Sync();
+  }
+  gateway.Stop();
+  thread.join();
+}
+
+TEST(Gateway, NothingToListenOn) {
+  std::ostringstream es;
+  Gateway gateway(es);
+  EXPECT_FALSE(gateway.Listen());
+  EXPECT_EQ(es.str(),
+            "Neither a Unix-domain socket nor a TCP port to listen on\n");
+}
+
+}  // namespace mukhi::matching_engine
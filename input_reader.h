@@ -0,0 +1,273 @@
+#ifndef MATCHING_ENGINE_INPUT_READER_H
+#define MATCHING_ENGINE_INPUT_READER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "batch_parser.h"
+#include "messages.h"
+#include "shm_transport.h"
+#include "spsc_ring.h"
+
+namespace mukhi::matching_engine {
+
+enum class InputFormat : uint8_t {
+  // Detected from the first byte of the input stream.
+  kAuto = 0,
+  // Lines of comma separated values, see `parse`.
+  kText = 1,
+  // Fixed-width binary messages, see `ParseBinary`.
+  kBinary = 2,
+};
+
+// Returns `format`, or the format detected from the first byte of the input
+// for `InputFormat::kAuto`.
+inline InputFormat ResolveInputFormat(InputFormat format, char first) {
+  if (format != InputFormat::kAuto) return format;
+  return static_cast<uint8_t>(first) == kBinaryMagic ? InputFormat::kBinary
+                                                     : InputFormat::kText;
+}
+
+/*
+Readers of the input formats, shared by the engines.
+
+The messages read are handed to a target, along with the errors found while
+reading them. Targets provide:
+
+* `std::ostream& errors()`, where errors are written.
+* `void CommitErrors()`, called after writing errors and before the message
+  read along with them, if any, is delivered.
+* `void DeliverBatch(const InputMessage* msgs, size_t n)`, with the messages
+  read, in order.
+* `void Idle()`, called when reading more input might block.
+
+Messages are read ahead of delivering them, as long as more input is available
+without blocking, and delivered in batches. Errors are only written once all
+the messages read before them have been delivered, so that they're reported in
+the same order as when processing messages one at a time.
+*/
+
+// Number of messages read ahead of delivering them.
+constexpr size_t kReadAheadSize = 64;
+
+// Holds the messages read ahead until they're delivered to `Target`.
+template <typename Target>
+class ReadAheadBuffer {
+ public:
+  explicit ReadAheadBuffer(Target& target) : target_(target) {}
+
+  void Push(const InputMessage& msg) {
+    msgs_[size_++] = msg;
+    if (size_ == kReadAheadSize) Deliver();
+  }
+  void Deliver() {
+    if (size_ == 0) return;
+    target_.DeliverBatch(msgs_, size_);
+    size_ = 0;
+  }
+
+ private:
+  Target& target_;
+  InputMessage msgs_[kReadAheadSize];
+  size_t size_ = 0;
+};
+
+// Processes the lines of `is` until EOF.
+template <typename Target>
+void ReadText(std::istream& is, Target& target) {
+  ReadAheadBuffer<Target> read_ahead(target);
+  // Lines are parsed without reporting errors first, and ill-formed ones again
+  // once the messages before them are delivered.
+  std::ostream no_errors(nullptr);
+  std::string line;
+  while (std::getline(is, line)) {
+    if (auto req = parse(line, no_errors); req.has_value()) {
+      read_ahead.Push(*req);
+    } else {
+      read_ahead.Deliver();
+      parse(line, target.errors());
+      target.CommitErrors();
+    }
+    if (is.rdbuf()->in_avail() <= 0) {
+      read_ahead.Deliver();
+      target.Idle();
+    }
+  }
+  read_ahead.Deliver();
+}
+
+// Processes the binary messages of `is` until EOF.
+template <typename Target>
+void ReadBinary(std::istream& is, Target& target) {
+  ReadAheadBuffer<Target> read_ahead(target);
+  std::ostream no_errors(nullptr);
+  char buf[kMaxBinaryMessageSize];
+  while (is.read(buf, kBinaryHeaderSize)) {
+    size_t length = BinaryMessageLength(buf);
+    if (length == 0 || length > kMaxBinaryMessageSize) read_ahead.Deliver();
+    if (length == 0) {
+      // There's no way to find where the next message starts.
+      target.errors() << "Bad message: Corrupt binary message header, stopping"
+                      << std::endl;
+      target.CommitErrors();
+      return;
+    }
+    if (length > kMaxBinaryMessageSize) {
+      // Skip over messages of unknown types.
+      is.ignore(length - kBinaryHeaderSize);
+      target.errors() << "Bad message: Binary message too long : " << length
+                      << std::endl;
+      target.CommitErrors();
+      continue;
+    }
+    if (!is.read(buf + kBinaryHeaderSize, length - kBinaryHeaderSize)) {
+      read_ahead.Deliver();
+      target.errors() << "Bad message: Truncated binary message" << std::endl;
+      target.CommitErrors();
+      return;
+    }
+    std::string_view frame(buf, length);
+    if (auto req = ParseBinary(frame, no_errors); req.has_value()) {
+      read_ahead.Push(*req);
+    } else {
+      read_ahead.Deliver();
+      ParseBinary(frame, target.errors());
+      target.CommitErrors();
+    }
+    if (is.rdbuf()->in_avail() <= 0) {
+      read_ahead.Deliver();
+      target.Idle();
+    }
+  }
+  read_ahead.Deliver();
+  if (is.gcount() > 0) {
+    target.errors() << "Bad message: Truncated binary message" << std::endl;
+    target.CommitErrors();
+  }
+}
+
+// Processes all the lines in `input`, which are parsed in batches.
+template <typename Target>
+void ProcessText(std::string_view input, Target& target) {
+  // Large enough to amortize the setup of a batch, small enough for the
+  // messages to stay in cache until they are processed.
+  constexpr size_t kBatchSize = 256;
+  BatchParser parser;
+  std::vector<InputMessage> batch;
+  batch.reserve(kBatchSize);
+  while (!input.empty()) {
+    input.remove_prefix(
+        parser.Parse(input, kBatchSize, batch, target.errors()));
+    target.CommitErrors();
+    if (!batch.empty()) target.DeliverBatch(batch.data(), batch.size());
+  }
+}
+
+// Processes all the binary messages in `input`.
+template <typename Target>
+void ProcessBinary(std::string_view input, Target& target) {
+  ReadAheadBuffer<Target> read_ahead(target);
+  std::ostream no_errors(nullptr);
+  while (input.size() >= kBinaryHeaderSize) {
+    size_t length = BinaryMessageLength(input.data());
+    if (length == 0 || length > kMaxBinaryMessageSize) read_ahead.Deliver();
+    if (length == 0) {
+      target.errors() << "Bad message: Corrupt binary message header, stopping"
+                      << std::endl;
+      target.CommitErrors();
+      return;
+    }
+    if (length > kMaxBinaryMessageSize) {
+      input.remove_prefix(std::min(length, input.size()));
+      target.errors() << "Bad message: Binary message too long : " << length
+                      << std::endl;
+      target.CommitErrors();
+      continue;
+    }
+    if (length > input.size()) break;
+    std::string_view frame = input.substr(0, length);
+    if (auto req = ParseBinary(frame, no_errors); req.has_value()) {
+      read_ahead.Push(*req);
+    } else {
+      read_ahead.Deliver();
+      ParseBinary(frame, target.errors());
+      target.CommitErrors();
+    }
+    input.remove_prefix(length);
+  }
+  read_ahead.Deliver();
+  if (!input.empty()) {
+    target.errors() << "Bad message: Truncated binary message" << std::endl;
+    target.CommitErrors();
+  }
+}
+
+// Processes the messages pushed to `transport` until it's closed. Waits for
+// them by spinning, see `Backoff`.
+template <typename Target>
+void PollShm(ShmTransport& transport, Target& target) {
+  ReadAheadBuffer<Target> read_ahead(target);
+  std::ostream no_errors(nullptr);
+  char frame[kMaxBinaryMessageSize];
+  Backoff backoff;
+  bool idle = false;
+  while (true) {
+    // Read before popping, so that the messages pushed before closing are
+    // seen.
+    bool closed = transport.closed();
+    size_t length = transport.TryPop(frame);
+    if (length == 0) {
+      if (closed) break;
+      if (!idle) {
+        read_ahead.Deliver();
+        target.Idle();
+        idle = true;
+        backoff = Backoff();
+      }
+      backoff.Pause();
+      continue;
+    }
+    idle = false;
+    std::string_view msg(frame, length);
+    if (auto req = ParseBinary(msg, no_errors); req.has_value()) {
+      read_ahead.Push(*req);
+    } else {
+      read_ahead.Deliver();
+      ParseBinary(msg, target.errors());
+      target.CommitErrors();
+    }
+  }
+  read_ahead.Deliver();
+}
+
+// Reads `is` until EOF, in `format`.
+template <typename Target>
+void ReadInput(std::istream& is, InputFormat format, Target& target) {
+  if (ResolveInputFormat(format, static_cast<char>(is.peek())) ==
+      InputFormat::kBinary) {
+    ReadBinary(is, target);
+  } else {
+    ReadText(is, target);
+  }
+}
+
+// Processes all of `input`, in `format`.
+template <typename Target>
+void ProcessInput(std::string_view input, InputFormat format,
+                  Target& target) {
+  if (ResolveInputFormat(format, input.empty() ? '\0' : input.front()) ==
+      InputFormat::kBinary) {
+    ProcessBinary(input, target);
+  } else {
+    ProcessText(input, target);
+  }
+}
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_INPUT_READER_H
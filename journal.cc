@@ -0,0 +1,315 @@
+#include "journal.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace mukhi::matching_engine {
+
+namespace {
+// Number of messages taken off the ring at once.
+constexpr size_t kBatchSize = 64;
+// Sequence number (u64) and checksum (u32).
+constexpr size_t kRecordHeaderSize = 12;
+constexpr size_t kMaxRecordSize = kRecordHeaderSize + kMaxBinaryMessageSize;
+constexpr std::string_view kSegmentPrefix = "journal-";
+constexpr std::string_view kSegmentSuffix = ".log";
+
+std::string SegmentPath(const std::string& directory, uint64_t first) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%020llu",
+                static_cast<unsigned long long>(first));
+  return directory + "/" + std::string(kSegmentPrefix) + name +
+         std::string(kSegmentSuffix);
+}
+
+// FNV-1a of the record but its checksum.
+uint32_t RecordChecksum(const char* record, size_t length) {
+  uint32_t checksum = 2166136261u;
+  for (size_t i = 0; i < length; ++i) {
+    if (i == 8) i = kRecordHeaderSize;
+    checksum = (checksum ^ static_cast<uint8_t>(record[i])) * 16777619u;
+  }
+  return checksum;
+}
+
+// Returns the number of bytes of the record of `msg` written to `record`,
+// which must have room for `kMaxRecordSize` bytes.
+size_t EncodeRecord(uint64_t sequence, const InputMessage& msg, char* record) {
+  size_t length =
+      kRecordHeaderSize + EncodeBinary(msg, record + kRecordHeaderSize);
+  std::memcpy(record, &sequence, 8);
+  uint32_t checksum = RecordChecksum(record, length);
+  std::memcpy(record + 8, &checksum, 4);
+  return length;
+}
+
+struct Segment {
+  // Sequence number of the first record.
+  uint64_t first;
+  std::string path;
+};
+
+// Returns the segments in `directory`, in order.
+std::optional<std::vector<Segment>> ListSegments(const std::string& directory,
+                                                 std::ostream& es) {
+  DIR* dir = ::opendir(directory.c_str());
+  if (dir == nullptr) {
+    es << "Unable to open " << directory << " : " << std::strerror(errno)
+       << std::endl;
+    return std::nullopt;
+  }
+  std::vector<Segment> segments;
+  while (const dirent* entry = ::readdir(dir)) {
+    std::string_view name(entry->d_name);
+    if (name.size() != kSegmentPrefix.size() + 20 + kSegmentSuffix.size() ||
+        name.substr(0, kSegmentPrefix.size()) != kSegmentPrefix ||
+        name.substr(name.size() - kSegmentSuffix.size()) != kSegmentSuffix) {
+      continue;
+    }
+    uint64_t first = std::strtoull(name.data() + kSegmentPrefix.size(),
+                                   nullptr, 10);
+    segments.push_back({first, directory + "/" + std::string(name)});
+  }
+  ::closedir(dir);
+  std::sort(segments.begin(), segments.end(),
+            [](const Segment& a, const Segment& b) {
+              return a.first < b.first;
+            });
+  return segments;
+}
+
+/*
+Calls `process` with the message of every record of `segment`, up to the first
+one that's incomplete, corrupt or out of sequence. Returns the sequence number
+of the last record, and the offset right after it.
+*/
+template <typename Function>
+std::pair<uint64_t, size_t> ScanSegment(std::string_view segment,
+                                        uint64_t first, Function process) {
+  // Records that pass the checksum were encoded by `EncodeBinary`, so parse
+  // errors aren't expected, and are treated as corruption.
+  std::ostream no_errors(nullptr);
+  uint64_t next = first;
+  size_t offset = 0;
+  while (segment.size() - offset >= kRecordHeaderSize + kBinaryHeaderSize) {
+    const char* record = segment.data() + offset;
+    uint64_t sequence;
+    uint32_t checksum;
+    std::memcpy(&sequence, record, 8);
+    std::memcpy(&checksum, record + 8, 4);
+    if (sequence != next) break;
+    size_t length = BinaryMessageLength(record + kRecordHeaderSize);
+    if (length == 0 || length > kMaxBinaryMessageSize ||
+        kRecordHeaderSize + length > segment.size() - offset ||
+        RecordChecksum(record, kRecordHeaderSize + length) != checksum) {
+      break;
+    }
+    auto msg = ParseBinary(
+        std::string_view(record + kRecordHeaderSize, length), no_errors);
+    if (!msg.has_value()) break;
+    process(*msg);
+    offset += kRecordHeaderSize + length;
+    ++next;
+  }
+  return {next - 1, offset};
+}
+}  // namespace
+
+std::unique_ptr<Journal> Journal::Open(const JournalOptions& options,
+                                       uint64_t sequence, std::ostream& es) {
+  if (options.segment_size < kMaxRecordSize) {
+    es << "Journal segments must be at least " << kMaxRecordSize
+       << " bytes long" << std::endl;
+    return nullptr;
+  }
+  auto segments = ListSegments(options.directory, es);
+  if (!segments.has_value()) return nullptr;
+
+  uint64_t first = sequence + 1;
+  size_t offset = 0;
+  if (!segments->empty()) {
+    const Segment& segment = segments->back();
+    auto file = MappedFile::Open(segment.path, es);
+    if (!file.has_value()) return nullptr;
+    auto [last, end] =
+        ScanSegment(file->data(), segment.first, [](const InputMessage&) {});
+    if (last > sequence) {
+      es << "The journal has records up to sequence " << last
+         << ", past sequence " << sequence << " of the order book" << std::endl;
+      return nullptr;
+    }
+    // Otherwise the order book is ahead of the journal, e.g. it was loaded
+    // from a snapshot, and its records start in a segment of their own.
+    if (last == sequence) {
+      first = segment.first;
+      offset = end;
+    }
+  }
+
+  std::unique_ptr<Journal> journal(new Journal(options, sequence, es));
+  if (!journal->OpenSegment(first, offset)) {
+    es << journal->error_ << std::endl;
+    return nullptr;
+  }
+  journal->committer_ = std::thread(&Journal::Commit, journal.get());
+  return journal;
+}
+
+Journal::Journal(const JournalOptions& options, uint64_t sequence,
+                 std::ostream& es)
+    : options_(options),
+      es_(es),
+      ring_(options.ring_capacity),
+      sequence_(sequence),
+      committed_sequence_(sequence) {
+  pending_.reserve(options.commit_size + kMaxRecordSize);
+}
+
+Journal::~Journal() {
+  Close();
+  if (fd_ >= 0) ::close(fd_);
+}
+
+bool Journal::Close() {
+  if (committer_.joinable()) {
+    ring_.Close();
+    committer_.join();
+    if (!error_.empty()) es_ << error_ << std::endl;
+  }
+  return error_.empty();
+}
+
+bool Journal::Fail(const std::string& what, int error) {
+  if (error_.empty()) error_ = what + " : " + std::strerror(error);
+  return false;
+}
+
+bool Journal::OpenSegment(uint64_t first, size_t offset) {
+  std::string path = SegmentPath(options_.directory, first);
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0) return Fail("Unable to open " + path, errno);
+  // Drops whatever follows the last complete record, e.g. a torn one, then
+  // zero-fills the rest of the segment.
+  if (::ftruncate(fd_, static_cast<off_t>(offset)) != 0) {
+    return Fail("Unable to truncate " + path, errno);
+  }
+  if (int error = ::posix_fallocate(fd_, 0, options_.segment_size);
+      error != 0) {
+    return Fail("Unable to preallocate " + path, error);
+  }
+  if (::fsync(fd_) != 0) return Fail("Unable to sync " + path, errno);
+  // Makes the new file itself durable.
+  int dir = ::open(options_.directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dir < 0) return Fail("Unable to open " + options_.directory, errno);
+  bool synced = ::fsync(dir) == 0;
+  int error = errno;
+  ::close(dir);
+  if (!synced) return Fail("Unable to sync " + options_.directory, error);
+  segment_offset_ = offset;
+  return true;
+}
+
+bool Journal::CommitPending() {
+  if (!error_.empty()) {
+    // Drop the records, there's no committing them in order anymore.
+    pending_.clear();
+    return false;
+  }
+  size_t written = 0;
+  while (written < pending_.size()) {
+    ssize_t n = ::pwrite(fd_, pending_.data() + written,
+                         pending_.size() - written,
+                         static_cast<off_t>(segment_offset_ + written));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return Fail("Unable to write the journal", errno);
+    }
+    written += static_cast<size_t>(n);
+  }
+  if (::fdatasync(fd_) != 0) return Fail("Unable to sync the journal", errno);
+  segment_offset_ += pending_.size();
+  pending_.clear();
+  committed_sequence_.store(sequence_, std::memory_order_release);
+  return true;
+}
+
+void Journal::Commit() {
+  using Clock = std::chrono::steady_clock;
+  InputMessage batch[kBatchSize];
+  char record[kMaxRecordSize];
+  // When the oldest pending record is due.
+  Clock::time_point deadline;
+  while (true) {
+    size_t n;
+    if (pending_.empty()) {
+      // Nothing to commit, sleep until there is.
+      n = ring_.PopBatch(batch, kBatchSize);
+      if (n == 0) break;
+    } else {
+      // Returns 0 once the oldest record is due, or once the ring is closed
+      // and drained, and then there's no point in waiting.
+      n = ring_.PopBatchUntil(batch, kBatchSize, deadline);
+      if (n == 0) {
+        CommitPending();
+        continue;
+      }
+    }
+    if (pending_.empty()) deadline = Clock::now() + options_.commit_interval;
+    for (size_t i = 0; i < n; ++i) {
+      size_t length = EncodeRecord(sequence_ + 1, batch[i], record);
+      if (segment_offset_ + pending_.size() + length > options_.segment_size &&
+          CommitPending()) {
+        ::close(fd_);
+        fd_ = -1;
+        OpenSegment(sequence_ + 1, 0);
+      }
+      pending_.append(record, length);
+      ++sequence_;
+    }
+    if (pending_.size() >= options_.commit_size) CommitPending();
+  }
+}
+
+std::optional<uint64_t> ReplayJournal(
+    const std::string& directory, uint64_t sequence,
+    const std::function<void(const InputMessage&)>& process,
+    std::ostream& es) {
+  auto segments = ListSegments(directory, es);
+  if (!segments.has_value()) return std::nullopt;
+  uint64_t next = sequence + 1;
+  for (size_t i = 0; i < segments->size(); ++i) {
+    const Segment& segment = (*segments)[i];
+    // Skip the segments of which all the records are up to `sequence`.
+    if (i + 1 < segments->size() && (*segments)[i + 1].first <= next) continue;
+    if (segment.first > next) {
+      es << "The journal is missing the records from sequence " << next
+         << std::endl;
+      return std::nullopt;
+    }
+    auto file = MappedFile::Open(segment.path, es);
+    if (!file.has_value()) return std::nullopt;
+    uint64_t record_sequence = segment.first;
+    ScanSegment(file->data(), segment.first,
+                [&](const InputMessage& msg) {
+                  if (record_sequence++ >= next) {
+                    process(msg);
+                    ++next;
+                  }
+                });
+  }
+  return next - 1;
+}
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,143 @@
+#ifndef MATCHING_ENGINE_JOURNAL_H
+#define MATCHING_ENGINE_JOURNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "messages.h"
+#include "spsc_ring.h"
+
+namespace mukhi::matching_engine {
+
+struct JournalOptions {
+  // Directory of the segment files, which must exist.
+  std::string directory;
+  // Size segment files are preallocated to. A new segment is started once the
+  // next record doesn't fit in the current one.
+  size_t segment_size = 64 << 20;
+  // Records are committed, i.e. written and synced, at most this long after
+  // being appended, or as soon as `commit_size` bytes of them are pending. Zero
+  // commits whenever the journal catches up with the appends.
+  std::chrono::microseconds commit_interval{200};
+  size_t commit_size = 256 << 10;
+  // Capacity of the ring between the appending and the committing threads.
+  size_t ring_capacity = 1 << 14;
+};
+
+/*
+A write-ahead journal of the input messages of an order book.
+
+Every message the order book is about to process is appended as a record
+numbered with the sequence number the book will have once it's processed (see
+`OrderBook::sequence`), so a book can be rebuilt from a snapshot by replaying
+the records past the sequence number of the snapshot, see `ReplayJournal`.
+
+Appending doesn't touch the disk: the message is handed over a ring to a
+committing thread, which encodes the records and commits them in groups, with a
+single write and sync per group. Under load a group holds everything appended
+while the previous one was being synced, so the cost of syncing is spread over
+many messages. Records are never split across segments, and segments are
+preallocated, so that syncing them doesn't have to update the size of the file.
+While no records are due, the committing thread sleeps on the ring.
+
+Segment files are named after the sequence number of their first record. A
+record is made of its sequence number (u64), a checksum (u32) of the rest of
+it, and the message in the binary input format. The records of a segment are
+numbered consecutively and followed by zeros, up to the end of the segment.
+Replaying stops at the first record that's incomplete or corrupt, e.g. because
+of a crash in the middle of a commit.
+
+Messages are appended before the order book processes them, but the events of
+the book aren't held back until the records of their messages are committed.
+After a crash, the output may therefore show the events of up to the last
+`commit_interval` of messages that can't be replayed.
+
+`Append` must be called by a single thread.
+*/
+class Journal {
+ public:
+  /**
+  Opens the journal in `options.directory` to append the records that follow
+  `sequence`, the sequence number of the order book. Returns nullptr and writes
+  the reason to `es` if the journal can't be opened, or if it has records past
+  `sequence`, i.e. it hasn't been replayed into the order book.
+  */
+  static std::unique_ptr<Journal> Open(const JournalOptions& options,
+                                       uint64_t sequence, std::ostream& es);
+
+  Journal(const Journal&) = delete;
+  Journal& operator=(const Journal&) = delete;
+  // Closes the journal if it's still open.
+  ~Journal();
+
+  // Appends the message that follows the last one appended.
+  void Append(const InputMessage& msg) { ring_.Push(msg); }
+
+  /**
+  Commits the records appended so far and stops the committing thread. Returns
+  false and writes the reason to the error stream if any of them couldn't be
+  committed. No records may be appended afterwards.
+  */
+  bool Close();
+
+  // Sequence number of the last record committed. May be called from any
+  // thread.
+  uint64_t committed_sequence() const {
+    return committed_sequence_.load(std::memory_order_acquire);
+  }
+
+ private:
+  Journal(const JournalOptions& options, uint64_t sequence, std::ostream& es);
+
+  // Opens the segment of which the first record is `first`, to append
+  // records at `offset`, past the ones it already has.
+  bool OpenSegment(uint64_t first, size_t offset);
+  // Runs on the committing thread.
+  void Commit();
+  // Writes out and syncs the pending records.
+  bool CommitPending();
+  // Records the first failure, of which `error` is the errno, and returns
+  // false.
+  bool Fail(const std::string& what, int error);
+
+  const JournalOptions options_;
+  std::ostream& es_;
+  SpscRing<InputMessage> ring_;
+  std::thread committer_;
+
+  // Used by the committing thread only.
+  int fd_ = -1;
+  size_t segment_offset_ = 0;
+  // Sequence number of the last record encoded.
+  uint64_t sequence_;
+  // Records encoded but not yet committed.
+  std::string pending_;
+  // Set on the first failure, after which records are dropped. Read by
+  // `Close` once the committing thread is done.
+  std::string error_;
+
+  std::atomic<uint64_t> committed_sequence_;
+};
+
+/**
+Calls `process` with the messages of the records of the journal in `directory`
+that follow `sequence`, in order. Returns the sequence number of the last one,
+or `std::nullopt` after writing the reason to `es` if the journal can't be read
+or is missing records right after `sequence`.
+*/
+std::optional<uint64_t> ReplayJournal(
+    const std::string& directory, uint64_t sequence,
+    const std::function<void(const InputMessage&)>& process,
+    std::ostream& es);
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_JOURNAL_H
@@ -0,0 +1,243 @@
+#include "journal.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mukhi::matching_engine {
+
+namespace fs = std::filesystem;
+
+// Returns an empty directory for the journal of a test.
+std::string JournalDirectory(const std::string& name) {
+  fs::path path = fs::temp_directory_path() / name;
+  fs::remove_all(path);
+  fs::create_directories(path);
+  return path;
+}
+
+// Messages are compared by their binary encoding.
+std::string Encode(const InputMessage& msg) {
+  char buf[kMaxBinaryMessageSize];
+  return std::string(buf, EncodeBinary(msg, buf));
+}
+
+// Adds, with a symbol every third one, and cancels.
+std::vector<InputMessage> Messages(OrderId first, size_t n) {
+  std::vector<InputMessage> messages;
+  for (OrderId id = first; id < first + n; ++id) {
+    if (id % 5 == 0) {
+      messages.push_back(CancelOrderRequest{.order_id = id - 1});
+      continue;
+    }
+    AddOrderRequest add{.order_id = id,
+                        .side = id % 2 == 0 ? Side::kBuy : Side::kSell,
+                        .qty = id,
+                        .price = 100.25 + id % 7};
+    if (id % 3 == 0) add.symbol = *Symbol::FromString("SYM");
+    messages.push_back(add);
+  }
+  return messages;
+}
+
+std::vector<std::string> Encode(const std::vector<InputMessage>& messages) {
+  std::vector<std::string> encoded;
+  for (const InputMessage& msg : messages) encoded.push_back(Encode(msg));
+  return encoded;
+}
+
+// Appends `messages` to the journal in `options.directory`, which ends at
+// `sequence`.
+void Append(const JournalOptions& options, uint64_t sequence,
+            const std::vector<InputMessage>& messages) {
+  std::ostringstream es;
+  auto journal = Journal::Open(options, sequence, es);
+  ASSERT_NE(journal, nullptr) << es.str();
+  for (const InputMessage& msg : messages) journal->Append(msg);
+  EXPECT_TRUE(journal->Close());
+  EXPECT_EQ(journal->committed_sequence(), sequence + messages.size());
+  EXPECT_EQ(es.str(), "");
+}
+
+// Returns the encoded messages of the records past `sequence`, and the
+// sequence number of the last one.
+std::pair<std::optional<uint64_t>, std::vector<std::string>> Replay(
+    const std::string& directory, uint64_t sequence, std::ostream& es) {
+  std::vector<std::string> messages;
+  auto last = ReplayJournal(
+      directory, sequence,
+      [&messages](const InputMessage& msg) { messages.push_back(Encode(msg)); },
+      es);
+  return {last, messages};
+}
+
+size_t NumSegments(const std::string& directory) {
+  return std::distance(fs::directory_iterator(directory),
+                       fs::directory_iterator());
+}
+
+TEST(Journal, AppendAndReplay) {
+  JournalOptions options{.directory = JournalDirectory("journal_test_replay")};
+  std::vector<InputMessage> messages = Messages(1, 1000);
+  Append(options, 0, messages);
+
+  std::ostringstream es;
+  auto [last, replayed] = Replay(options.directory, 0, es);
+  EXPECT_EQ(last, 1000);
+  EXPECT_EQ(replayed, Encode(messages));
+
+  // From a snapshot point.
+  std::tie(last, replayed) = Replay(options.directory, 600, es);
+  EXPECT_EQ(last, 1000);
+  EXPECT_EQ(replayed, Encode(Messages(601, 400)));
+
+  std::tie(last, replayed) = Replay(options.directory, 1000, es);
+  EXPECT_EQ(last, 1000);
+  EXPECT_TRUE(replayed.empty());
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST(Journal, EmptyJournal) {
+  std::string directory = JournalDirectory("journal_test_empty");
+  std::ostringstream es;
+  auto [last, replayed] = Replay(directory, 42, es);
+  EXPECT_EQ(last, 42);
+  EXPECT_TRUE(replayed.empty());
+
+  EXPECT_EQ(Replay(directory + "/missing", 0, es).first, std::nullopt);
+  EXPECT_NE(es.str(), "");
+}
+
+TEST(Journal, SegmentsArePreallocated) {
+  JournalOptions options{.directory = JournalDirectory("journal_test_segments"),
+                         .segment_size = 1024};
+  std::vector<InputMessage> messages = Messages(1, 500);
+  Append(options, 0, messages);
+
+  EXPECT_GT(NumSegments(options.directory), 10);
+  for (const auto& entry : fs::directory_iterator(options.directory)) {
+    EXPECT_EQ(entry.file_size(), 1024) << entry.path();
+  }
+  std::ostringstream es;
+  auto [last, replayed] = Replay(options.directory, 0, es);
+  EXPECT_EQ(last, 500);
+  EXPECT_EQ(replayed, Encode(messages));
+  std::tie(last, replayed) = Replay(options.directory, 250, es);
+  EXPECT_EQ(replayed, Encode(Messages(251, 250)));
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST(Journal, ReopenContinuesLastSegment) {
+  JournalOptions options{.directory = JournalDirectory("journal_test_reopen")};
+  Append(options, 0, Messages(1, 10));
+
+  // The order book must have caught up with the journal.
+  std::ostringstream es;
+  EXPECT_EQ(Journal::Open(options, 5, es), nullptr);
+  EXPECT_EQ(es.str(),
+            "The journal has records up to sequence 10, past sequence 5 of the "
+            "order book\n");
+
+  Append(options, 10, Messages(11, 5));
+  EXPECT_EQ(NumSegments(options.directory), 1);
+  auto [last, replayed] = Replay(options.directory, 0, es);
+  EXPECT_EQ(last, 15);
+  EXPECT_EQ(replayed, Encode(Messages(1, 15)));
+}
+
+TEST(Journal, TornRecord) {
+  JournalOptions options{.directory = JournalDirectory("journal_test_torn")};
+  std::vector<InputMessage> messages = Messages(1, 10);
+  Append(options, 0, messages);
+  // Corrupts the last byte of the last record.
+  size_t size = 0;
+  for (const InputMessage& msg : messages) size += 12 + Encode(msg).size();
+  fs::path segment = fs::directory_iterator(options.directory)->path();
+  {
+    std::fstream file(segment, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(size - 1);
+    file.put('\x7f');
+  }
+
+  std::ostringstream es;
+  auto [last, replayed] = Replay(options.directory, 0, es);
+  EXPECT_EQ(last, 9);
+  messages.pop_back();
+  EXPECT_EQ(replayed, Encode(messages));
+
+  // The torn record is overwritten.
+  Append(options, 9, Messages(100, 1));
+  std::tie(last, replayed) = Replay(options.directory, 0, es);
+  EXPECT_EQ(last, 10);
+  messages.push_back(Messages(100, 1).front());
+  EXPECT_EQ(replayed, Encode(messages));
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST(Journal, BookAheadOfJournal) {
+  JournalOptions options{.directory = JournalDirectory("journal_test_ahead")};
+  Append(options, 0, Messages(1, 10));
+  // E.g. the order book was loaded from a snapshot taken at sequence 20.
+  Append(options, 20, Messages(21, 3));
+  EXPECT_EQ(NumSegments(options.directory), 2);
+
+  std::ostringstream es;
+  auto [last, replayed] = Replay(options.directory, 20, es);
+  EXPECT_EQ(last, 23);
+  EXPECT_EQ(replayed, Encode(Messages(21, 3)));
+  EXPECT_EQ(es.str(), "");
+
+  EXPECT_EQ(Replay(options.directory, 5, es).first, std::nullopt);
+  EXPECT_EQ(es.str(), "The journal is missing the records from sequence 11\n");
+}
+
+TEST(Journal, CommitsWithinInterval) {
+  JournalOptions options{.directory = JournalDirectory("journal_test_interval"),
+                         .commit_interval = std::chrono::milliseconds(1)};
+  std::ostringstream es;
+  auto journal = Journal::Open(options, 0, es);
+  ASSERT_NE(journal, nullptr) << es.str();
+  journal->Append(Messages(1, 1).front());
+  // Committed without closing the journal.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (journal->committed_sequence() == 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(journal->committed_sequence(), 1);
+  EXPECT_TRUE(journal->Close());
+}
+
+TEST(Journal, IdleCommitterSleeps) {
+  JournalOptions options{.directory = JournalDirectory("journal_test_idle"),
+                         .commit_interval = std::chrono::milliseconds(200)};
+  std::ostringstream es;
+  auto journal = Journal::Open(options, 0, es);
+  ASSERT_NE(journal, nullptr) << es.str();
+  // The committing thread sleeps while the record is pending, and again once
+  // it's committed.
+  std::clock_t start = std::clock();
+  journal->Append(Messages(1, 1).front());
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  EXPECT_LT(std::clock() - start, CLOCKS_PER_SEC / 10);
+  EXPECT_EQ(journal->committed_sequence(), 1);
+  EXPECT_TRUE(journal->Close());
+}
+
+TEST(Journal, SegmentTooSmall) {
+  std::ostringstream es;
+  EXPECT_EQ(Journal::Open({.directory = JournalDirectory("journal_test_small"),
+                           .segment_size = 16},
+                          0, es),
+            nullptr);
+  EXPECT_EQ(es.str(), "Journal segments must be at least 57 bytes long\n");
+}
+
+}  // namespace mukhi::matching_engine
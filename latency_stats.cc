@@ -0,0 +1,87 @@
+#include "latency_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace mukhi::matching_engine {
+
+namespace {
+constexpr const char* kStageNames[] = {"parse", "match", "book_update",
+                                       "publish", "total"};
+constexpr const char* kTypeNames[] = {"add", "cancel", "modify"};
+constexpr const char* kOutcomeNames[] = {"rested", "partially_filled",
+                                         "fully_filled", "canceled",
+                                         "rejected"};
+}  // namespace
+
+uint64_t LatencyHistogram::BucketMax(size_t index) {
+  if (index < (size_t{2} << kSubBucketBits)) return index;
+  int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+  uint64_t sub_bucket = index - (static_cast<size_t>(shift) << kSubBucketBits);
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::ValueAtQuantile(double quantile) const {
+  uint64_t total = count();
+  if (total == 0) return 0;
+  auto rank = static_cast<uint64_t>(std::ceil(quantile * total));
+  if (rank == 0) rank = 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen < rank) continue;
+    // The last bucket has no upper bound. Buckets may also be read a little
+    // ahead of `max_` while recording.
+    return i == kNumBuckets - 1 ? max() : std::min(BucketMax(i), max());
+  }
+  return max();
+}
+
+LatencyStats::LatencyStats(uint32_t sample_interval)
+    : sample_interval_(sample_interval > 0 ? sample_interval : 1),
+      start_ticks_(ReadTsc()),
+      start_time_(std::chrono::steady_clock::now()),
+      histograms_(new LatencyHistogram[kNumStages][kNumTypes][kNumOutcomes]) {}
+
+double LatencyStats::TickPeriod() const {
+  uint64_t ticks = ReadTsc() - start_ticks_;
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start_time_);
+  if (ticks == 0 || elapsed.count() <= 0) return 1;
+  return static_cast<double>(elapsed.count()) / ticks;
+}
+
+void LatencyStats::Report(std::ostream& os) const {
+  double period = TickPeriod();
+  auto ns = [period](uint64_t ticks) {
+    return static_cast<unsigned long long>(std::llround(ticks * period));
+  };
+  char line[160];
+  std::snprintf(line, sizeof(line), "%-12s %-7s %-17s %10s %9s %9s %9s %9s\n",
+                "stage", "message", "outcome", "count", "p50_ns", "p99_ns",
+                "p99.9_ns", "max_ns");
+  os << line;
+  for (size_t stage = 0; stage < kNumStages; ++stage) {
+    for (size_t type = 0; type < kNumTypes; ++type) {
+      for (size_t outcome = 0; outcome < kNumOutcomes; ++outcome) {
+        const LatencyHistogram& h = histograms_[stage][type][outcome];
+        if (h.count() == 0) continue;
+        std::snprintf(
+            line, sizeof(line),
+            "%-12s %-7s %-17s %10llu %9llu %9llu %9llu %9llu\n",
+            kStageNames[stage], kTypeNames[type],
+            stage == static_cast<size_t>(LatencyStage::kParse)
+                ? "-"
+                : kOutcomeNames[outcome],
+            static_cast<unsigned long long>(h.count()),
+            ns(h.ValueAtQuantile(0.5)), ns(h.ValueAtQuantile(0.99)),
+            ns(h.ValueAtQuantile(0.999)), ns(h.max()));
+        os << line;
+      }
+    }
+  }
+  os.flush();
+}
+
+}  // namespace mukhi::matching_engine
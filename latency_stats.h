@@ -0,0 +1,185 @@
+#ifndef MATCHING_ENGINE_LATENCY_STATS_H
+#define MATCHING_ENGINE_LATENCY_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+#include "messages.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace mukhi::matching_engine {
+
+/*
+Returns a timestamp in ticks of the time stamp counter, which takes a few
+nanoseconds to read, or in nanoseconds of the steady clock on platforms without
+one. Ticks are converted to nanoseconds when reporting, see `LatencyStats`.
+
+Reads aren't serialized with the surrounding instructions, so that timing stays
+cheap enough to leave on, at the cost of a few cycles of skew per timestamp.
+*/
+inline uint64_t ReadTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/*
+A log-linear histogram of latencies, in the manner of HDR histograms: values
+below 64 have a bucket each, and every power of two above is split into 32
+buckets, so values are recorded with a relative error of at most 1/32, in a
+fixed amount of memory and without any allocation. Values from 2^40 ticks on
+(minutes) all go into the last bucket, but `max` is exact.
+
+Recording is a handful of instructions. A histogram must be recorded into by a
+single thread, but may be read from any thread while it is.
+*/
+class LatencyHistogram {
+ public:
+  void Record(uint64_t value) {
+    Increment(buckets_[BucketIndex(value)], 1);
+    Increment(count_, 1);
+    if (value > max_.load(std::memory_order_relaxed)) {
+      max_.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+  // Returns the smallest value that at least `quantile` (in [0, 1]) of the
+  // values recorded are at most, up to the precision of the buckets, or 0 if
+  // nothing was recorded.
+  uint64_t ValueAtQuantile(double quantile) const;
+
+ private:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kMaxValueBits = 40;
+  static constexpr size_t kNumBuckets = (kMaxValueBits - kSubBucketBits + 1)
+                                        << kSubBucketBits;
+
+  // Only the recording thread writes, so there's no need for a locked add.
+  static void Increment(std::atomic<uint64_t>& counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+
+  static size_t BucketIndex(uint64_t value) {
+    if (value < (uint64_t{2} << kSubBucketBits)) return value;
+    if (value >> kMaxValueBits != 0) return kNumBuckets - 1;
+    int shift = 63 - __builtin_clzll(value) - kSubBucketBits;
+    return (static_cast<size_t>(shift) << kSubBucketBits) + (value >> shift);
+  }
+  // The largest value that goes into bucket `index`.
+  static uint64_t BucketMax(size_t index);
+
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+  std::atomic<uint64_t> count_ = 0;
+  std::atomic<uint64_t> max_ = 0;
+};
+
+// What came of a request.
+enum class Outcome : uint8_t {
+  // Added to the book without trading.
+  kRested = 0,
+  // Traded, then added to the book.
+  kPartiallyFilled = 1,
+  kFullyFilled = 2,
+  kCanceled = 3,
+  // Repeated order ids, prices off the tick grid, cancels and modifies of
+  // unknown orders.
+  kRejected = 4,
+};
+
+/*
+Stages of the processing of a message:
+
+* Parse: reading and parsing the message, from when the previous one was
+  delivered. Messages are read ahead and parsed in batches, and the cost of a
+  batch is counted on its first message. Messages read after waiting for more
+  input aren't counted, since the wait can't be told apart from parsing.
+* Match: checking the request and matching it against the book.
+* Book update: adding what's left of an order to the book, or removing the
+  order canceled.
+* Publish: handing the events of the request to the event sink. Events are
+  published in the middle of matching, and the time spent publishing them is
+  taken out of the match stage.
+* Total: all of the above but parsing, i.e. the time in the order book.
+*/
+enum class LatencyStage : uint8_t {
+  kParse = 0,
+  kMatch = 1,
+  kBookUpdate = 2,
+  kPublish = 3,
+  kTotal = 4,
+};
+
+/*
+Latency histograms of a matching engine, per stage, message type (adds, cancels
+and modifies) and outcome. Parse latencies are recorded per message type only,
+since the outcome isn't known yet.
+
+Reading the time stamp counter is most of the cost of recording, so only one in
+`sample_interval` messages may be timed, e.g. to leave recording on under heavy
+load. Counts are then those of the messages sampled.
+
+The parse histograms are recorded into by the thread reading the input, and
+the others by the thread processing orders, which may be different ones. Any
+thread may `Report` at any time.
+*/
+class LatencyStats {
+ public:
+  explicit LatencyStats(uint32_t sample_interval = 1);
+
+  uint32_t sample_interval() const { return sample_interval_; }
+
+  LatencyHistogram& histogram(LatencyStage stage, MessageType type,
+                              Outcome outcome) {
+    return histograms_[static_cast<size_t>(stage)][TypeIndex(type)]
+                      [static_cast<size_t>(outcome)];
+  }
+  LatencyHistogram& parse_histogram(MessageType type) {
+    return histogram(LatencyStage::kParse, type, Outcome::kRested);
+  }
+
+  /**
+  Writes the count, p50, p99, p99.9 and max, in nanoseconds, of every
+  histogram with values, one per line. Ticks are converted to nanoseconds at
+  the rate the counter has been running at since construction.
+  */
+  void Report(std::ostream& os) const;
+
+ private:
+  static constexpr size_t kNumStages = 5;
+  static constexpr size_t kNumTypes = 3;
+  static constexpr size_t kNumOutcomes = 5;
+
+  // Index of the histograms of the input message `type`.
+  static size_t TypeIndex(MessageType type) {
+    return type == MessageType::kModifyOrderRequest ? 2
+                                                    : static_cast<size_t>(type);
+  }
+  // Nanoseconds per tick.
+  double TickPeriod() const;
+
+  const uint32_t sample_interval_;
+  // When the stats were created, to calibrate the counter against.
+  const uint64_t start_ticks_;
+  const std::chrono::steady_clock::time_point start_time_;
+  std::unique_ptr<LatencyHistogram[][kNumTypes][kNumOutcomes]> histograms_;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_LATENCY_STATS_H
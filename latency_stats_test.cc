@@ -0,0 +1,100 @@
+#include "latency_stats.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mukhi::matching_engine {
+
+TEST(LatencyHistogram, Empty) {
+  LatencyHistogram h;
+  EXPECT_EQ(h.count(), 0);
+  EXPECT_EQ(h.max(), 0);
+  EXPECT_EQ(h.ValueAtQuantile(0.5), 0);
+  EXPECT_EQ(h.ValueAtQuantile(1), 0);
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact) {
+  LatencyHistogram h;
+  for (uint64_t value = 0; value < 64; ++value) h.Record(value);
+  EXPECT_EQ(h.count(), 64);
+  EXPECT_EQ(h.max(), 63);
+  EXPECT_EQ(h.ValueAtQuantile(0), 0);
+  EXPECT_EQ(h.ValueAtQuantile(0.5), 31);
+  EXPECT_EQ(h.ValueAtQuantile(0.99), 63);
+  EXPECT_EQ(h.ValueAtQuantile(1), 63);
+}
+
+TEST(LatencyHistogram, RelativeError) {
+  // Log-uniform values, up to about 2^40.
+  std::mt19937_64 rng(5);
+  std::uniform_real_distribution<double> exponent(0, 40);
+  LatencyHistogram h;
+  std::vector<uint64_t> values;
+  for (int i = 0; i < 100000; ++i) {
+    values.push_back(static_cast<uint64_t>(std::exp2(exponent(rng))));
+    h.Record(values.back());
+  }
+  std::sort(values.begin(), values.end());
+  for (double quantile : {0.01, 0.25, 0.5, 0.9, 0.99, 0.999, 0.9999, 1.0}) {
+    uint64_t exact = values[static_cast<size_t>(
+                                std::ceil(quantile * values.size())) -
+                            1];
+    uint64_t value = h.ValueAtQuantile(quantile);
+    EXPECT_GE(value, exact) << quantile;
+    EXPECT_LE(value, exact + exact / 32) << quantile;
+  }
+  EXPECT_EQ(h.max(), values.back());
+  EXPECT_EQ(h.ValueAtQuantile(1), values.back());
+}
+
+TEST(LatencyHistogram, HugeValues) {
+  LatencyHistogram h;
+  h.Record(1);
+  h.Record(uint64_t{1} << 50);
+  h.Record(std::numeric_limits<uint64_t>::max());
+  EXPECT_EQ(h.count(), 3);
+  EXPECT_EQ(h.ValueAtQuantile(0.3), 1);
+  // Both go into the last bucket, and are reported up to the max.
+  EXPECT_EQ(h.ValueAtQuantile(0.5), std::numeric_limits<uint64_t>::max());
+  EXPECT_EQ(h.max(), std::numeric_limits<uint64_t>::max());
+}
+
+TEST(LatencyStats, Report) {
+  LatencyStats stats;
+  for (uint64_t ticks : {10, 20, 30}) {
+    stats.histogram(LatencyStage::kMatch, MessageType::kAddOrderRequest,
+                    Outcome::kPartiallyFilled)
+        .Record(ticks);
+  }
+  stats.parse_histogram(MessageType::kCancelOrderRequest).Record(5);
+
+  std::ostringstream os;
+  stats.Report(os);
+  std::istringstream report(os.str());
+  std::string line;
+  std::getline(report, line);
+  EXPECT_EQ(line.substr(0, 38), "stage        message outcome          ");
+  // Histograms without values are left out, in stage order.
+  std::string stage, type, outcome;
+  uint64_t count;
+  report >> stage >> type >> outcome >> count;
+  EXPECT_EQ(stage + " " + type + " " + outcome, "parse cancel -");
+  EXPECT_EQ(count, 1);
+  std::getline(report, line);
+  report >> stage >> type >> outcome >> count;
+  EXPECT_EQ(stage + " " + type + " " + outcome,
+            "match add partially_filled");
+  EXPECT_EQ(count, 3);
+  std::getline(report, line);
+  EXPECT_FALSE(std::getline(report, line));
+}
+
+}  // namespace mukhi::matching_engine
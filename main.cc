@@ -1,11 +1,256 @@
+#include <pthread.h>
+#include <signal.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
 
+#include "mapped_file.h"
 #include "matching_engine.h"
+#include "multi_book_engine.h"
+#include "shm_transport.h"
+
+namespace {
+// Parses `--<name>=<value>` and returns the value, or nullptr if `arg` is not
+// `name`.
+const char* FlagValue(std::string_view arg, std::string_view name) {
+  if (arg.substr(0, 2) != "--" || arg.substr(2, name.size()) != name ||
+      arg.substr(2 + name.size(), 1) != "=") {
+    return nullptr;
+  }
+  return arg.data() + 3 + name.size();
+}
+
+// Replays `input_path`, if set, or processes stdin with `engine`. What the
+// engine is doing is logged on `log`.
+template <typename Engine>
+int Run(Engine& engine, const std::string& input_path, std::ostream& log) {
+  if (!input_path.empty()) {
+    auto file =
+        mukhi::matching_engine::MappedFile::Open(input_path, std::cerr);
+    if (!file.has_value()) return 1;
+    log << "Replaying " << input_path << "..." << std::endl;
+    engine.Replay(file->data());
+    return 0;
+  }
+  log << "Starting matching engine..." << std::endl;
+  engine.Start();
+  return 0;
+}
+
+/*
+Writes the latency histograms of `engine` to stderr whenever the process gets
+SIGUSR1, until destroyed. Must be constructed before any other thread is
+started, so that they all leave the signal to the reporting thread.
+*/
+class LatencyReporter {
+ public:
+  explicit LatencyReporter(
+      const mukhi::matching_engine::MatchingEngine& engine) {
+    sigemptyset(&signals_);
+    sigaddset(&signals_, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals_, nullptr);
+    thread_ = std::thread([this, &engine] {
+      int signal;
+      while (sigwait(&signals_, &signal) == 0 &&
+             !done_.load(std::memory_order_acquire)) {
+        engine.ReportLatency(std::cerr);
+      }
+    });
+  }
+  ~LatencyReporter() {
+    done_.store(true, std::memory_order_release);
+    pthread_kill(thread_.native_handle(), SIGUSR1);
+    thread_.join();
+  }
+
+ private:
+  sigset_t signals_;
+  std::atomic_bool done_ = false;
+  std::thread thread_;
+};
+
+// The transport served with `--shm_transport`, closed on SIGINT or SIGTERM,
+// which makes the engine return once it has processed the messages already
+// pushed.
+mukhi::matching_engine::ShmTransport* shm_transport = nullptr;
+
+void CloseShmTransport(int) { shm_transport->Close(); }
+}  // namespace
 
 int main(int argc, char** argv) {
-  mukhi::matching_engine::MatchingEngine me(std::cin, std::cout, std::cerr);
-  std::cout << "Starting matching engine..." << std::endl;
-  me.Start();
+  // Lets `std::cin` buffer its input, so that the engine can tell when it has
+  // to wait for more and flush its output.
+  std::ios_base::sync_with_stdio(false);
+  mukhi::matching_engine::MatchingEngineOptions options;
+  // Fixed-point price mode is enabled by passing all three of the tick grid
+  // flags, e.g. `--tick_size=0.5 --min_price=900 --max_price=1100`.
+  mukhi::matching_engine::TickGrid grid;
+  int grid_flags = 0;
+  // Replays this file instead of reading from stdin.
+  std::string input_path;
+  // Runs a `MultiBookEngine` with this many shards, if set.
+  size_t shards = 0;
+  // Loads the order book from this snapshot before processing any input.
+  std::string snapshot_path;
+  // Saves a snapshot of the order book here once all the input is processed.
+  std::string save_snapshot_path;
+  // Serves the clients of a shared memory transport of this name instead of
+  // reading stdin, see `ShmTransport`.
+  std::string shm_transport_name;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg(argv[i]);
+    const char* v;
+    if ((v = FlagValue(arg, "tick_size"))) {
+      grid.tick_size = std::strtod(v, nullptr);
+      ++grid_flags;
+    } else if ((v = FlagValue(arg, "min_price"))) {
+      grid.min_price = std::strtod(v, nullptr);
+      ++grid_flags;
+    } else if ((v = FlagValue(arg, "max_price"))) {
+      grid.max_price = std::strtod(v, nullptr);
+      ++grid_flags;
+    } else if (arg == "--pipelined") {
+      options.pipelined = true;
+    } else if (arg == "--depth_updates") {
+      options.order_book.publish_depth_updates = true;
+    } else if (arg == "--bbo_updates") {
+      options.order_book.publish_bbo_updates = true;
+    } else if (arg == "--latency_stats") {
+      // Reported on SIGUSR1 and at exit.
+      options.latency_stats = true;
+    } else if ((v = FlagValue(arg, "latency_sample_interval"))) {
+      options.latency_sample_interval = std::strtoul(v, nullptr, 10);
+    } else if ((v = FlagValue(arg, "shards"))) {
+      shards = std::strtoull(v, nullptr, 10);
+      if (shards == 0) {
+        std::cerr << "--shards must be positive." << std::endl;
+        return 1;
+      }
+    } else if ((v = FlagValue(arg, "journal"))) {
+      // Replays the journal in this directory, then appends to it.
+      options.journal = mukhi::matching_engine::JournalOptions{.directory = v};
+    } else if ((v = FlagValue(arg, "snapshot"))) {
+      snapshot_path = v;
+    } else if ((v = FlagValue(arg, "save_snapshot"))) {
+      save_snapshot_path = v;
+    } else if ((v = FlagValue(arg, "input"))) {
+      input_path = v;
+    } else if ((v = FlagValue(arg, "shm_transport"))) {
+      shm_transport_name = v;
+    } else if ((v = FlagValue(arg, "output_format"))) {
+      std::string_view format(v);
+      if (format == "text") {
+        options.output_format = mukhi::matching_engine::OutputFormat::kText;
+      } else if (format == "binary") {
+        options.output_format = mukhi::matching_engine::OutputFormat::kBinary;
+      } else {
+        std::cerr << "--output_format must be one of text or binary."
+                  << std::endl;
+        return 1;
+      }
+    } else if ((v = FlagValue(arg, "input_format"))) {
+      std::string_view format(v);
+      if (format == "auto") {
+        options.input_format = mukhi::matching_engine::InputFormat::kAuto;
+      } else if (format == "text") {
+        options.input_format = mukhi::matching_engine::InputFormat::kText;
+      } else if (format == "binary") {
+        options.input_format = mukhi::matching_engine::InputFormat::kBinary;
+      } else {
+        std::cerr << "--input_format must be one of auto, text or binary."
+                  << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Unknown flag: " << arg << std::endl;
+      return 1;
+    }
+  }
+  // Keeps the log lines out of the binary event feed.
+  std::ostream& log =
+      options.output_format == mukhi::matching_engine::OutputFormat::kBinary
+          ? std::cerr
+          : std::cout;
+  if (grid_flags > 0) {
+    if (grid_flags != 3 || grid.tick_size <= 0 ||
+        grid.min_price > grid.max_price) {
+      std::cerr << "Invalid tick grid, --tick_size, --min_price and "
+                   "--max_price are all required."
+                << std::endl;
+      return 1;
+    }
+    options.order_book.tick_grid = grid;
+  }
 
+  if (shards > 0) {
+    if (options.journal.has_value() || !snapshot_path.empty() ||
+        !save_snapshot_path.empty()) {
+      std::cerr << "--journal and snapshots aren't supported with --shards."
+                << std::endl;
+      return 1;
+    }
+    if (options.latency_stats) {
+      std::cerr << "--latency_stats isn't supported with --shards."
+                << std::endl;
+      return 1;
+    }
+    if (!shm_transport_name.empty()) {
+      std::cerr << "--shm_transport isn't supported with --shards."
+                << std::endl;
+      return 1;
+    }
+    mukhi::matching_engine::MultiBookEngine engine(
+        std::cin, std::cout, std::cerr,
+        {.input_format = options.input_format,
+         .order_book = options.order_book,
+         .num_shards = shards,
+         .output_format = options.output_format});
+    return Run(engine, input_path, log);
+  }
+  std::unique_ptr<mukhi::matching_engine::ShmTransport> transport;
+  if (!shm_transport_name.empty()) {
+    if (!input_path.empty()) {
+      std::cerr << "--input isn't supported with --shm_transport."
+                << std::endl;
+      return 1;
+    }
+    transport = mukhi::matching_engine::ShmTransport::Create(
+        {.name = shm_transport_name}, std::cerr);
+    if (transport == nullptr) return 1;
+    options.shm_transport = transport.get();
+    shm_transport = transport.get();
+    signal(SIGINT, CloseShmTransport);
+    signal(SIGTERM, CloseShmTransport);
+  }
+  mukhi::matching_engine::MatchingEngine me(std::cin, std::cout, std::cerr,
+                                            options);
+  std::optional<LatencyReporter> latency_reporter;
+  if (options.latency_stats) latency_reporter.emplace(me);
+  std::optional<mukhi::matching_engine::MappedFile> snapshot;
+  if (!snapshot_path.empty()) {
+    snapshot =
+        mukhi::matching_engine::MappedFile::Open(snapshot_path, std::cerr);
+    if (!snapshot.has_value()) return 1;
+  }
+  if ((snapshot.has_value() || options.journal.has_value()) &&
+      !me.Recover(snapshot.has_value() ? snapshot->data() : "")) {
+    return 1;
+  }
+  if (int result = Run(me, input_path, log); result != 0) return result;
+  me.ReportLatency(std::cerr);
+  if (!save_snapshot_path.empty()) {
+    std::ofstream os(save_snapshot_path, std::ios::binary);
+    if (!me.SaveSnapshot(os)) {
+      std::cerr << "Unable to write " << save_snapshot_path << std::endl;
+      return 1;
+    }
+  }
   return 0;
-}
\ No newline at end of file
+}
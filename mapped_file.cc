@@ -0,0 +1,70 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace mukhi::matching_engine {
+
+std::optional<MappedFile> MappedFile::Open(const std::string& path,
+                                           std::ostream& es) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    es << "Unable to open " << path << " : " << std::strerror(errno)
+       << std::endl;
+    return std::nullopt;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    es << "Unable to stat " << path << " : " << std::strerror(errno)
+       << std::endl;
+    ::close(fd);
+    return std::nullopt;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return MappedFile(nullptr, 0);
+  }
+  void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping holds its own reference to the file.
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    es << "Unable to map " << path << " : " << std::strerror(errno)
+       << std::endl;
+    return std::nullopt;
+  }
+  // Only a hint, so failures are ignored.
+  ::madvise(addr, size, MADV_SEQUENTIAL);
+  return MappedFile(addr, size);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : addr_(std::exchange(other.addr_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    addr_ = std::exchange(other.addr_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() { Unmap(); }
+
+void MappedFile::Unmap() {
+  if (addr_ != nullptr) {
+    ::munmap(addr_, size_);
+    addr_ = nullptr;
+    size_ = 0;
+  }
+}
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,55 @@
+#ifndef MATCHING_ENGINE_MAPPED_FILE_H
+#define MATCHING_ENGINE_MAPPED_FILE_H
+
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace mukhi::matching_engine {
+
+/*
+A read-only memory mapping of a whole file.
+
+The mapping is advised as sequential, so the kernel reads ahead aggressively
+and drops pages soon after they are read. Pages are only backed by the page
+cache, so files larger than the physical memory can be mapped as long as they
+fit in the address space.
+
+Objects of this class are movable but not copyable. The views returned by
+`data` are valid for the lifetime of the object.
+*/
+class MappedFile {
+ public:
+  /**
+  Maps the file at `path`. Returns `std::nullopt` and writes the reason to `es`
+  if the file can't be opened or mapped.
+  */
+  static std::optional<MappedFile> Open(const std::string& path,
+                                        std::ostream& es);
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  std::string_view data() const {
+    return std::string_view(static_cast<const char*>(addr_), size_);
+  }
+  size_t size() const { return size_; }
+
+ private:
+  MappedFile(void* addr, size_t size) : addr_(addr), size_(size) {}
+
+  void Unmap();
+
+  // nullptr for empty files, which can't be mapped.
+  void* addr_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_MAPPED_FILE_H
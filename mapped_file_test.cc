@@ -0,0 +1,72 @@
+#include "mapped_file.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace mukhi::matching_engine {
+
+namespace fs = std::filesystem;
+
+fs::path WriteTempFile(const std::string& name, const std::string& contents) {
+  fs::path path = fs::temp_directory_path() / name;
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+  return path;
+}
+
+TEST(MappedFile, MapsContents) {
+  std::string contents = "0,1,0,9,1000\n1,1\n";
+  contents += std::string(1 << 16, 'x');
+  fs::path path = WriteTempFile("mapped_file_test_contents", contents);
+
+  std::stringstream es;
+  std::optional<MappedFile> file = MappedFile::Open(path, es);
+  ASSERT_NE(file, std::nullopt);
+  EXPECT_EQ(file->size(), contents.size());
+  EXPECT_EQ(file->data(), contents);
+  EXPECT_EQ(es.str(), "");
+  fs::remove(path);
+}
+
+TEST(MappedFile, EmptyFile) {
+  fs::path path = WriteTempFile("mapped_file_test_empty", "");
+
+  std::stringstream es;
+  std::optional<MappedFile> file = MappedFile::Open(path, es);
+  ASSERT_NE(file, std::nullopt);
+  EXPECT_EQ(file->size(), 0);
+  EXPECT_TRUE(file->data().empty());
+  fs::remove(path);
+}
+
+TEST(MappedFile, MissingFile) {
+  std::stringstream es;
+  EXPECT_EQ(MappedFile::Open("/nonexistent/mapped_file_test", es),
+            std::nullopt);
+  EXPECT_EQ(es.str(),
+            "Unable to open /nonexistent/mapped_file_test : No such file or "
+            "directory\n");
+}
+
+TEST(MappedFile, Move) {
+  fs::path path = WriteTempFile("mapped_file_test_move", "1,1\n");
+
+  std::stringstream es;
+  std::optional<MappedFile> file = MappedFile::Open(path, es);
+  ASSERT_NE(file, std::nullopt);
+  MappedFile moved(std::move(*file));
+  EXPECT_EQ(file->size(), 0);
+  EXPECT_EQ(moved.data(), "1,1\n");
+
+  *file = std::move(moved);
+  EXPECT_EQ(file->data(), "1,1\n");
+  EXPECT_EQ(moved.size(), 0);
+  fs::remove(path);
+}
+
+}  // namespace mukhi::matching_engine
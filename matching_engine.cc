@@ -1,23 +1,210 @@
 #include "matching_engine.h"
 
 #include <atomic>
+#include <sstream>
+#include <string_view>
 
 namespace mukhi::matching_engine {
 
-void MatchingEngine::Start() {
+namespace {
+// Targets of the input readers, see `input_reader.h`.
+
+// Processes messages on the reading thread as soon as they're read.
+class SerialTarget {
+ public:
+  SerialTarget(OrderBook& ob, EventSink& sink, std::ostream& es)
+      : ob_(ob), sink_(sink), es_(es) {}
+
+  std::ostream& errors() { return es_; }
+  void CommitErrors() {}
+  void DeliverBatch(const InputMessage* msgs, size_t n) {
+    ob_.ProcessBatch(msgs, n);
+  }
+  // Reading more input might block.
+  void Idle() { sink_.Flush(); }
+
+ private:
+  OrderBook& ob_;
+  EventSink& sink_;
+  std::ostream& es_;
+};
+
+// Hands messages and errors over to the threads of a pipeline.
+class PipelineTarget {
+ public:
+  explicit PipelineTarget(Pipeline& pipeline) : pipeline_(pipeline) {}
+
+  std::ostream& errors() { return errors_; }
+  void CommitErrors() {
+    if (errors_.tellp() > 0) {
+      pipeline_.PushError(errors_.str());
+      errors_.str("");
+    }
+  }
+  void DeliverBatch(const InputMessage* msgs, size_t n) {
+    for (size_t i = 0; i < n; ++i) pipeline_.Push(msgs[i]);
+  }
+  // The publishing thread flushes whenever it catches up.
+  void Idle() {}
+
+ private:
+  Pipeline& pipeline_;
+  std::ostringstream errors_;
+};
+
+// Appends messages to the journal before delivering them to `Target`.
+template <typename Target>
+class JournalingTarget {
+ public:
+  JournalingTarget(Journal& journal, Target& target)
+      : journal_(journal), target_(target) {}
+
+  std::ostream& errors() { return target_.errors(); }
+  void CommitErrors() { target_.CommitErrors(); }
+  void DeliverBatch(const InputMessage* msgs, size_t n) {
+    for (size_t i = 0; i < n; ++i) journal_.Append(msgs[i]);
+    target_.DeliverBatch(msgs, n);
+  }
+  void Idle() { target_.Idle(); }
+
+ private:
+  Journal& journal_;
+  Target& target_;
+};
+
+// Records how long it took to read and parse the messages sampled before
+// delivering them to `Target`.
+template <typename Target>
+class TimingTarget {
+ public:
+  TimingTarget(LatencyStats& stats, Target& target)
+      : stats_(stats), target_(target), sample_countdown_(1) {}
+
+  std::ostream& errors() { return target_.errors(); }
+  void CommitErrors() { target_.CommitErrors(); }
+  // Messages are delivered one at a time, so that each is timed from the end
+  // of the previous one.
+  void DeliverBatch(const InputMessage* msgs, size_t n) {
+    for (size_t i = 0; i < n; ++i) Deliver(msgs[i]);
+  }
+  void Deliver(const InputMessage& req) {
+    if (timed_) {
+      // In the order of the alternatives of `InputMessage`.
+      constexpr MessageType kTypes[] = {MessageType::kAddOrderRequest,
+                                        MessageType::kCancelOrderRequest,
+                                        MessageType::kModifyOrderRequest};
+      stats_.parse_histogram(kTypes[req.index()]).Record(ReadTsc() - last_);
+    }
+    target_.DeliverBatch(&req, 1);
+    timed_ = --sample_countdown_ == 0;
+    if (timed_) {
+      sample_countdown_ = stats_.sample_interval();
+      last_ = ReadTsc();
+    }
+  }
+  // The next message may be waited for, which isn't parsing.
+  void Idle() {
+    target_.Idle();
+    timed_ = false;
+  }
+
+ private:
+  LatencyStats& stats_;
+  Target& target_;
+  // Messages left until the next one sampled.
+  uint32_t sample_countdown_;
+  // Whether the next message is timed, from `last_`. The first one may be
+  // waited for.
+  bool timed_ = false;
+  uint64_t last_ = 0;
+};
+}  // namespace
+
+bool MatchingEngine::MarkStarted() {
   bool expected = false;
   if (!started_.compare_exchange_strong(expected, true)) {
     es_ << "Matching Engine was already started" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+template <typename Target, typename Function>
+void MatchingEngine::ReadTimed(Target& target, Function read) {
+  if (latency_stats_ == nullptr) {
+    read(target);
     return;
   }
+  TimingTarget<Target> timing_target(*latency_stats_, target);
+  read(timing_target);
+}
 
-  std::string line;
-  while (std::getline(is_, line)) {
-    auto req = parse(line, es_);
-    if (req.has_value()) {
-      std::visit([this](auto&& arg) { ob_.ProcessOrder(arg); }, *req);
-    }
+template <typename Target, typename Function>
+void MatchingEngine::Read(Target& target, Function read) {
+  if (journal_ == nullptr) {
+    ReadTimed(target, read);
+    return;
+  }
+  JournalingTarget<Target> journaling_target(*journal_, target);
+  ReadTimed(journaling_target, read);
+  journal_->Close();
+}
+
+template <typename Function>
+void MatchingEngine::Run(Function read) {
+  if (journal_options_.has_value()) {
+    journal_ = Journal::Open(*journal_options_, ob_.sequence(), es_);
+    if (journal_ == nullptr) return;
+  }
+  if (pipeline_ != nullptr) {
+    pipeline_->Start(ob_, es_, *sink_);
+    PipelineTarget target(*pipeline_);
+    Read(target, read);
+    target.CommitErrors();
+    pipeline_->Finish();
+  } else {
+    SerialTarget target(ob_, *sink_, es_);
+    Read(target, read);
+    sink_->Flush();
+  }
+  journal_.reset();
+}
+
+bool MatchingEngine::Recover(std::string_view snapshot) {
+  if (started_) {
+    es_ << "Matching Engine was already started" << std::endl;
+    return false;
+  }
+  if (!snapshot.empty() && !ob_.LoadSnapshot(snapshot)) return false;
+  if (!journal_options_.has_value()) return true;
+
+  ob_.set_muted(true);
+  auto last = ReplayJournal(
+      journal_options_->directory, ob_.sequence(),
+      [this](const InputMessage& msg) {
+        std::visit([this](const auto& req) { ob_.ProcessOrder(req); }, msg);
+      },
+      es_);
+  ob_.set_muted(false);
+  return last.has_value();
+}
+
+void MatchingEngine::Start() {
+  if (!MarkStarted()) return;
+
+  if (shm_transport_ != nullptr) {
+    Run([this](auto& target) { PollShm(*shm_transport_, target); });
+    return;
   }
+  Run([this](auto& target) { ReadInput(is_, input_format_, target); });
+}
+
+void MatchingEngine::Replay(std::string_view input) {
+  if (!MarkStarted()) return;
+
+  Run([this, input](auto& target) {
+    ProcessInput(input, input_format_, target);
+  });
 }
 
-}  // namespace mukhi::matching_engine
\ No newline at end of file
+}  // namespace mukhi::matching_engine
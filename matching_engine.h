@@ -3,11 +3,45 @@
 
 #include <atomic>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <string_view>
 
+#include "event_sink.h"
+#include "input_reader.h"
+#include "journal.h"
+#include "latency_stats.h"
 #include "order_book.h"
+#include "pipeline.h"
+#include "shm_transport.h"
 
 namespace mukhi::matching_engine {
 
+struct MatchingEngineOptions {
+  InputFormat input_format = InputFormat::kAuto;
+  OrderBookOptions order_book;
+  // Output is written out once this many bytes are buffered, and whenever the
+  // engine runs out of input to process. See `BufferedSink`.
+  size_t output_flush_threshold = BufferedSink::kDefaultFlushThreshold;
+  // Writes events as text lines or as binary frames, see `OutputFormat`.
+  OutputFormat output_format = OutputFormat::kText;
+  // Matches orders and publishes events on threads of their own, see
+  // `Pipeline`. The output is the same either way.
+  bool pipelined = false;
+  // Appends every message to a write-ahead journal before processing it, see
+  // `Journal`.
+  std::optional<JournalOptions> journal;
+  // Records the latency of messages, by stage, message type and outcome, see
+  // `LatencyStats` and `ReportLatency`. Only one in `latency_sample_interval`
+  // messages is timed.
+  bool latency_stats = false;
+  uint32_t latency_sample_interval = 1;
+  // Serves the clients of this transport: `Start` polls its input ring instead
+  // of reading `is`, and events are published to its output ring instead of
+  // being written to `os`, see `ShmTransport`. Must outlive the engine.
+  ShmTransport* shm_transport = nullptr;
+};
+
 /*
 Reads orders from the provided input stream, tries to match them with exiting
 orders and/or add them to the order book.
@@ -20,26 +54,100 @@ be successful.
 */
 class MatchingEngine {
  public:
-  MatchingEngine(std::istream& is, std::ostream& os, std::ostream& es)
-      : is_(is), os_(os), es_(es), ob_(os_, es_) {}
-
+  MatchingEngine(std::istream& is, std::ostream& os, std::ostream& es,
+                 const MatchingEngineOptions& options = {})
+      : is_(is),
+        os_(os),
+        es_(es),
+        input_format_(options.input_format),
+        journal_options_(options.journal),
+        shm_transport_(options.shm_transport),
+        sink_(shm_transport_ != nullptr
+                  ? std::make_unique<ShmEventSink>(*shm_transport_)
+                  : std::unique_ptr<EventSink>(MakeBufferedSink(
+                        os_, options.output_format,
+                        options.output_flush_threshold))),
+        pipeline_(options.pipelined ? std::make_unique<Pipeline>() : nullptr),
+        ob_(pipeline_ ? pipeline_->book_sink() : *sink_, es_,
+            options.order_book),
+        latency_stats_(options.latency_stats
+                           ? std::make_unique<LatencyStats>(
+                                 options.latency_sample_interval)
+                           : nullptr) {
+    ob_.set_latency_stats(latency_stats_.get());
+  }
   /**
   Starts the matching engine by reading from `is` and publishing trade
   events and fulfiments to `os`, and errors to `es`.
 
-  Once the function returns after processing EOF on `is_`, it can't be
-  restarted.
+  Once the function returns after processing EOF on `is_`, or once the shared
+  memory transport is closed, it can't be restarted.
 
   This is a blocking call.
   */
   void Start();
 
+  /**
+  Like `Start`, but processes the messages in `input` instead of reading them
+  from `is`. Messages are parsed in place, without copying them out of `input`,
+  which makes this the fast path for replaying files mapped into memory with
+  `MappedFile`.
+
+  Either `Start` or `Replay` can be called, and only once.
+  */
+  void Replay(std::string_view input);
+
+  /**
+  Rebuilds the order book after a restart: loads `snapshot`, if it's not empty,
+  then replays the records of the journal that follow it, if journaling is
+  enabled. Events of the messages replayed aren't published again, and neither
+  are their errors.
+
+  Returns false after reporting why to `es` if the order book can't be rebuilt,
+  in which case the engine must not be started. Must be called before `Start`
+  or `Replay`.
+  */
+  bool Recover(std::string_view snapshot = {});
+
+  // Saves a snapshot of the order book, see `OrderBook::SaveSnapshot`. Must not
+  // be called while `Start` or `Replay` are running.
+  bool SaveSnapshot(std::ostream& os) const { return ob_.SaveSnapshot(os); }
+
+  // Writes the latency histograms to `os` if they're enabled, see
+  // `LatencyStats::Report`. May be called from any thread, at any time.
+  void ReportLatency(std::ostream& os) const {
+    if (latency_stats_ != nullptr) latency_stats_->Report(os);
+  }
+
  private:
+  // Returns false if the engine was already started.
+  bool MarkStarted();
+
+  // Calls `read` with the target the messages it reads are delivered to,
+  // either straight to the order book or to the pipeline, through the journal
+  // and the parse timer if enabled. See `input_reader.h`.
+  template <typename Function>
+  void Run(Function read);
+  template <typename Target, typename Function>
+  void Read(Target& target, Function read);
+  template <typename Target, typename Function>
+  void ReadTimed(Target& target, Function read);
+
   std::istream& is_;
   std::ostream& os_;
   std::ostream& es_;
+  const InputFormat input_format_;
+  const std::optional<JournalOptions> journal_options_;
+  ShmTransport* const shm_transport_;
 
+  const std::unique_ptr<EventSink> sink_;
+  // Only set in pipelined mode.
+  std::unique_ptr<Pipeline> pipeline_;
   OrderBook ob_;
+  // Only set when latencies are recorded.
+  const std::unique_ptr<LatencyStats> latency_stats_;
+  // Only set while running with a journal.
+  std::unique_ptr<Journal> journal_;
 
   std::atomic_bool started_ = false;
 };
@@ -1,14 +1,25 @@
 #include "matching_engine.h"
 
+#include <unistd.h>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <chrono>
+#include <ctime>
 #include <filesystem>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <random>
 #include <sstream>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
+
+#include "pipeline.h"
 
 namespace mukhi::matching_engine {
 
@@ -135,4 +146,447 @@ TEST(MatchingEngineTest, NoRestart) {
   EXPECT_EQ(es.str(), expected_err);
 }
 
-}  // namespace mukhi::matching_engine
\ No newline at end of file
+TEST(MatchingEngineTest, BinaryInput) {
+  std::vector<InputMessage> msgs = {
+      AddOrderRequest{
+          .order_id = 1000000, .side = Side::kSell, .qty = 1, .price = 1075},
+      AddOrderRequest{
+          .order_id = 1000001, .side = Side::kBuy, .qty = 9, .price = 1000},
+      AddOrderRequest{
+          .order_id = 1000002, .side = Side::kSell, .qty = 2, .price = 1000},
+      CancelOrderRequest{.order_id = 1000001},
+      CancelOrderRequest{.order_id = 1000001},
+  };
+  std::string text_input =
+      "0,1000000,1,1,1075\n0,1000001,0,9,1000\n0,1000002,1,2,1000\n"
+      "1,1000001\n1,1000001\n";
+  std::string binary_input;
+  for (const InputMessage& msg : msgs) {
+    char buf[kMaxBinaryMessageSize];
+    binary_input.append(buf, EncodeBinary(msg, buf));
+  }
+
+  for (InputFormat format : {InputFormat::kAuto, InputFormat::kBinary}) {
+    std::istringstream text_is(text_input);
+    std::ostringstream text_os;
+    std::ostringstream text_es;
+    MatchingEngine text_me(text_is, text_os, text_es);
+    text_me.Start();
+
+    std::istringstream is(binary_input);
+    std::ostringstream os;
+    std::ostringstream es;
+    MatchingEngine me(is, os, es,
+                      MatchingEngineOptions{.input_format = format});
+    me.Start();
+
+    EXPECT_EQ(os.str(), "2,2,1000\n3,1000002\n4,1000001,7\n");
+    EXPECT_EQ(os.str(), text_os.str());
+    EXPECT_EQ(es.str(), "No such order with id: 1000001\n");
+    EXPECT_EQ(es.str(), text_es.str());
+  }
+}
+
+TEST(MatchingEngineTest, CorruptBinaryInput) {
+  char buf[kMaxBinaryMessageSize];
+  std::string input(
+      buf, EncodeBinary(AddOrderRequest{.order_id = 1,
+                                        .side = Side::kSell,
+                                        .qty = 1,
+                                        .price = 1075},
+                        buf));
+  input += "garbage";
+  std::istringstream is(input);
+  std::ostringstream os;
+  std::ostringstream es;
+  MatchingEngine me(is, os, es);
+  me.Start();
+
+  EXPECT_EQ(os.str(), "");
+  EXPECT_EQ(es.str(),
+            "Bad message: Corrupt binary message header, stopping\n");
+}
+
+TEST(MatchingEngineTest, Replay) {
+  std::string input =
+      "0,1000000,1,1,1075\n0,1000001,0,9,1000\n1,1000002\n"
+      "0,1000002,1,2,1000\n1,10A\n1,1000001";
+  std::istringstream stream_is(input);
+  std::ostringstream stream_os;
+  std::ostringstream stream_es;
+  MatchingEngine stream_me(stream_is, stream_os, stream_es);
+  stream_me.Start();
+
+  std::istringstream is;
+  std::ostringstream os;
+  std::ostringstream es;
+  MatchingEngine me(is, os, es);
+  me.Replay(input);
+
+  EXPECT_EQ(os.str(), "2,2,1000\n3,1000002\n4,1000001,7\n");
+  EXPECT_EQ(os.str(), stream_os.str());
+  EXPECT_EQ(es.str(), stream_es.str());
+
+  // Can't be started again.
+  me.Replay(input);
+  me.Start();
+  EXPECT_EQ(os.str(), stream_os.str());
+  EXPECT_EQ(es.str(),
+            stream_es.str() +
+                "Matching Engine was already started\n"
+                "Matching Engine was already started\n");
+}
+
+TEST(MatchingEngineTest, ReplayBinary) {
+  std::string input;
+  char buf[kMaxBinaryMessageSize];
+  input.append(buf, EncodeBinary(AddOrderRequest{.order_id = 1,
+                                                 .side = Side::kSell,
+                                                 .qty = 1,
+                                                 .price = 1075},
+                                 buf));
+  input.append(buf, EncodeBinary(AddOrderRequest{.order_id = 2,
+                                                 .side = Side::kBuy,
+                                                 .qty = 3,
+                                                 .price = 1075},
+                                 buf));
+  // Cut off the last message.
+  input.append(buf, EncodeBinary(CancelOrderRequest{.order_id = 2}, buf) - 1);
+
+  std::istringstream is;
+  std::ostringstream os;
+  std::ostringstream es;
+  MatchingEngine me(is, os, es);
+  me.Replay(input);
+
+  EXPECT_EQ(os.str(), "2,1,1075\n4,2,2\n3,1\n");
+  EXPECT_EQ(es.str(), "Bad message: Truncated binary message\n");
+}
+
+TEST(MatchingEngineTest, BinaryOutput) {
+  std::string input =
+      "0,1000000,1,1,1075\n0,1000001,0,9,1000\n0,1000002,1,2,1000.25\n"
+      "0,1000003,0,2,1075.5\n1,10A\n";
+  std::istringstream is;
+  std::ostringstream text_os;
+  std::ostringstream text_es;
+  MatchingEngine text_me(is, text_os, text_es);
+  text_me.Replay(input);
+
+  for (bool pipelined : {false, true}) {
+    std::ostringstream os;
+    std::ostringstream es;
+    MatchingEngine me(is, os, es,
+                      {.output_format = OutputFormat::kBinary,
+                       .pipelined = pipelined});
+    me.Replay(input);
+    EXPECT_EQ(es.str(), text_es.str());
+
+    std::istringstream binary(os.str());
+    std::ostringstream decoded;
+    std::ostringstream decode_es;
+    EXPECT_TRUE(DecodeBinaryEvents(binary, decoded, decode_es));
+    EXPECT_EQ(decoded.str(), text_os.str());
+    EXPECT_EQ(decode_es.str(), "");
+  }
+}
+
+TEST(MatchingEngineTest, ServesShmTransport) {
+  std::string input =
+      "0,1000000,1,1,1075\n0,1000001,0,9,1000\n0,1000002,1,2,1000.25\n"
+      "0,1000003,0,2,1075.5\n1,5\n";
+  std::istringstream is;
+  std::ostringstream text_os;
+  std::ostringstream text_es;
+  MatchingEngine text_me(is, text_os, text_es);
+  text_me.Replay(input);
+  std::string text_output = text_os.str();
+  size_t num_events =
+      std::count(text_output.begin(), text_output.end(), '\n');
+
+  for (bool pipelined : {false, true}) {
+    std::ostringstream es;
+    std::string name =
+        "/matching_engine_test_" + std::to_string(::getpid()) + "_engine";
+    auto transport = ShmTransport::Create({.name = name}, es);
+    ASSERT_NE(transport, nullptr) << es.str();
+    auto client = ShmClient::Open(name, es);
+    ASSERT_NE(client, nullptr) << es.str();
+    std::ostringstream os;
+    MatchingEngine me(is, os, es,
+                      {.pipelined = pipelined,
+                       .shm_transport = transport.get()});
+    std::thread engine([&me] { me.Start(); });
+    std::istringstream lines(input);
+    std::string line;
+    while (std::getline(lines, line)) client->Push(*parse(line, es));
+
+    std::ostringstream decoded;
+    for (size_t n = 0; n < num_events;) {
+      auto event = client->TryConsume(es);
+      if (!event.has_value()) {
+        std::this_thread::yield();
+        continue;
+      }
+      EXPECT_EQ(event->sequence, ++n);
+      std::visit(
+          [&decoded](const auto& e) {
+            char line[kMaxTextEventSize];
+            decoded << std::string_view(line, FormatText(e, line)) << "\n";
+          },
+          event->event);
+    }
+    transport->Close();
+    engine.join();
+    EXPECT_EQ(decoded.str(), text_output);
+    EXPECT_EQ(es.str(), text_es.str());
+    EXPECT_EQ(os.str(), "");
+  }
+}
+
+TEST(MatchingEngineTest, ErrorsInOrderOfMessages) {
+  // Messages are read ahead, but the errors of the order book and those of
+  // the input are still reported in order.
+  std::string text_input =
+      "1,7\n0,1,1,1,1075\n1,10A\n1,8\n0,2,0,1,1075\n5,9,1,1\n";
+  std::string binary_input;
+  auto append = [&binary_input](const InputMessage& msg) {
+    char buf[kMaxBinaryMessageSize];
+    binary_input.append(buf, EncodeBinary(msg, buf));
+  };
+  append(CancelOrderRequest{.order_id = 7});
+  append(AddOrderRequest{
+      .order_id = 1, .side = Side::kSell, .qty = 1, .price = 1075});
+  append(AddOrderRequest{
+      .order_id = 3, .side = Side::kSell, .qty = 1, .price = 1075});
+  // With an unknown side.
+  binary_input[binary_input.size() - kBinaryAddOrderRequestSize + 12] = 7;
+  append(CancelOrderRequest{.order_id = 8});
+  append(AddOrderRequest{
+      .order_id = 2, .side = Side::kBuy, .qty = 1, .price = 1075});
+  append(ModifyOrderRequest{.order_id = 9, .qty = 1, .price = 1});
+
+  for (const auto& [input, bad_message] :
+       {std::make_pair(
+            text_input,
+            "Bad message: Unparsable order id in cancel order request : 10A\n"),
+        std::make_pair(binary_input,
+                       "Bad Message: Unknown value for 'side' in add order "
+                       "request : 7\n")}) {
+    for (bool replay : {false, true}) {
+      std::istringstream is(input);
+      std::ostringstream os;
+      std::ostringstream es;
+      MatchingEngine me(is, os, es);
+      if (replay) {
+        me.Replay(input);
+      } else {
+        me.Start();
+      }
+      EXPECT_EQ(os.str(), "2,1,1075\n3,2\n3,1\n");
+      EXPECT_EQ(es.str(), "No such order with id: 7\n" +
+                              std::string(bad_message) +
+                              "No such order with id: 8\n"
+                              "No such order with id: 9\n");
+    }
+  }
+}
+
+TEST(MatchingEngineTest, PipelinedSameAsSerial) {
+  // Orders around a slowly moving price, with cancels and ill-formed lines.
+  std::mt19937_64 rng(7);
+  std::string input;
+  for (OrderId id = 1; id < 20000; ++id) {
+    switch (rng() % 8) {
+      case 0:
+        input += "1," + std::to_string(rng() % id) + "\n";
+        break;
+      case 1:
+        input += "0," + std::to_string(id) + ",1,1,bad\n";
+        break;
+      default:
+        input += "0," + std::to_string(rng() % 10 == 0 ? 1 : id) + "," +
+                 std::to_string(rng() % 2) + "," +
+                 std::to_string(1 + rng() % 50) + "," +
+                 std::to_string(1000 + id / 100 + rng() % 20) + "\n";
+    }
+  }
+
+  auto run = [&input](bool pipelined, bool replay) {
+    std::istringstream is(input);
+    std::ostringstream os;
+    std::ostringstream es;
+    MatchingEngine me(is, os, es,
+                      MatchingEngineOptions{.output_flush_threshold = 100,
+                                            .pipelined = pipelined});
+    if (replay) {
+      me.Replay(input);
+    } else {
+      me.Start();
+    }
+    return std::make_pair(os.str(), es.str());
+  };
+  auto serial = run(false, false);
+  EXPECT_NE(serial.first, "");
+  EXPECT_NE(serial.second, "");
+  EXPECT_EQ(run(true, false), serial);
+  EXPECT_EQ(run(true, true), serial);
+  EXPECT_EQ(run(false, true), serial);
+}
+
+TEST(MatchingEngineTest, IdlePipelineSleeps) {
+  std::ostringstream os;
+  std::ostringstream es;
+  BufferedTextSink output(os);
+  Pipeline pipeline;
+  OrderBook book(pipeline.book_sink(), es);
+  pipeline.Start(book, es, output);
+
+  // With no input, the matching and publishing threads sleep instead of
+  // spinning.
+  std::clock_t start = std::clock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  EXPECT_LT(std::clock() - start, CLOCKS_PER_SEC / 10);
+
+  // And wake up for the next message.
+  pipeline.Push(AddOrderRequest{
+      .order_id = 1, .side = Side::kBuy, .qty = 1, .price = 10});
+  pipeline.Push(AddOrderRequest{
+      .order_id = 2, .side = Side::kSell, .qty = 1, .price = 10});
+  pipeline.Finish();
+  EXPECT_NE(os.str(), "");
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST(MatchingEngineTest, LatencyStats) {
+  std::string input =
+      "0,1000000,1,1,1075\n0,1000001,0,9,1000\n1,1000002\n"
+      "0,1000002,1,2,1000\n1,10A\n1,1000001\n";
+  for (bool pipelined : {false, true}) {
+    std::istringstream expected_is(input);
+    std::ostringstream expected_os;
+    std::ostringstream expected_es;
+    MatchingEngine(expected_is, expected_os, expected_es).Start();
+
+    std::istringstream is(input);
+    std::ostringstream os;
+    std::ostringstream es;
+    MatchingEngine me(is, os, es,
+                      {.pipelined = pipelined, .latency_stats = true});
+    me.Start();
+    EXPECT_EQ(os.str(), expected_os.str());
+    EXPECT_EQ(es.str(), expected_es.str());
+
+    std::ostringstream report;
+    me.ReportLatency(report);
+    // The count of every stage, message type and outcome recorded. The first
+    // message isn't timed parsing, since it may have been waited for.
+    std::map<std::string, uint64_t> counts;
+    std::istringstream lines(report.str());
+    std::string line;
+    std::getline(lines, line);
+    while (std::getline(lines, line)) {
+      std::istringstream fields(line);
+      std::string stage, type, outcome;
+      uint64_t count;
+      fields >> stage >> type >> outcome >> count;
+      counts[stage + " " + type + " " + outcome] = count;
+    }
+    EXPECT_EQ(counts, (std::map<std::string, uint64_t>{
+                          {"parse add -", 2},
+                          {"parse cancel -", 2},
+                          {"match add rested", 2},
+                          {"match add fully_filled", 1},
+                          {"match cancel canceled", 1},
+                          {"match cancel rejected", 1},
+                          {"book_update add rested", 2},
+                          {"book_update cancel canceled", 1},
+                          {"publish add fully_filled", 1},
+                          {"total add rested", 2},
+                          {"total add fully_filled", 1},
+                          {"total cancel canceled", 1},
+                          {"total cancel rejected", 1},
+                      }))
+        << report.str();
+  }
+
+  // Nothing is reported unless enabled.
+  std::istringstream is(input);
+  std::ostringstream os;
+  MatchingEngine me(is, os, os);
+  me.Start();
+  std::ostringstream report;
+  me.ReportLatency(report);
+  EXPECT_EQ(report.str(), "");
+}
+
+TEST(MatchingEngineTest, RecoversFromJournal) {
+  std::mt19937_64 rng(11);
+  std::string parts[3];
+  for (OrderId id = 1; id < 6000; ++id) {
+    std::string& part = parts[id * 3 / 6000];
+    switch (rng() % 8) {
+      case 0:
+        part += "1," + std::to_string(rng() % id) + "\n";
+        break;
+      case 1:
+        part += "0," + std::to_string(id) + ",1,1,bad\n";
+        break;
+      default:
+        part += "0," + std::to_string(id) + "," + std::to_string(rng() % 2) +
+                "," + std::to_string(1 + rng() % 50) + "," +
+                std::to_string(1000 + id / 100 + rng() % 20) + "\n";
+    }
+  }
+  std::string input = parts[0] + parts[1] + parts[2];
+  std::istringstream is(input);
+  std::ostringstream expected_os;
+  std::ostringstream expected_es;
+  MatchingEngine(is, expected_os, expected_es).Replay(input);
+
+  fs::path journal = fs::temp_directory_path() / "matching_engine_journal";
+  fs::remove_all(journal);
+  fs::create_directories(journal);
+  for (bool pipelined : {false, true}) {
+    MatchingEngineOptions options{
+        .pipelined = pipelined,
+        .journal = JournalOptions{.directory = journal, .segment_size = 4096}};
+    std::ostringstream os;
+    std::ostringstream es;
+    std::string snapshot;
+    // Every run picks up where the previous one left off: the first from
+    // scratch, the second from a snapshot, and the third from that same
+    // snapshot and the journal of the second.
+    for (const std::string& part : parts) {
+      MatchingEngine me(is, os, es, options);
+      ASSERT_TRUE(me.Recover(snapshot)) << es.str();
+      me.Replay(part);
+      if (snapshot.empty()) {
+        std::ostringstream snapshot_os;
+        ASSERT_TRUE(me.SaveSnapshot(snapshot_os));
+        snapshot = snapshot_os.str();
+      }
+    }
+    EXPECT_EQ(os.str(), expected_os.str());
+    EXPECT_EQ(es.str(), expected_es.str());
+    fs::remove_all(journal);
+    fs::create_directories(journal);
+  }
+
+  // The journal must be replayed before processing more messages.
+  MatchingEngineOptions options{
+      .journal = JournalOptions{.directory = journal}};
+  {
+    MatchingEngine me(is, expected_os, expected_es, options);
+    me.Replay(parts[0]);
+  }
+  std::ostringstream os;
+  std::ostringstream es;
+  MatchingEngine me(is, os, es, options);
+  me.Replay(parts[1]);
+  EXPECT_EQ(os.str(), "");
+  EXPECT_THAT(es.str(), ::testing::StartsWith("The journal has records up to"));
+  fs::remove_all(journal);
+}
+
+}  // namespace mukhi::matching_engine
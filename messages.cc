@@ -1,7 +1,13 @@
 #include "messages.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
 #include <charconv>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <string_view>
 
@@ -11,6 +17,8 @@ namespace {
 constexpr uint32_t kErrLimit = 50;
 
 uint32_t to_num(const MessageType& t) { return static_cast<uint32_t>(t); }
+uint32_t to_num(uint8_t t) { return t; }
+uint32_t to_num(const Side& s) { return static_cast<uint32_t>(s); }
 MessageType to_msg_type(uint32_t t) {
   switch (t) {
     case 0:
@@ -23,6 +31,12 @@ MessageType to_msg_type(uint32_t t) {
       return MessageType::kOrderFullyFilled;
     case 4:
       return MessageType::kOrderPartiallyFilled;
+    case 5:
+      return MessageType::kModifyOrderRequest;
+    case 6:
+      return MessageType::kDepthUpdate;
+    case 7:
+      return MessageType::kBboUpdate;
     default:
       return MessageType::kUndefined;
   }
@@ -39,6 +53,66 @@ Side to_side_type(uint8_t t) {
   }
 }
 
+// Parses the `price[,symbol]` fields that end the add and modify order
+// requests, `request` names the request in error messages.
+bool ParsePriceAndSymbol(std::string_view input, std::string_view request,
+                         Price& price, Symbol& symbol, std::ostream& es) {
+  // An empty trailing field is left to fail as part of the price.
+  size_t pos = input.find(",");
+  if (pos != std::string::npos && pos + 1 < input.size()) {
+    auto parsed_symbol = Symbol::FromString(input.substr(pos + 1));
+    if (!parsed_symbol.has_value()) {
+      es << "Bad Message: Unparsable 'symbol' in " << request << " : "
+         << input.substr(pos + 1, kErrLimit) << std::endl;
+      return false;
+    }
+    symbol = *parsed_symbol;
+    input = input.substr(0, pos);
+  }
+
+  // Plain decimals, i.e. nearly all prices, are parsed in fixed point.
+  if (auto units = ParseFixedPoint(input, kPriceDecimals); units.has_value()) {
+    price = FixedPointToPrice(*units, kPriceDecimals);
+    return true;
+  }
+  // Anything else is left to `std::strtod`, which accepts what `std::stod`
+  // did, e.g. exponents and signs, and is reported the way `std::stod` did
+  // when it threw. `std::strtod` skips leading whitespaces, which aren't
+  // allowed, and `std::from_chars` isn't available for floating points in the
+  // libc++ used on mac os (dev environment).
+  if (input.empty() || std::isspace(static_cast<unsigned char>(input[0]))) {
+    es << "Bad Message: Unparsable 'price' in " << request << " : " << input
+       << std::endl;
+    return false;
+  }
+  // `input` isn't null-terminated when it's a slice of a larger buffer, so the
+  // price is copied out, on the stack unless it's unusually long.
+  char buffer[64];
+  std::string long_input;
+  const char* begin = buffer;
+  if (input.size() < sizeof(buffer)) {
+    std::memcpy(buffer, input.data(), input.size());
+    buffer[input.size()] = '\0';
+  } else {
+    long_input = input;
+    begin = long_input.c_str();
+  }
+  char* end;
+  errno = 0;
+  price = std::strtod(begin, &end);
+  if (end == begin || errno == ERANGE) {
+    es << "Bad Message: exception while parsing 'price': stod" << std::endl;
+    return false;
+  }
+  pos = end - begin;
+  if (input.size() != pos) {
+    es << "Bad Message: Unparsable " << request << " : "
+       << input.substr(0, kErrLimit) << std::endl;
+    return false;
+  }
+  return true;
+}
+
 std::optional<AddOrderRequest> ParseAddOrderRequest(std::string_view input,
                                                     std::ostream& es) {
   size_t pos = input.find(",");
@@ -88,52 +162,314 @@ std::optional<AddOrderRequest> ParseAddOrderRequest(std::string_view input,
        << std::endl;
     return std::nullopt;
   }
-  input = input.substr(pos + 1);
+  if (!ParsePriceAndSymbol(input.substr(pos + 1), "add order request",
+                           req.price, req.symbol, es)) {
+    return std::nullopt;
+  }
+  return req;
+}
 
-  // Note that `std::from_chars` isn't available for floating points in libc++
-  // standard library used by clang on mac os (dev environment). Therefore, we
-  // will rely on `std::stod` for parsing `price`. As such we must check for
-  // leading whitespaces, and trailing whitespaces as well as non-numeric
-  // characters.
-  try {
-    if (std::isspace(input.at(0))) {
-      es << "Bad Message: Unparsable 'price' in add order request : " << input
-         << std::endl;
+std::optional<CancelOrderRequest> ParseCancelOrderRequest(
+    std::string_view input, std::ostream& es) {
+  CancelOrderRequest req;
+  if (size_t pos = input.find(",");
+      pos != std::string::npos && pos + 1 < input.size()) {
+    auto symbol = Symbol::FromString(input.substr(pos + 1));
+    if (!symbol.has_value()) {
+      es << "Bad message: Unparsable 'symbol' in cancel order request : "
+         << input.substr(pos + 1, kErrLimit) << std::endl;
       return std::nullopt;
     }
-    req.price = std::stod(input.data(), &pos);
-  } catch (const std::invalid_argument& e) {
-    es << "Bad Message: exception while parsing 'price': " << e.what()
+    req.symbol = *symbol;
+    input = input.substr(0, pos);
+  }
+  auto [ptr, ec] =
+      std::from_chars(input.data(), input.data() + input.size(), req.order_id);
+  if (ec != std::errc() || ptr != input.data() + input.size()) {
+    es << "Bad message: Unparsable order id in cancel order request : " << input
        << std::endl;
     return std::nullopt;
-  } catch (const std::out_of_range& e) {
-    es << "Bad Message: exception while parsing 'price': " << e.what()
-       << std::endl;
+  }
+  return req;
+}
+
+std::optional<ModifyOrderRequest> ParseModifyOrderRequest(
+    std::string_view input, std::ostream& es) {
+  size_t pos = input.find(",");
+  if (pos == std::string::npos) {
+    es << "Bad Message: Unparsable modify order request : "
+       << input.substr(0, kErrLimit) << std::endl;
     return std::nullopt;
   }
-  if (input.size() != pos) {
-    es << "Bad Message: Unparsable add order request : "
+  ModifyOrderRequest req;
+  auto result = std::from_chars(input.data(), input.data() + pos, req.order_id);
+  if (result.ec != std::errc() || result.ptr != input.data() + pos) {
+    es << "Bad Message: Unparsable order id in modify order request : "
+       << input << std::endl;
+    return std::nullopt;
+  }
+  input = input.substr(pos + 1);
+  pos = input.find(",");
+  if (pos == std::string::npos) {
+    es << "Bad Message: Unparsable modify order request : "
        << input.substr(0, kErrLimit) << std::endl;
     return std::nullopt;
   }
+  result = std::from_chars(input.data(), input.data() + pos, req.qty);
+  if (result.ec != std::errc() || result.ptr != input.data() + pos) {
+    es << "Bad Message: Unparsable 'quantity' in modify order request: "
+       << input << std::endl;
+    return std::nullopt;
+  }
+  if (!ParsePriceAndSymbol(input.substr(pos + 1), "modify order request",
+                           req.price, req.symbol, es)) {
+    return std::nullopt;
+  }
   return req;
 }
 
-std::optional<CancelOrderRequest> ParseCancelOrderRequest(
-    std::string_view input, std::ostream& es) {
-  OrderId order_id;
-  auto [ptr, ec] =
-      std::from_chars(input.data(), input.data() + input.size(), order_id);
-  if (ec != std::errc() || ptr != input.data() + input.size()) {
-    es << "Bad message: Unparsable order id in cancel order request : " << input
-       << std::endl;
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "The binary format is decoded with plain copies of the fields, "
+              "which requires a little-endian host.");
+
+// Copies a field of the binary format to or from its position in a frame.
+template <typename T>
+void Store(char* frame, size_t offset, T value) {
+  std::memcpy(frame + offset, &value, sizeof(T));
+}
+template <typename T>
+T Load(std::string_view frame, size_t offset) {
+  T value;
+  std::memcpy(&value, frame.data() + offset, sizeof(T));
+  return value;
+}
+
+// Offsets of the fields in a binary frame.
+constexpr size_t kMagicOffset = 0;
+constexpr size_t kTypeOffset = 1;
+constexpr size_t kLengthOffset = 2;
+constexpr size_t kOrderIdOffset = 4;
+constexpr size_t kSideOffset = 12;
+constexpr size_t kQuantityOffset = 13;
+constexpr size_t kPriceOffset = 21;
+// Modify order requests have no side.
+constexpr size_t kModifyQuantityOffset = 12;
+constexpr size_t kModifyPriceOffset = 20;
+
+void StoreSymbol(char* frame, size_t offset, const Symbol& symbol) {
+  std::memset(frame + offset, 0, Symbol::kMaxSize);
+  std::string_view s = symbol.view();
+  std::memcpy(frame + offset, s.data(), s.size());
+}
+
+// Decodes the symbol at the end of a frame of `short_size` bytes plus a
+// symbol, or the default symbol for a frame of `short_size` bytes.
+std::optional<Symbol> LoadSymbol(std::string_view frame, size_t short_size) {
+  if (frame.size() == short_size) return Symbol();
+  std::string_view s = frame.substr(short_size);
+  return Symbol::FromString(s.substr(0, strnlen(s.data(), s.size())));
+}
+
+void StoreHeader(char* frame, MessageType type, uint16_t length) {
+  Store<uint8_t>(frame, kMagicOffset, kBinaryMagic);
+  Store<uint8_t>(frame, kTypeOffset, static_cast<uint8_t>(type));
+  Store<uint16_t>(frame, kLengthOffset, length);
+}
+
+}  // namespace
+
+size_t EncodeBinary(const InputMessage& msg, char* out) {
+  if (const auto* add = std::get_if<AddOrderRequest>(&msg)) {
+    size_t length = kBinaryAddOrderRequestSize;
+    if (!add->symbol.empty()) {
+      StoreSymbol(out, length, add->symbol);
+      length += Symbol::kMaxSize;
+    }
+    StoreHeader(out, MessageType::kAddOrderRequest, length);
+    Store<uint64_t>(out, kOrderIdOffset, add->order_id);
+    Store<uint8_t>(out, kSideOffset, static_cast<uint8_t>(add->side));
+    Store<uint64_t>(out, kQuantityOffset, add->qty);
+    Store<double>(out, kPriceOffset, add->price);
+    return length;
+  }
+  if (const auto* modify = std::get_if<ModifyOrderRequest>(&msg)) {
+    size_t length = kBinaryModifyOrderRequestSize;
+    if (!modify->symbol.empty()) {
+      StoreSymbol(out, length, modify->symbol);
+      length += Symbol::kMaxSize;
+    }
+    StoreHeader(out, MessageType::kModifyOrderRequest, length);
+    Store<uint64_t>(out, kOrderIdOffset, modify->order_id);
+    Store<uint64_t>(out, kModifyQuantityOffset, modify->qty);
+    Store<double>(out, kModifyPriceOffset, modify->price);
+    return length;
+  }
+  const auto& cancel = std::get<CancelOrderRequest>(msg);
+  size_t length = kBinaryCancelOrderRequestSize;
+  if (!cancel.symbol.empty()) {
+    StoreSymbol(out, length, cancel.symbol);
+    length += Symbol::kMaxSize;
+  }
+  StoreHeader(out, MessageType::kCancelOrderRequest, length);
+  Store<uint64_t>(out, kOrderIdOffset, cancel.order_id);
+  return length;
+}
+
+size_t BinaryMessageLength(const char* header) {
+  std::string_view h(header, kBinaryHeaderSize);
+  size_t length = Load<uint16_t>(h, kLengthOffset);
+  if (Load<uint8_t>(h, kMagicOffset) != kBinaryMagic ||
+      length < kBinaryHeaderSize) {
+    return 0;
+  }
+  return length;
+}
+
+std::optional<InputMessage> ParseBinary(std::string_view input,
+                                        std::ostream& es) {
+  if (input.size() < kBinaryHeaderSize ||
+      BinaryMessageLength(input.data()) != input.size()) {
+    es << "Bad message: Corrupt binary message header" << std::endl;
     return std::nullopt;
   }
-  return CancelOrderRequest{.order_id = order_id};
+  uint8_t type = Load<uint8_t>(input, kTypeOffset);
+  switch (to_msg_type(type)) {
+    case MessageType::kAddOrderRequest: {
+      if (input.size() != kBinaryAddOrderRequestSize &&
+          input.size() != kBinaryAddOrderRequestSize + Symbol::kMaxSize) {
+        es << "Bad Message: Unparsable add order request, length : "
+           << input.size() << std::endl;
+        return std::nullopt;
+      }
+      AddOrderRequest req;
+      auto symbol = LoadSymbol(input, kBinaryAddOrderRequestSize);
+      if (!symbol.has_value()) {
+        es << "Bad Message: Unparsable 'symbol' in add order request"
+           << std::endl;
+        return std::nullopt;
+      }
+      req.symbol = *symbol;
+      req.order_id = Load<uint64_t>(input, kOrderIdOffset);
+      uint8_t side = Load<uint8_t>(input, kSideOffset);
+      req.side = to_side_type(side);
+      if (req.side == Side::kUndefined) {
+        es << "Bad Message: Unknown value for 'side' in add order request : "
+           << to_num(side) << std::endl;
+        return std::nullopt;
+      }
+      req.qty = Load<uint64_t>(input, kQuantityOffset);
+      req.price = Load<double>(input, kPriceOffset);
+      return req;
+    }
+    case MessageType::kCancelOrderRequest: {
+      if (input.size() != kBinaryCancelOrderRequestSize &&
+          input.size() != kBinaryCancelOrderRequestSize + Symbol::kMaxSize) {
+        es << "Bad message: Unparsable cancel order request, length : "
+           << input.size() << std::endl;
+        return std::nullopt;
+      }
+      auto symbol = LoadSymbol(input, kBinaryCancelOrderRequestSize);
+      if (!symbol.has_value()) {
+        es << "Bad message: Unparsable 'symbol' in cancel order request"
+           << std::endl;
+        return std::nullopt;
+      }
+      return CancelOrderRequest{
+          .order_id = Load<uint64_t>(input, kOrderIdOffset),
+          .symbol = *symbol};
+    }
+    case MessageType::kModifyOrderRequest: {
+      if (input.size() != kBinaryModifyOrderRequestSize &&
+          input.size() != kBinaryModifyOrderRequestSize + Symbol::kMaxSize) {
+        es << "Bad Message: Unparsable modify order request, length : "
+           << input.size() << std::endl;
+        return std::nullopt;
+      }
+      auto symbol = LoadSymbol(input, kBinaryModifyOrderRequestSize);
+      if (!symbol.has_value()) {
+        es << "Bad Message: Unparsable 'symbol' in modify order request"
+           << std::endl;
+        return std::nullopt;
+      }
+      return ModifyOrderRequest{
+          .order_id = Load<uint64_t>(input, kOrderIdOffset),
+          .qty = Load<uint64_t>(input, kModifyQuantityOffset),
+          .price = Load<double>(input, kModifyPriceOffset),
+          .symbol = *symbol};
+    }
+    default:
+      es << "Bad message: Invalid type : " << to_num(type) << std::endl;
+      return std::nullopt;
+  }
 }
 
+std::optional<Symbol> Symbol::FromString(std::string_view s) {
+  if (s.empty() || s.size() > kMaxSize) return std::nullopt;
+  Symbol symbol;
+  for (size_t i = 0; i < s.size(); ++i) {
+    // Printable characters, except space, and commas which separate fields.
+    if (s[i] <= ' ' || s[i] > '~' || s[i] == ',') return std::nullopt;
+    symbol.chars_[i] = s[i];
+  }
+  return symbol;
+}
+
+namespace {
+constexpr uint64_t kPowersOfTen[] = {
+    1,
+    10,
+    100,
+    1000,
+    10000,
+    100000,
+    1000000,
+    10000000,
+    100000000,
+    1000000000,
+    10000000000,
+    100000000000,
+    1000000000000,
+    10000000000000,
+    100000000000000,
+    1000000000000000,
+    10000000000000000,
+    100000000000000000,
+    1000000000000000000,
+    10000000000000000000u};
+static_assert(std::size(kPowersOfTen) > kMaxFixedPointDecimals);
 }  // namespace
 
+std::optional<uint64_t> ParseFixedPoint(std::string_view input, int decimals) {
+  // More digits could overflow, and can't make for few enough units anyway
+  // unless they're leading zeros.
+  if (input.empty() || input.size() > 19) return std::nullopt;
+  uint64_t units = 0;
+  int fraction_digits = -1;
+  bool seen_digit = false;
+  for (char c : input) {
+    uint32_t digit = static_cast<uint8_t>(c) - static_cast<uint32_t>('0');
+    if (digit <= 9) {
+      units = units * 10 + digit;
+      seen_digit = true;
+      fraction_digits += fraction_digits >= 0;
+    } else if (c == '.' && fraction_digits < 0) {
+      fraction_digits = 0;
+    } else {
+      return std::nullopt;
+    }
+  }
+  fraction_digits = std::max(fraction_digits, 0);
+  if (!seen_digit || fraction_digits > decimals) return std::nullopt;
+  uint64_t scale = kPowersOfTen[decimals - fraction_digits];
+  if (units > kMaxFixedPointUnits / scale) return std::nullopt;
+  return units * scale;
+}
+
+Price FixedPointToPrice(uint64_t units, int decimals) {
+  return static_cast<double>(units) /
+         static_cast<double>(kPowersOfTen[decimals]);
+}
+
 std::optional<InputMessage> parse(std::string_view input, std::ostream& es) {
   size_t pos = input.find(",");
   if (pos == std::string::npos) {
@@ -153,6 +489,8 @@ std::optional<InputMessage> parse(std::string_view input, std::ostream& es) {
       return ParseAddOrderRequest(input.substr(pos + 1), es);
     case MessageType::kCancelOrderRequest:
       return ParseCancelOrderRequest(input.substr(pos + 1), es);
+    case MessageType::kModifyOrderRequest:
+      return ParseModifyOrderRequest(input.substr(pos + 1), es);
     default:
       es << "Bad message: Invalid type : " << input.substr(0, kErrLimit)
          << std::endl;
@@ -160,20 +498,359 @@ std::optional<InputMessage> parse(std::string_view input, std::ostream& es) {
   }
 }
 
+namespace {
+// Longest price: the shortest text of a double is at most 24 characters.
+constexpr size_t kMaxPriceSize = 24;
+
+// The digits of 0 to 99, two per number.
+struct DigitPairs {
+  constexpr DigitPairs() : chars() {
+    for (int i = 0; i < 100; ++i) {
+      chars[2 * i] = static_cast<char>('0' + i / 10);
+      chars[2 * i + 1] = static_cast<char>('0' + i % 10);
+    }
+  }
+  char chars[200];
+};
+constexpr DigitPairs kDigitPairs;
+
+// Writes the two digits of `value`, which must be below 100.
+void WriteDigitPair(char* p, uint64_t value) {
+  std::memcpy(p, &kDigitPairs.chars[2 * value], 2);
+}
+
+int NumDigits(uint64_t value) {
+  // log10(2) is about 1233 / 4096. `value | 1` has as many digits as `value`,
+  // but one for 0.
+  int bits = 64 - __builtin_clzll(value | 1);
+  int digits = (bits * 1233) >> 12;
+  return digits + ((value | 1) >= kPowersOfTen[digits]);
+}
+
+char* Append(char* p, uint64_t value) {
+  char* end = p + NumDigits(value);
+  char* q = end;
+  while (value >= 100) {
+    q -= 2;
+    WriteDigitPair(q, value % 100);
+    value /= 100;
+  }
+  if (value >= 10) {
+    WriteDigitPair(q - 2, value);
+  } else {
+    q[-1] = static_cast<char>('0' + value);
+  }
+  return end;
+}
+
+char* Append(char* p, Side side) {
+  *p = static_cast<char>('0' + to_num(side));
+  return p + 1;
+}
+
+char* Append(char* p, MessageType type) {
+  *p = static_cast<char>('0' + to_num(type));
+  return p + 1;
+}
+
+// Appends `,symbol`, or nothing for the default instrument.
+char* Append(char* p, const Symbol& symbol) {
+  if (symbol.empty()) return p;
+  *p++ = ',';
+  std::string_view s = symbol.view();
+  std::memcpy(p, s.data(), s.size());
+  return p + s.size();
+}
+
+char* AppendPrice(char* p, Price price) {
+  constexpr uint64_t kScale = kPowersOfTen[kPriceDecimals];
+  double scaled = price * static_cast<double>(kScale);
+  // Rounding `scaled` finds the units of the price, if it has any.
+  if (scaled >= 0 && scaled <= static_cast<double>(kMaxFixedPointUnits)) {
+    uint64_t units = static_cast<uint64_t>(scaled + 0.5);
+    if (FixedPointToPrice(units, kPriceDecimals) == price) {
+      p = Append(p, units / kScale);
+      uint64_t fraction = units % kScale;
+      if (fraction == 0) return p;
+      *p++ = '.';
+      // All the decimal places, then without the trailing zeros.
+      for (int i = kPriceDecimals; i > 0; i -= 2) {
+        WriteDigitPair(p + i - 2, fraction % 100);
+        fraction /= 100;
+      }
+      p += kPriceDecimals;
+      while (p[-1] == '0') --p;
+      return p;
+    }
+  }
+  return std::to_chars(p, p + kMaxPriceSize, price).ptr;
+}
+
+// Writes `event` on `os` in the text format.
+template <typename Event>
+std::ostream& WriteText(std::ostream& os, const Event& event) {
+  char text[kMaxTextEventSize];
+  return os.write(text, FormatText(event, text));
+}
+}  // namespace
+
+static_assert(kPriceDecimals % 2 == 0,
+              "Decimal places of prices are written two at a time.");
+
+size_t FormatText(const TradeEvent& event, char* out) {
+  char* p = Append(out, MessageType::kTradeEvent);
+  *p++ = ',';
+  p = Append(p, event.qty);
+  *p++ = ',';
+  p = AppendPrice(p, event.price);
+  return Append(p, event.symbol) - out;
+}
+
+size_t FormatText(const OrderFullyFilled& event, char* out) {
+  char* p = Append(out, MessageType::kOrderFullyFilled);
+  *p++ = ',';
+  p = Append(p, event.order_id);
+  return Append(p, event.symbol) - out;
+}
+
+size_t FormatText(const OrderPartiallyFilled& event, char* out) {
+  char* p = Append(out, MessageType::kOrderPartiallyFilled);
+  *p++ = ',';
+  p = Append(p, event.order_id);
+  *p++ = ',';
+  p = Append(p, event.remaining);
+  return Append(p, event.symbol) - out;
+}
+
+size_t FormatText(const DepthUpdate& event, char* out) {
+  char* p = Append(out, MessageType::kDepthUpdate);
+  *p++ = ',';
+  p = Append(p, event.side);
+  *p++ = ',';
+  p = AppendPrice(p, event.price);
+  *p++ = ',';
+  p = Append(p, event.qty);
+  *p++ = ',';
+  p = Append(p, event.num_orders);
+  return Append(p, event.symbol) - out;
+}
+
+size_t FormatText(const Bbo& event, char* out) {
+  char* p = Append(out, MessageType::kBboUpdate);
+  for (const DepthLevel* level : {&event.bid, &event.ask}) {
+    *p++ = ',';
+    p = AppendPrice(p, level->price);
+    *p++ = ',';
+    p = Append(p, level->qty);
+    *p++ = ',';
+    p = Append(p, level->num_orders);
+  }
+  return Append(p, event.symbol) - out;
+}
+
 std::ostream& operator<<(std::ostream& os, const TradeEvent& obj) {
-  os << to_num(MessageType::kTradeEvent) << "," << obj.qty << "," << obj.price;
-  return os;
+  return WriteText(os, obj);
 }
 
 std::ostream& operator<<(std::ostream& os, const OrderFullyFilled& obj) {
-  os << to_num(MessageType::kOrderFullyFilled) << "," << obj.order_id;
-  return os;
+  return WriteText(os, obj);
 }
 
 std::ostream& operator<<(std::ostream& os, const OrderPartiallyFilled& obj) {
-  os << to_num(MessageType::kOrderPartiallyFilled) << "," << obj.order_id << ","
-     << obj.remaining;
-  return os;
+  return WriteText(os, obj);
+}
+
+std::ostream& operator<<(std::ostream& os, const DepthUpdate& obj) {
+  return WriteText(os, obj);
+}
+
+std::ostream& operator<<(std::ostream& os, const Bbo& obj) {
+  return WriteText(os, obj);
+}
+
+namespace {
+constexpr size_t kSequenceOffset = 4;
+constexpr size_t kEventFieldsOffset = 12;
+
+// Writes the fields of an event frame one after the other.
+class EventWriter {
+ public:
+  EventWriter(char* frame, uint64_t sequence) : frame_(frame) {
+    Store<uint64_t>(frame_, kSequenceOffset, sequence);
+  }
+
+  template <typename T>
+  void Put(T value) {
+    Store<T>(frame_, offset_, value);
+    offset_ += sizeof(T);
+  }
+  void Put(const DepthLevel& level) {
+    Put<double>(level.price);
+    Put<uint64_t>(level.qty);
+    Put<uint64_t>(level.num_orders);
+  }
+  // Adds the symbol and the header, returns the length of the frame.
+  size_t Finish(MessageType type, const Symbol& symbol) {
+    if (!symbol.empty()) {
+      StoreSymbol(frame_, offset_, symbol);
+      offset_ += Symbol::kMaxSize;
+    }
+    StoreHeader(frame_, type, offset_);
+    return offset_;
+  }
+
+ private:
+  char* const frame_;
+  size_t offset_ = kEventFieldsOffset;
+};
+
+// Reads the fields of an event frame one after the other.
+class EventReader {
+ public:
+  explicit EventReader(std::string_view frame) : frame_(frame) {}
+
+  template <typename T>
+  T Get() {
+    T value = Load<T>(frame_, offset_);
+    offset_ += sizeof(T);
+    return value;
+  }
+  DepthLevel GetLevel() {
+    DepthLevel level;
+    level.price = Get<double>();
+    level.qty = Get<uint64_t>();
+    level.num_orders = Get<uint64_t>();
+    return level;
+  }
+
+ private:
+  const std::string_view frame_;
+  size_t offset_ = kEventFieldsOffset;
+};
+
+// The size of frames of events of `type` without a symbol, 0 if events of
+// `type` aren't output events.
+size_t BinaryEventSize(MessageType type) {
+  switch (type) {
+    case MessageType::kTradeEvent:
+      return kBinaryTradeEventSize;
+    case MessageType::kOrderFullyFilled:
+      return kBinaryOrderFullyFilledSize;
+    case MessageType::kOrderPartiallyFilled:
+      return kBinaryOrderPartiallyFilledSize;
+    case MessageType::kDepthUpdate:
+      return kBinaryDepthUpdateSize;
+    case MessageType::kBboUpdate:
+      return kBinaryBboSize;
+    default:
+      return 0;
+  }
+}
+}  // namespace
+
+size_t EncodeBinary(const TradeEvent& event, uint64_t sequence, char* out) {
+  EventWriter writer(out, sequence);
+  writer.Put<uint64_t>(event.qty);
+  writer.Put<double>(event.price);
+  return writer.Finish(MessageType::kTradeEvent, event.symbol);
+}
+
+size_t EncodeBinary(const OrderFullyFilled& event, uint64_t sequence,
+                    char* out) {
+  EventWriter writer(out, sequence);
+  writer.Put<uint64_t>(event.order_id);
+  return writer.Finish(MessageType::kOrderFullyFilled, event.symbol);
+}
+
+size_t EncodeBinary(const OrderPartiallyFilled& event, uint64_t sequence,
+                    char* out) {
+  EventWriter writer(out, sequence);
+  writer.Put<uint64_t>(event.order_id);
+  writer.Put<uint64_t>(event.remaining);
+  return writer.Finish(MessageType::kOrderPartiallyFilled, event.symbol);
+}
+
+size_t EncodeBinary(const DepthUpdate& event, uint64_t sequence, char* out) {
+  EventWriter writer(out, sequence);
+  writer.Put<uint8_t>(static_cast<uint8_t>(event.side));
+  writer.Put<double>(event.price);
+  writer.Put<uint64_t>(event.qty);
+  writer.Put<uint64_t>(event.num_orders);
+  return writer.Finish(MessageType::kDepthUpdate, event.symbol);
+}
+
+size_t EncodeBinary(const Bbo& event, uint64_t sequence, char* out) {
+  EventWriter writer(out, sequence);
+  writer.Put(event.bid);
+  writer.Put(event.ask);
+  return writer.Finish(MessageType::kBboUpdate, event.symbol);
+}
+
+std::optional<SequencedEvent> ParseBinaryEvent(std::string_view input,
+                                               std::ostream& es) {
+  if (input.size() < kBinaryHeaderSize ||
+      BinaryMessageLength(input.data()) != input.size()) {
+    es << "Bad message: Corrupt binary message header" << std::endl;
+    return std::nullopt;
+  }
+  uint8_t type = Load<uint8_t>(input, kTypeOffset);
+  size_t size = BinaryEventSize(to_msg_type(type));
+  if (size == 0) {
+    es << "Bad message: Invalid type : " << to_num(type) << std::endl;
+    return std::nullopt;
+  }
+  if (input.size() != size && input.size() != size + Symbol::kMaxSize) {
+    es << "Bad message: Unparsable event of type " << to_num(type)
+       << ", length : " << input.size() << std::endl;
+    return std::nullopt;
+  }
+  auto symbol = LoadSymbol(input, size);
+  if (!symbol.has_value()) {
+    es << "Bad message: Unparsable 'symbol' in event of type "
+       << to_num(type) << std::endl;
+    return std::nullopt;
+  }
+  EventReader reader(input);
+  // The fields are read in the order of the initializers, which braced
+  // initialization guarantees.
+  OutputEvent event;
+  switch (to_msg_type(type)) {
+    case MessageType::kTradeEvent:
+      event = TradeEvent{.qty = reader.Get<uint64_t>(),
+                         .price = reader.Get<double>(),
+                         .symbol = *symbol};
+      break;
+    case MessageType::kOrderFullyFilled:
+      event = OrderFullyFilled{.order_id = reader.Get<uint64_t>(),
+                               .symbol = *symbol};
+      break;
+    case MessageType::kOrderPartiallyFilled:
+      event = OrderPartiallyFilled{.order_id = reader.Get<uint64_t>(),
+                                   .remaining = reader.Get<uint64_t>(),
+                                   .symbol = *symbol};
+      break;
+    case MessageType::kDepthUpdate: {
+      uint8_t side = reader.Get<uint8_t>();
+      if (to_side_type(side) == Side::kUndefined) {
+        es << "Bad message: Unknown value for 'side' in depth update : "
+           << to_num(side) << std::endl;
+        return std::nullopt;
+      }
+      event = DepthUpdate{.side = to_side_type(side),
+                          .price = reader.Get<double>(),
+                          .qty = reader.Get<uint64_t>(),
+                          .num_orders = reader.Get<uint64_t>(),
+                          .symbol = *symbol};
+      break;
+    }
+    default:
+      event = Bbo{.bid = reader.GetLevel(),
+                  .ask = reader.GetLevel(),
+                  .symbol = *symbol};
+      break;
+  }
+  return SequencedEvent{.sequence = Load<uint64_t>(input, kSequenceOffset),
+                        .event = event};
 }
 
 }  // namespace mukhi::matching_engine
\ No newline at end of file
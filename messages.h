@@ -1,7 +1,10 @@
 #ifndef MATCHING_ENGINE_MESSAGES_H
 #define MATCHING_ENGINE_MESSAGES_H
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -15,6 +18,9 @@ enum class MessageType : uint8_t {
   kTradeEvent = 2,
   kOrderFullyFilled = 3,
   kOrderPartiallyFilled = 4,
+  kModifyOrderRequest = 5,
+  kDepthUpdate = 6,
+  kBboUpdate = 7,
   kUndefined = 10,
 };
 
@@ -28,6 +34,43 @@ using OrderId = uint64_t;
 using Quantity = uint64_t;
 using Price = double;
 
+/*
+Identifies the instrument an order is for: 1 to `kMaxSize` printable ASCII
+characters other than space and comma. Messages without a symbol are for the
+default instrument, which has an empty symbol.
+
+The characters are stored inline, padded with zeros, so that messages stay
+trivially copyable and symbols compare as two words.
+*/
+class Symbol {
+ public:
+  static constexpr size_t kMaxSize = 16;
+
+  Symbol() = default;
+
+  // Returns `std::nullopt` if `s` isn't a valid, non-empty, symbol.
+  static std::optional<Symbol> FromString(std::string_view s);
+
+  std::string_view view() const {
+    return std::string_view(chars_.data(), strnlen(chars_.data(), kMaxSize));
+  }
+  bool empty() const { return chars_[0] == '\0'; }
+
+  bool operator==(const Symbol& other) const {
+    return std::memcmp(chars_.data(), other.chars_.data(), kMaxSize) == 0;
+  }
+  bool operator!=(const Symbol& other) const { return !(*this == other); }
+
+ private:
+  std::array<char, kMaxSize> chars_{};
+};
+
+struct SymbolHash {
+  size_t operator()(const Symbol& symbol) const {
+    return std::hash<std::string_view>()(symbol.view());
+  }
+};
+
 // Input messages.
 
 struct AddOrderRequest {
@@ -35,36 +78,130 @@ struct AddOrderRequest {
   Side side;
   Quantity qty;
   Price price;
+  Symbol symbol;
 };
 
 struct CancelOrderRequest {
   OrderId order_id;
+  Symbol symbol;
+};
+
+/*
+Changes the quantity and price of a resting order, e.g. for a cancel-replace.
+A smaller quantity at the same price is a reduction in place, which keeps the
+time priority of the order. Any other change moves the order to the back of the
+queue at its new price, after matching it like a new order would be. A quantity
+of 0 cancels the order.
+*/
+struct ModifyOrderRequest {
+  OrderId order_id;
+  Quantity qty;
+  Price price;
+  Symbol symbol;
 };
 
-using InputMessage = std::variant<AddOrderRequest, CancelOrderRequest>;
+using InputMessage =
+    std::variant<AddOrderRequest, CancelOrderRequest, ModifyOrderRequest>;
 
 /**
  Parses one input message, return value is `std::nullopt` if message is
 ill-formed. Format is either of the following:
-   * msgtype,orderid,side,quantity,price (e.g., 0,123,0,9,1000)
-   * msgtype,orderid (e.g., 1,123)
+   * msgtype,orderid,side,quantity,price[,symbol] (e.g., 0,123,0,9,1000)
+   * msgtype,orderid[,symbol] (e.g., 1,123)
+   * msgtype,orderid,quantity,price[,symbol] (e.g., 5,123,7,1000)
 
 Note that no whitespace is allowed between token and delimter(comma).
 Error messages are printed on `es`.
 */
 std::optional<InputMessage> parse(std::string_view input, std::ostream& es);
 
+// Decimal places prices are parsed to exactly, see `ParseFixedPoint`.
+constexpr int kPriceDecimals = 6;
+constexpr int kMaxFixedPointDecimals = 15;
+// The largest number of units that converts to a `Price` exactly.
+constexpr uint64_t kMaxFixedPointUnits = uint64_t{1} << 53;
+
+/**
+ Parses a decimal of the form `digits[.digits]`, with at most `decimals` digits
+after the point, into the integer number of units of `10^-decimals` it's made
+of, e.g. "1075.25" is 10752500 units with 4 decimals. Return value is
+`std::nullopt` for anything else, or for more than `kMaxFixedPointUnits`
+units. Never throws and never allocates. `decimals` must be at most
+`kMaxFixedPointDecimals`.
+*/
+std::optional<uint64_t> ParseFixedPoint(std::string_view input, int decimals);
+
+/**
+ Converts units of `10^-decimals` to a price. Both the units and the power of
+ten are exactly representable, so the division is correctly rounded, and the
+price is the one `std::stod` gives for the decimal the units were parsed from.
+*/
+Price FixedPointToPrice(uint64_t units, int decimals);
+
+/**
+ Binary encoding of the input messages, an alternative to the text format for
+upstream systems that can produce it. Each message is a frame of fixed width,
+with all integers little-endian and no padding between fields:
+   * header (4 bytes): magic (uint8, always `kBinaryMagic`), msgtype (uint8),
+     length of the whole frame in bytes (uint16)
+   * AddOrderRequest (29 bytes): header, orderid (uint64), side (uint8),
+     quantity (uint64), price (IEEE 754 binary64)
+   * CancelOrderRequest (12 bytes): header, orderid (uint64)
+   * ModifyOrderRequest (28 bytes): header, orderid (uint64), quantity
+     (uint64), price (IEEE 754 binary64)
+
+Messages for an instrument other than the default one carry its symbol in
+`Symbol::kMaxSize` more bytes at the end of the frame, padded with zeros, i.e.
+frames of 45, 28 and 44 bytes respectively.
+
+No text message starts with `kBinaryMagic`, so the format of a stream can be
+detected by its first byte.
+*/
+constexpr uint8_t kBinaryMagic = 0xFE;
+constexpr size_t kBinaryHeaderSize = 4;
+constexpr size_t kBinaryAddOrderRequestSize = 29;
+constexpr size_t kBinaryCancelOrderRequestSize = 12;
+constexpr size_t kBinaryModifyOrderRequestSize = 28;
+constexpr size_t kMaxBinaryMessageSize =
+    kBinaryAddOrderRequestSize + Symbol::kMaxSize;
+
+/**
+ Encodes `msg` into `out`, which must have room for at least
+`kMaxBinaryMessageSize` bytes. Returns the number of bytes written.
+*/
+size_t EncodeBinary(const InputMessage& msg, char* out);
+
+/**
+ Reads the length of a binary message from its header. `header` must hold at
+least `kBinaryHeaderSize` bytes. Returns 0 if the header is corrupt, i.e. it
+doesn't start with `kBinaryMagic` or is shorter than a header.
+*/
+size_t BinaryMessageLength(const char* header);
+
+/**
+ Decodes one binary message, `input` must be exactly one frame (see
+`BinaryMessageLength`). Return value is `std::nullopt` if the message is
+ill-formed, and error messages are printed on `es`.
+*/
+std::optional<InputMessage> ParseBinary(std::string_view input,
+                                        std::ostream& es);
+
 // Output messages.
 
+// Output messages carry the symbol of the order book they come from, which is
+// only printed when it isn't empty.
+
 struct TradeEvent {
   Quantity qty;
   Price price;
+  Symbol symbol;
 };
 
 std::ostream& operator<<(std::ostream& os, const TradeEvent& obj);
 
 struct OrderFullyFilled {
   OrderId order_id;
+  Symbol symbol;
 };
 
 std::ostream& operator<<(std::ostream& os, const OrderFullyFilled& obj);
@@ -72,10 +209,115 @@ std::ostream& operator<<(std::ostream& os, const OrderFullyFilled& obj);
 struct OrderPartiallyFilled {
   OrderId order_id;
   Quantity remaining;
+  Symbol symbol;
 };
 
 std::ostream& operator<<(std::ostream& os, const OrderPartiallyFilled& obj);
 
+// The total quantity and number of resting orders at a price level, after they
+// changed. Both are 0 once the level is gone.
+struct DepthUpdate {
+  Side side;
+  Price price;
+  Quantity qty;
+  uint64_t num_orders;
+  Symbol symbol;
+};
+
+std::ostream& operator<<(std::ostream& os, const DepthUpdate& obj);
+
+// The resting orders at a price level, in total. A level without orders has a
+// quantity of 0.
+struct DepthLevel {
+  Price price = 0;
+  Quantity qty = 0;
+  uint64_t num_orders = 0;
+};
+
+// The best bid and offer, i.e. the best level of either side.
+struct Bbo {
+  DepthLevel bid;
+  DepthLevel ask;
+  Symbol symbol;
+};
+
+std::ostream& operator<<(std::ostream& os, const Bbo& obj);
+
+using OutputEvent = std::variant<TradeEvent, OrderFullyFilled,
+                                 OrderPartiallyFilled, DepthUpdate, Bbo>;
+
+/**
+ Text encoding of the output events, the same as their stream operators write,
+without a new line at the end. Writes `event` into `out`, which must have room
+for at least `kMaxTextEventSize` bytes, and returns the number of bytes
+written. Integers are written two digits at a time from a table, and nothing is
+allocated, so an event costs a few nanoseconds.
+
+Prices are written exactly: as the decimal with at most `kPriceDecimals`
+decimal places that parses back to the same price, without trailing zeros,
+e.g. "1075.5". That is the price as it was in the input, for any price
+`ParseFixedPoint` accepted. Other prices, e.g. below 10^-6, are written as the
+shortest text that parses back to them, see `std::to_chars`.
+*/
+constexpr size_t kMaxTextEventSize = 160;
+
+size_t FormatText(const TradeEvent& event, char* out);
+size_t FormatText(const OrderFullyFilled& event, char* out);
+size_t FormatText(const OrderPartiallyFilled& event, char* out);
+size_t FormatText(const DepthUpdate& event, char* out);
+size_t FormatText(const Bbo& event, char* out);
+
+/**
+ Binary encoding of the output events, for consumers that would rather not
+parse text. Frames start with the same header as those of the input messages,
+with the type of the event, followed by a sequence number (uint64), which
+numbers the events of a stream from 1 so that gaps can be detected, then by
+the fields of the event:
+   * TradeEvent (28 bytes): header, sequence, quantity (uint64), price
+     (IEEE 754 binary64)
+   * OrderFullyFilled (20 bytes): header, sequence, orderid (uint64)
+   * OrderPartiallyFilled (28 bytes): header, sequence, orderid (uint64),
+     remaining quantity (uint64)
+   * DepthUpdate (37 bytes): header, sequence, side (uint8), price (binary64),
+     quantity (uint64), number of orders (uint64)
+   * Bbo (60 bytes): header, sequence, price (binary64), quantity (uint64) and
+     number of orders (uint64) of the bid, then the same of the ask
+
+Like input messages, events of an instrument other than the default one carry
+its symbol in `Symbol::kMaxSize` more bytes at the end of the frame.
+*/
+constexpr size_t kBinaryTradeEventSize = 28;
+constexpr size_t kBinaryOrderFullyFilledSize = 20;
+constexpr size_t kBinaryOrderPartiallyFilledSize = 28;
+constexpr size_t kBinaryDepthUpdateSize = 37;
+constexpr size_t kBinaryBboSize = 60;
+constexpr size_t kMaxBinaryEventSize = kBinaryBboSize + Symbol::kMaxSize;
+
+/**
+ Encodes `event`, numbered `sequence`, into `out`, which must have room for at
+least `kMaxBinaryEventSize` bytes. Returns the number of bytes written.
+*/
+size_t EncodeBinary(const TradeEvent& event, uint64_t sequence, char* out);
+size_t EncodeBinary(const OrderFullyFilled& event, uint64_t sequence,
+                    char* out);
+size_t EncodeBinary(const OrderPartiallyFilled& event, uint64_t sequence,
+                    char* out);
+size_t EncodeBinary(const DepthUpdate& event, uint64_t sequence, char* out);
+size_t EncodeBinary(const Bbo& event, uint64_t sequence, char* out);
+
+struct SequencedEvent {
+  uint64_t sequence;
+  OutputEvent event;
+};
+
+/**
+ Decodes one binary event, `input` must be exactly one frame (see
+`BinaryMessageLength`). Return value is `std::nullopt` if the event is
+ill-formed, and error messages are printed on `es`.
+*/
+std::optional<SequencedEvent> ParseBinaryEvent(std::string_view input,
+                                               std::ostream& es);
+
 }  // namespace mukhi::matching_engine
 
 #endif  // MATCHING_ENGINE_MESSAGES_H
\ No newline at end of file
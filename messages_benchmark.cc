@@ -0,0 +1,135 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "batch_parser.h"
+#include "benchmark_util.h"
+#include "messages.h"
+
+namespace mukhi::matching_engine {
+namespace {
+
+void ParseLines(benchmark::State& state,
+                const std::vector<std::string>& lines) {
+  NullStream es;
+  int64_t bytes = 0;
+  for (const std::string& line : lines) bytes += line.size() + 1;
+
+  uint64_t start = AllocationCount();
+  for (auto _ : state) {
+    for (const std::string& line : lines) {
+      benchmark::DoNotOptimize(parse(line, es));
+    }
+  }
+  ReportPerOp(state, state.iterations() * lines.size(),
+              AllocationCount() - start);
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+void BM_ParseAddOrderRequest(benchmark::State& state) {
+  ParseLines(state, {"0,1000000,1,45,1075.5", "0,10000001,0,5,99999.0",
+                     "0,9999999,1,6,500"});
+}
+BENCHMARK(BM_ParseAddOrderRequest);
+
+void BM_ParseCancelOrderRequest(benchmark::State& state) {
+  ParseLines(state, {"1,1000000", "1,10000001", "1,9999999"});
+}
+BENCHMARK(BM_ParseCancelOrderRequest);
+
+void BM_ParseModifyOrderRequest(benchmark::State& state) {
+  ParseLines(state, {"5,1000000,40,1075.5", "5,10000001,5,99999.0",
+                     "5,9999999,0,500"});
+}
+BENCHMARK(BM_ParseModifyOrderRequest);
+
+// Ill-formed messages, which are reported on the error stream.
+void BM_ParseBadMessage(benchmark::State& state) {
+  ParseLines(state, {"0,1000000,1,10,word", "0,1000000,1,10,101.7 ",
+                     "wordsaren'tnumbers", "1,asdf"});
+}
+BENCHMARK(BM_ParseBadMessage);
+
+// A realistic mix of mostly adds with some cancels.
+std::vector<std::string> MixedStream() {
+  std::mt19937_64 rng(42);
+  std::vector<std::string> lines;
+  for (int i = 0; i < 10000; ++i) {
+    OrderId id = 10000000 + i;
+    if (rng() % 4 == 0) {
+      lines.push_back("1," + std::to_string(id - rng() % 100));
+    } else {
+      lines.push_back("0," + std::to_string(id) + "," +
+                      std::to_string(rng() % 2) + "," +
+                      std::to_string(1 + rng() % 1000) + "," +
+                      std::to_string(95000 + rng() % 10000) + "." +
+                      std::to_string(rng() % 10));
+    }
+  }
+  return lines;
+}
+
+void BM_ParseMixedStream(benchmark::State& state) {
+  ParseLines(state, MixedStream());
+}
+BENCHMARK(BM_ParseMixedStream);
+
+// The mixed stream as a single buffer, parsed by `BatchParser` with the
+// instruction set given by the argument (see `SimdLevel`).
+void BM_ParseBatchMixedStream(benchmark::State& state) {
+  std::string input;
+  std::vector<std::string> lines = MixedStream();
+  for (const std::string& line : lines) input += line + "\n";
+  BatchParser parser(static_cast<SimdLevel>(state.range(0)));
+  if (static_cast<int64_t>(parser.level()) != state.range(0)) {
+    state.SkipWithError("Instruction set not supported");
+    return;
+  }
+  NullStream es;
+  std::vector<InputMessage> batch;
+  batch.reserve(256);
+
+  uint64_t start = AllocationCount();
+  for (auto _ : state) {
+    std::string_view rest = input;
+    while (!rest.empty()) {
+      rest.remove_prefix(parser.Parse(rest, 256, batch, es));
+      benchmark::DoNotOptimize(batch.data());
+    }
+  }
+  ReportPerOp(state, state.iterations() * lines.size(),
+              AllocationCount() - start);
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseBatchMixedStream)->ArgName("simd")->DenseRange(0, 2);
+
+// Formatting of the events of a trade, with prices with and without decimals.
+void BM_FormatTradeEvents(benchmark::State& state) {
+  std::vector<TradeEvent> trades;
+  std::vector<OrderPartiallyFilled> fills;
+  std::mt19937_64 random(42);
+  for (int i = 0; i < 1024; ++i) {
+    Price price = 1000 + static_cast<Price>(random() % 2000) / 4;
+    trades.push_back(TradeEvent{.qty = random() % 1000, .price = price});
+    fills.push_back(OrderPartiallyFilled{.order_id = 1000000 + random() % 1000,
+                                         .remaining = random() % 100});
+  }
+  char buf[kMaxTextEventSize];
+
+  uint64_t start = AllocationCount();
+  for (auto _ : state) {
+    for (size_t i = 0; i < trades.size(); ++i) {
+      benchmark::DoNotOptimize(FormatText(trades[i], buf));
+      benchmark::DoNotOptimize(FormatText(fills[i], buf));
+      benchmark::ClobberMemory();
+    }
+  }
+  ReportPerOp(state, state.iterations() * trades.size() * 2,
+              AllocationCount() - start);
+}
+BENCHMARK(BM_FormatTradeEvents);
+
+}  // namespace
+}  // namespace mukhi::matching_engine
@@ -2,7 +2,9 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
 #include <sstream>
+#include <string>
 
 namespace mukhi::matching_engine {
 TEST(TradeEvent, to_string) {
@@ -32,6 +34,96 @@ TEST(OrderPartiallyFilled, to_string) {
   EXPECT_EQ(ss.str(), "4,1000001,75");
 }
 
+TEST(DepthUpdate, to_string) {
+  DepthUpdate du{
+      .side = Side::kSell, .price = 1075.5, .qty = 30, .num_orders = 2};
+
+  std::stringstream ss;
+  ss << du;
+  EXPECT_EQ(ss.str(), "6,1,1075.5,30,2");
+}
+
+TEST(Bbo, to_string) {
+  Bbo bbo{.bid = {.price = 1075.5, .qty = 30, .num_orders = 2},
+          .ask = {.price = 1076, .qty = 1, .num_orders = 1}};
+
+  std::stringstream ss;
+  ss << bbo;
+  EXPECT_EQ(ss.str(), "7,1075.5,30,2,1076,1,1");
+}
+
+TEST(OutputEvents, Symbol) {
+  Symbol symbol = *Symbol::FromString("AAPL");
+  std::stringstream ss;
+  ss << TradeEvent{.qty = 10, .price = 15.5, .symbol = symbol} << " "
+     << OrderFullyFilled{.order_id = 1, .symbol = symbol} << " "
+     << OrderPartiallyFilled{.order_id = 2, .remaining = 3, .symbol = symbol};
+  EXPECT_EQ(ss.str(), "2,10,15.5,AAPL 3,1,AAPL 4,2,3,AAPL");
+}
+
+std::string Text(const TradeEvent& event) {
+  char buf[kMaxTextEventSize];
+  return std::string(buf, FormatText(event, buf));
+}
+
+TEST(FormatText, ExactPrices) {
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 1075}), "2,1,1075");
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 1075.5}), "2,1,1075.5");
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 0.1}), "2,1,0.1");
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 0.000001}), "2,1,0.000001");
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 1234567.25}),
+            "2,1,1234567.25");
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 9007199254.740992}),
+            "2,1,9007199254.740992");
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 0}), "2,1,0");
+  // Prices without a fixed-point decimal.
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 1e-7}), "2,1,1e-07");
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 1075.123456789}),
+            "2,1,1075.123456789");
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = -5}), "2,1,-5");
+  EXPECT_EQ(Text(TradeEvent{.qty = 1, .price = 1e300}), "2,1,1e+300");
+}
+
+TEST(FormatText, Integers) {
+  for (uint64_t qty : {uint64_t{0}, uint64_t{9}, uint64_t{10}, uint64_t{99},
+                       uint64_t{100}, uint64_t{1000000},
+                       uint64_t{18446744073709551615u}}) {
+    EXPECT_EQ(Text(TradeEvent{.qty = qty, .price = 1}),
+              "2," + std::to_string(qty) + ",1");
+  }
+}
+
+TEST(FormatText, PricesParseBack) {
+  std::mt19937_64 random(42);
+  for (int i = 0; i < 100000; ++i) {
+    // Large prices are closer together than 10^-6 can be apart, several units
+    // may be the same price then.
+    bool small = i % 2 == 0;
+    uint64_t units = random() % (small ? 1000000000 : kMaxFixedPointUnits + 1);
+    Price price = FixedPointToPrice(units, kPriceDecimals);
+    std::string text = Text(TradeEvent{.qty = 1, .price = price});
+    std::string_view price_text = std::string_view(text).substr(4);
+    std::optional<uint64_t> parsed =
+        ParseFixedPoint(price_text, kPriceDecimals);
+    ASSERT_NE(parsed, std::nullopt) << text;
+    if (small) {
+      EXPECT_EQ(*parsed, units) << text;
+    }
+    EXPECT_EQ(FixedPointToPrice(*parsed, kPriceDecimals), price) << text;
+    ASSERT_EQ(std::stod(std::string(price_text)), price) << text;
+  }
+}
+
+TEST(FormatText, LongestEvent) {
+  Symbol symbol = *Symbol::FromString("ABCDEFGHIJKLMNOP");
+  DepthLevel level{.price = -2.2250738585072014e-308,
+                   .qty = 18446744073709551615u,
+                   .num_orders = 18446744073709551615u};
+  Bbo bbo{.bid = level, .ask = level, .symbol = symbol};
+  char buf[kMaxTextEventSize];
+  EXPECT_LE(FormatText(bbo, buf), kMaxTextEventSize);
+}
+
 TEST(Parse, AddOrderRequestSell) {
   std::string line = "0,1000000,1,45,1075.5";
   std::stringstream ss;
@@ -65,6 +157,88 @@ TEST(Parse, CancelOrderRequest) {
   EXPECT_EQ(std::get<CancelOrderRequest>(*msg).order_id, 1000000);
 }
 
+TEST(Parse, ModifyOrderRequest) {
+  std::stringstream ss;
+  std::optional<InputMessage> msg = parse("5,1000000,40,1075.25", ss);
+  ASSERT_NE(msg, std::nullopt);
+  ASSERT_TRUE(std::holds_alternative<ModifyOrderRequest>(*msg));
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).order_id, 1000000);
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).qty, 40);
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).price, 1075.25);
+  EXPECT_TRUE(std::get<ModifyOrderRequest>(*msg).symbol.empty());
+
+  msg = parse("5,1000000,0,1075,AAPL", ss);
+  ASSERT_NE(msg, std::nullopt);
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).qty, 0);
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).symbol.view(), "AAPL");
+  EXPECT_EQ(ss.str(), "");
+}
+
+TEST(Parse, BadModifyOrderRequest) {
+  std::stringstream ss;
+  EXPECT_EQ(parse("5,1000000,40", ss), std::nullopt);
+  EXPECT_EQ(parse("5,A,40,1075", ss), std::nullopt);
+  EXPECT_EQ(parse("5,1000000,-40,1075", ss), std::nullopt);
+  EXPECT_EQ(parse("5,1000000,40, 1075", ss), std::nullopt);
+  EXPECT_EQ(parse("5,1000000,40,1075a", ss), std::nullopt);
+  EXPECT_EQ(parse("5,1000000,40,1075,A B", ss), std::nullopt);
+  EXPECT_EQ(ss.str(),
+            "Bad Message: Unparsable modify order request : 40\n"
+            "Bad Message: Unparsable order id in modify order request : "
+            "A,40,1075\n"
+            "Bad Message: Unparsable 'quantity' in modify order request: "
+            "-40,1075\n"
+            "Bad Message: Unparsable 'price' in modify order request :  1075\n"
+            "Bad Message: Unparsable modify order request : 1075a\n"
+            "Bad Message: Unparsable 'symbol' in modify order request : A B\n");
+}
+
+TEST(Parse, Symbol) {
+  std::stringstream ss;
+  std::optional<InputMessage> msg = parse("0,1000000,1,45,1075.5,AAPL", ss);
+  ASSERT_NE(msg, std::nullopt);
+  ASSERT_TRUE(std::holds_alternative<AddOrderRequest>(*msg));
+  EXPECT_EQ(std::get<AddOrderRequest>(*msg).price, 1075.5);
+  EXPECT_EQ(std::get<AddOrderRequest>(*msg).symbol.view(), "AAPL");
+
+  msg = parse("1,1000000,BRK.B", ss);
+  ASSERT_NE(msg, std::nullopt);
+  ASSERT_TRUE(std::holds_alternative<CancelOrderRequest>(*msg));
+  EXPECT_EQ(std::get<CancelOrderRequest>(*msg).order_id, 1000000);
+  EXPECT_EQ(std::get<CancelOrderRequest>(*msg).symbol.view(), "BRK.B");
+
+  // No symbol is the default instrument.
+  msg = parse("1,1000000", ss);
+  ASSERT_NE(msg, std::nullopt);
+  EXPECT_TRUE(std::get<CancelOrderRequest>(*msg).symbol.empty());
+  EXPECT_EQ(ss.str(), "");
+}
+
+TEST(Parse, BadSymbol) {
+  std::stringstream ss;
+  EXPECT_EQ(parse("0,1000000,1,45,1075.5,A B", ss), std::nullopt);
+  EXPECT_EQ(parse("0,1000000,1,45,1075.5,ABCDEFGHIJKLMNOPQ", ss),
+            std::nullopt);
+  EXPECT_EQ(parse("1,1000000,A,B", ss), std::nullopt);
+  EXPECT_EQ(ss.str(),
+            "Bad Message: Unparsable 'symbol' in add order request : A B\n"
+            "Bad Message: Unparsable 'symbol' in add order request : "
+            "ABCDEFGHIJKLMNOPQ\n"
+            "Bad message: Unparsable 'symbol' in cancel order request : A,B\n");
+}
+
+TEST(Symbol, FromString) {
+  EXPECT_EQ(Symbol::FromString("ABCDEFGHIJKLMNOP")->view(),
+            "ABCDEFGHIJKLMNOP");
+  EXPECT_EQ(Symbol::FromString(""), std::nullopt);
+  EXPECT_EQ(Symbol::FromString("ABCDEFGHIJKLMNOPQ"), std::nullopt);
+  EXPECT_EQ(Symbol::FromString("A,B"), std::nullopt);
+  EXPECT_EQ(Symbol::FromString("A\tB"), std::nullopt);
+  EXPECT_TRUE(Symbol().empty());
+  EXPECT_EQ(*Symbol::FromString("AAPL"), *Symbol::FromString("AAPL"));
+  EXPECT_NE(*Symbol::FromString("AAPL"), *Symbol::FromString("AAP"));
+}
+
 TEST(Parse, SpacesNotAllowed) {
   std::string line = "0 ,1000000,1,1,1075";
   std::stringstream ss;
@@ -197,4 +371,323 @@ TEST(Parse, MultipleCommas) {
   ASSERT_EQ(msg, std::nullopt);
 }
 
-}  // namespace mukhi::matching_engine
\ No newline at end of file
+TEST(Parse, BadPriceErrors) {
+  std::stringstream ss;
+  for (std::string_view price :
+       {"", "word", " 10.7", "101.7 ", "1.2.3", ".", "1e999", "1e-999"}) {
+    EXPECT_EQ(parse("0,1,1,10," + std::string(price), ss), std::nullopt);
+  }
+  EXPECT_EQ(ss.str(),
+            "Bad Message: Unparsable 'price' in add order request : \n"
+            "Bad Message: exception while parsing 'price': stod\n"
+            "Bad Message: Unparsable 'price' in add order request :  10.7\n"
+            "Bad Message: Unparsable add order request : 101.7 \n"
+            "Bad Message: Unparsable add order request : 1.2.3\n"
+            "Bad Message: exception while parsing 'price': stod\n"
+            "Bad Message: exception while parsing 'price': stod\n"
+            "Bad Message: exception while parsing 'price': stod\n");
+}
+
+TEST(Parse, EmptyPriceErrors) {
+  // Empty prices and leading whitespaces are reported as unparsable, with the
+  // request and the price, rather than with the text of `std::stod`'s
+  // exception.
+  std::stringstream ss;
+  EXPECT_EQ(parse("0,1,1,10,", ss), std::nullopt);
+  EXPECT_EQ(parse("0,1,1,10,\t5", ss), std::nullopt);
+  EXPECT_EQ(parse("5,1,1,", ss), std::nullopt);
+  EXPECT_EQ(parse("5,1,1, 5", ss), std::nullopt);
+  EXPECT_EQ(ss.str(),
+            "Bad Message: Unparsable 'price' in add order request : \n"
+            "Bad Message: Unparsable 'price' in add order request : \t5\n"
+            "Bad Message: Unparsable 'price' in modify order request : \n"
+            "Bad Message: Unparsable 'price' in modify order request :  5\n");
+}
+
+TEST(Parse, PriceSameAsStod) {
+  std::stringstream ss;
+  for (std::string price :
+       {"0", "1075", "1075.5", "0.1", ".5", "5.", "0.000001", "0.0000001",
+        "99999.99", "9007199254.740992", "9007199254.740993",
+        "12345678901234567890", "1e3", "-5", "+1.25", "0x10"}) {
+    std::optional<InputMessage> msg = parse("5,1,1," + price, ss);
+    ASSERT_NE(msg, std::nullopt) << price;
+    EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).price, std::stod(price))
+        << price;
+  }
+  EXPECT_EQ(ss.str(), "");
+}
+
+TEST(ParseFixedPoint, Decimals) {
+  EXPECT_EQ(ParseFixedPoint("1075.25", 4), 10752500);
+  EXPECT_EQ(ParseFixedPoint("1075.25", 2), 107525);
+  EXPECT_EQ(ParseFixedPoint("1075", 0), 1075);
+  EXPECT_EQ(ParseFixedPoint("1075.", 1), 10750);
+  EXPECT_EQ(ParseFixedPoint(".5", 1), 5);
+  EXPECT_EQ(ParseFixedPoint("007", 0), 7);
+  EXPECT_EQ(ParseFixedPoint("9007199254740992", 0), kMaxFixedPointUnits);
+  EXPECT_EQ(FixedPointToPrice(10752500, 4), 1075.25);
+}
+
+TEST(ParseFixedPoint, Rejects) {
+  for (std::string_view input :
+       {"", ".", "1.2.3", "-1", "+1", "1e3", " 1", "1 ", "1,5", "inf"}) {
+    EXPECT_EQ(ParseFixedPoint(input, 4), std::nullopt) << input;
+  }
+  // Too many decimals, or too many units.
+  EXPECT_EQ(ParseFixedPoint("1075.255", 2), std::nullopt);
+  EXPECT_EQ(ParseFixedPoint("9007199254740993", 0), std::nullopt);
+  EXPECT_EQ(ParseFixedPoint("9007199254740992", 1), std::nullopt);
+  EXPECT_EQ(ParseFixedPoint("12345678901234567890", 0), std::nullopt);
+}
+
+std::string Binary(const InputMessage& msg) {
+  char buf[kMaxBinaryMessageSize];
+  return std::string(buf, EncodeBinary(msg, buf));
+}
+
+TEST(ParseBinary, AddOrderRequest) {
+  std::string frame = Binary(AddOrderRequest{
+      .order_id = 1000000, .side = Side::kSell, .qty = 45, .price = 1075.5});
+  ASSERT_EQ(frame.size(), kBinaryAddOrderRequestSize);
+  EXPECT_EQ(static_cast<uint8_t>(frame[0]), kBinaryMagic);
+  EXPECT_EQ(BinaryMessageLength(frame.data()), kBinaryAddOrderRequestSize);
+
+  std::stringstream ss;
+  std::optional<InputMessage> msg = ParseBinary(frame, ss);
+  ASSERT_NE(msg, std::nullopt);
+  ASSERT_TRUE(std::holds_alternative<AddOrderRequest>(*msg));
+  EXPECT_EQ(std::get<AddOrderRequest>(*msg).order_id, 1000000);
+  EXPECT_EQ(std::get<AddOrderRequest>(*msg).side, Side::kSell);
+  EXPECT_EQ(std::get<AddOrderRequest>(*msg).qty, 45);
+  EXPECT_EQ(std::get<AddOrderRequest>(*msg).price, 1075.5);
+  EXPECT_EQ(ss.str(), "");
+}
+
+TEST(ParseBinary, CancelOrderRequest) {
+  std::string frame = Binary(CancelOrderRequest{.order_id = 1000000});
+  ASSERT_EQ(frame.size(), kBinaryCancelOrderRequestSize);
+  EXPECT_EQ(BinaryMessageLength(frame.data()), kBinaryCancelOrderRequestSize);
+
+  std::stringstream ss;
+  std::optional<InputMessage> msg = ParseBinary(frame, ss);
+  ASSERT_NE(msg, std::nullopt);
+  ASSERT_TRUE(std::holds_alternative<CancelOrderRequest>(*msg));
+  EXPECT_EQ(std::get<CancelOrderRequest>(*msg).order_id, 1000000);
+}
+
+TEST(ParseBinary, ModifyOrderRequest) {
+  std::string frame = Binary(
+      ModifyOrderRequest{.order_id = 1000000, .qty = 40, .price = 1075.25});
+  ASSERT_EQ(frame.size(), kBinaryModifyOrderRequestSize);
+  EXPECT_EQ(BinaryMessageLength(frame.data()), kBinaryModifyOrderRequestSize);
+
+  std::stringstream ss;
+  std::optional<InputMessage> msg = ParseBinary(frame, ss);
+  ASSERT_NE(msg, std::nullopt);
+  ASSERT_TRUE(std::holds_alternative<ModifyOrderRequest>(*msg));
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).order_id, 1000000);
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).qty, 40);
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).price, 1075.25);
+
+  frame = Binary(ModifyOrderRequest{.order_id = 1,
+                                    .qty = 2,
+                                    .price = 3,
+                                    .symbol = *Symbol::FromString("AAPL")});
+  ASSERT_EQ(frame.size(), kBinaryModifyOrderRequestSize + Symbol::kMaxSize);
+  msg = ParseBinary(frame, ss);
+  ASSERT_NE(msg, std::nullopt);
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).symbol.view(), "AAPL");
+  EXPECT_EQ(std::get<ModifyOrderRequest>(*msg).price, 3);
+  EXPECT_EQ(ss.str(), "");
+}
+
+TEST(ParseBinary, Symbol) {
+  std::string frame = Binary(AddOrderRequest{.order_id = 1,
+                                             .side = Side::kBuy,
+                                             .qty = 2,
+                                             .price = 3,
+                                             .symbol = *Symbol::FromString(
+                                                 "AAPL")});
+  ASSERT_EQ(frame.size(), kBinaryAddOrderRequestSize + Symbol::kMaxSize);
+  EXPECT_EQ(BinaryMessageLength(frame.data()), frame.size());
+  std::stringstream ss;
+  std::optional<InputMessage> msg = ParseBinary(frame, ss);
+  ASSERT_NE(msg, std::nullopt);
+  EXPECT_EQ(std::get<AddOrderRequest>(*msg).symbol.view(), "AAPL");
+  EXPECT_EQ(std::get<AddOrderRequest>(*msg).price, 3);
+
+  frame = Binary(CancelOrderRequest{
+      .order_id = 1, .symbol = *Symbol::FromString("ABCDEFGHIJKLMNOP")});
+  ASSERT_EQ(frame.size(), kBinaryCancelOrderRequestSize + Symbol::kMaxSize);
+  msg = ParseBinary(frame, ss);
+  ASSERT_NE(msg, std::nullopt);
+  EXPECT_EQ(std::get<CancelOrderRequest>(*msg).symbol.view(),
+            "ABCDEFGHIJKLMNOP");
+
+  // Symbols can't be empty, or contain commas.
+  frame[kBinaryCancelOrderRequestSize] = '\0';
+  EXPECT_EQ(ParseBinary(frame, ss), std::nullopt);
+  frame[kBinaryCancelOrderRequestSize] = ',';
+  EXPECT_EQ(ParseBinary(frame, ss), std::nullopt);
+  EXPECT_EQ(ss.str(),
+            "Bad message: Unparsable 'symbol' in cancel order request\n"
+            "Bad message: Unparsable 'symbol' in cancel order request\n");
+}
+
+TEST(ParseBinary, LittleEndianLayout) {
+  std::string frame = Binary(CancelOrderRequest{.order_id = 0x0102});
+  EXPECT_EQ(frame, std::string("\xFE\x01\x0C\x00"
+                               "\x02\x01\x00\x00\x00\x00\x00\x00",
+                               12));
+}
+
+TEST(ParseBinary, CorruptHeader) {
+  std::string frame = Binary(CancelOrderRequest{.order_id = 1});
+  frame[0] = '1';
+  EXPECT_EQ(BinaryMessageLength(frame.data()), 0);
+  std::stringstream ss;
+  EXPECT_EQ(ParseBinary(frame, ss), std::nullopt);
+  EXPECT_EQ(ss.str(), "Bad message: Corrupt binary message header\n");
+}
+
+TEST(ParseBinary, Truncated) {
+  std::string frame = Binary(CancelOrderRequest{.order_id = 1});
+  std::stringstream ss;
+  EXPECT_EQ(ParseBinary(frame.substr(0, 8), ss), std::nullopt);
+  EXPECT_EQ(ParseBinary(frame.substr(0, 2), ss), std::nullopt);
+}
+
+TEST(ParseBinary, BadSide) {
+  std::string frame = Binary(AddOrderRequest{
+      .order_id = 1, .side = Side::kBuy, .qty = 45, .price = 1075.5});
+  frame[12] = 2;
+  std::stringstream ss;
+  EXPECT_EQ(ParseBinary(frame, ss), std::nullopt);
+  EXPECT_EQ(ss.str(),
+            "Bad Message: Unknown value for 'side' in add order request : "
+            "2\n");
+}
+
+TEST(ParseBinary, BadType) {
+  std::string frame = Binary(CancelOrderRequest{.order_id = 1});
+  frame[1] = 3;
+  std::stringstream ss;
+  EXPECT_EQ(ParseBinary(frame, ss), std::nullopt);
+  EXPECT_EQ(ss.str(), "Bad message: Invalid type : 3\n");
+}
+
+TEST(ParseBinary, LengthDoesNotMatchType) {
+  std::string frame = Binary(CancelOrderRequest{.order_id = 1});
+  frame[1] = 0;
+  std::stringstream ss;
+  EXPECT_EQ(ParseBinary(frame, ss), std::nullopt);
+}
+
+// Encodes `event` numbered `sequence` and decodes it back.
+template <typename Event>
+Event RoundTrip(const Event& event, uint64_t sequence = 7) {
+  char buf[kMaxBinaryEventSize];
+  std::string frame(buf, EncodeBinary(event, sequence, buf));
+  EXPECT_EQ(BinaryMessageLength(frame.data()), frame.size());
+  std::stringstream ss;
+  std::optional<SequencedEvent> decoded = ParseBinaryEvent(frame, ss);
+  EXPECT_EQ(ss.str(), "");
+  if (!decoded.has_value()) return Event();
+  EXPECT_EQ(decoded->sequence, sequence);
+  EXPECT_TRUE(std::holds_alternative<Event>(decoded->event));
+  return std::get<Event>(decoded->event);
+}
+
+TEST(ParseBinaryEvent, RoundTrip) {
+  for (const Symbol& symbol : {Symbol(), *Symbol::FromString("AAPL")}) {
+    TradeEvent te = RoundTrip(
+        TradeEvent{.qty = 10, .price = 1075.25, .symbol = symbol});
+    EXPECT_EQ(te.qty, 10);
+    EXPECT_EQ(te.price, 1075.25);
+    EXPECT_EQ(te.symbol, symbol);
+
+    OrderFullyFilled off =
+        RoundTrip(OrderFullyFilled{.order_id = 1000000, .symbol = symbol});
+    EXPECT_EQ(off.order_id, 1000000);
+    EXPECT_EQ(off.symbol, symbol);
+
+    OrderPartiallyFilled opf = RoundTrip(OrderPartiallyFilled{
+        .order_id = 1000001, .remaining = 75, .symbol = symbol});
+    EXPECT_EQ(opf.order_id, 1000001);
+    EXPECT_EQ(opf.remaining, 75);
+    EXPECT_EQ(opf.symbol, symbol);
+
+    DepthUpdate du = RoundTrip(DepthUpdate{.side = Side::kSell,
+                                           .price = 1075.5,
+                                           .qty = 30,
+                                           .num_orders = 2,
+                                           .symbol = symbol});
+    EXPECT_EQ(du.side, Side::kSell);
+    EXPECT_EQ(du.price, 1075.5);
+    EXPECT_EQ(du.qty, 30);
+    EXPECT_EQ(du.num_orders, 2);
+    EXPECT_EQ(du.symbol, symbol);
+
+    Bbo bbo = RoundTrip(
+        Bbo{.bid = {.price = 1075.5, .qty = 30, .num_orders = 2},
+            .ask = {.price = 1076, .qty = 1, .num_orders = 1},
+            .symbol = symbol});
+    EXPECT_EQ(bbo.bid.price, 1075.5);
+    EXPECT_EQ(bbo.bid.qty, 30);
+    EXPECT_EQ(bbo.bid.num_orders, 2);
+    EXPECT_EQ(bbo.ask.price, 1076);
+    EXPECT_EQ(bbo.ask.qty, 1);
+    EXPECT_EQ(bbo.ask.num_orders, 1);
+    EXPECT_EQ(bbo.symbol, symbol);
+  }
+}
+
+TEST(ParseBinaryEvent, Sizes) {
+  char buf[kMaxBinaryEventSize];
+  EXPECT_EQ(EncodeBinary(TradeEvent{}, 1, buf), kBinaryTradeEventSize);
+  EXPECT_EQ(EncodeBinary(OrderFullyFilled{}, 1, buf),
+            kBinaryOrderFullyFilledSize);
+  EXPECT_EQ(EncodeBinary(OrderPartiallyFilled{}, 1, buf),
+            kBinaryOrderPartiallyFilledSize);
+  EXPECT_EQ(EncodeBinary(DepthUpdate{}, 1, buf), kBinaryDepthUpdateSize);
+  EXPECT_EQ(EncodeBinary(Bbo{.symbol = *Symbol::FromString("AAPL")}, 1, buf),
+            kMaxBinaryEventSize);
+}
+
+TEST(ParseBinaryEvent, LittleEndianLayout) {
+  char buf[kMaxBinaryEventSize];
+  std::string frame(buf, EncodeBinary(OrderFullyFilled{.order_id = 0x0102},
+                                      0x0304, buf));
+  EXPECT_EQ(frame, std::string("\xFE\x03\x14\x00"
+                               "\x04\x03\x00\x00\x00\x00\x00\x00"
+                               "\x02\x01\x00\x00\x00\x00\x00\x00",
+                               20));
+}
+
+TEST(ParseBinaryEvent, BadEvents) {
+  char buf[kMaxBinaryEventSize];
+  std::stringstream ss;
+  // An input message.
+  std::string frame(buf, EncodeBinary(CancelOrderRequest{.order_id = 1}, buf));
+  EXPECT_EQ(ParseBinaryEvent(frame, ss), std::nullopt);
+  // A length that doesn't match the type.
+  frame = std::string(buf, EncodeBinary(TradeEvent{}, 1, buf));
+  frame[kBinaryHeaderSize - 2] = kBinaryTradeEventSize - 1;
+  frame.pop_back();
+  EXPECT_EQ(ParseBinaryEvent(frame, ss), std::nullopt);
+  // A bad side.
+  frame = std::string(buf, EncodeBinary(DepthUpdate{}, 1, buf));
+  frame[12] = 7;
+  EXPECT_EQ(ParseBinaryEvent(frame, ss), std::nullopt);
+  // A corrupt header.
+  frame[0] = 0;
+  EXPECT_EQ(ParseBinaryEvent(frame, ss), std::nullopt);
+  EXPECT_EQ(ss.str(),
+            "Bad message: Invalid type : 1\n"
+            "Bad message: Unparsable event of type 2, length : 27\n"
+            "Bad message: Unknown value for 'side' in depth update : 7\n"
+            "Bad message: Corrupt binary message header\n");
+}
+
+}  // namespace mukhi::matching_engine
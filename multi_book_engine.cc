@@ -0,0 +1,246 @@
+#include "multi_book_engine.h"
+
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace mukhi::matching_engine {
+
+namespace {
+// Number of items taken off a ring at once.
+constexpr size_t kBatchSize = 64;
+
+// Marks the end of the output of a message.
+struct EndOfMessage {};
+
+using ShardOutput = std::variant<OutputEvent, std::string, EndOfMessage>;
+
+// Publishes events into the output ring of a shard.
+class RingSink : public EventSink {
+ public:
+  explicit RingSink(SpscRing<ShardOutput>& ring) : ring_(ring) {}
+
+  void OnTradeEvent(const TradeEvent& event) override {
+    ring_.Push(OutputEvent(event));
+  }
+  void OnOrderFullyFilled(const OrderFullyFilled& event) override {
+    ring_.Push(OutputEvent(event));
+  }
+  void OnOrderPartiallyFilled(const OrderPartiallyFilled& event) override {
+    ring_.Push(OutputEvent(event));
+  }
+  void OnDepthUpdate(const DepthUpdate& event) override {
+    ring_.Push(OutputEvent(event));
+  }
+  void OnBboUpdate(const Bbo& event) override {
+    ring_.Push(OutputEvent(event));
+  }
+
+ private:
+  SpscRing<ShardOutput>& ring_;
+};
+
+void PinToCpu(std::thread& thread, size_t index) {
+#if defined(__linux__)
+  unsigned num_cpus = std::thread::hardware_concurrency();
+  if (num_cpus == 0) return;
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(index % num_cpus, &cpus);
+  // Best effort, e.g. the CPU might not be available to this process.
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#endif
+}
+
+const Symbol& SymbolOf(const InputMessage& msg) {
+  return std::visit([](const auto& req) -> const Symbol& { return req.symbol; },
+                    msg);
+}
+}  // namespace
+
+struct MultiBookEngine::Shard {
+  explicit Shard(size_t ring_capacity)
+      : inputs(ring_capacity), outputs(ring_capacity), sink(outputs) {}
+
+  // Used by the reader and the worker.
+  SpscRing<InputMessage> inputs;
+  // Used by the worker and the merger.
+  SpscRing<ShardOutput> outputs;
+  std::thread worker;
+
+  // Used by the worker only.
+  RingSink sink;
+  std::ostringstream errors;
+  std::unordered_map<Symbol, std::unique_ptr<OrderBook>, SymbolHash> books;
+
+  // Used by the merger only: the last batch taken off `outputs`, of which the
+  // items from `next` on are yet to be merged.
+  ShardOutput batch[kBatchSize];
+  size_t next = 0;
+  size_t size = 0;
+};
+
+// Routes messages to the shards, and errors straight to the merger.
+class MultiBookEngine::RouterTarget {
+ public:
+  explicit RouterTarget(MultiBookEngine& engine) : engine_(engine) {}
+
+  std::ostream& errors() { return errors_; }
+  void CommitErrors() {
+    if (errors_.tellp() > 0) {
+      engine_.routes_.Push(errors_.str());
+      errors_.str("");
+    }
+  }
+  void DeliverBatch(const InputMessage* msgs, size_t n) {
+    for (size_t i = 0; i < n; ++i) Deliver(msgs[i]);
+  }
+  void Deliver(const InputMessage& req) {
+    size_t num_shards = engine_.shards_.size();
+    size_t shard =
+        num_shards == 1 ? 0 : SymbolHash()(SymbolOf(req)) % num_shards;
+    // The worker may start on the message before its route is pushed, but the
+    // merger can't get to its output before.
+    engine_.shards_[shard]->inputs.Push(req);
+    engine_.routes_.Push(shard);
+  }
+  // The merger flushes whenever it catches up.
+  void Idle() {}
+
+ private:
+  MultiBookEngine& engine_;
+  std::ostringstream errors_;
+};
+
+MultiBookEngine::MultiBookEngine(std::istream& is, std::ostream& os,
+                                 std::ostream& es,
+                                 const MultiBookEngineOptions& options)
+    : is_(is),
+      os_(os),
+      es_(es),
+      options_(options),
+      sink_(MakeBufferedSink(os_, options.output_format,
+                             options.output_flush_threshold)),
+      routes_(options.ring_capacity) {
+  for (size_t i = 0; i < std::max<size_t>(options.num_shards, 1); ++i) {
+    shards_.push_back(std::make_unique<Shard>(options.ring_capacity));
+  }
+}
+
+MultiBookEngine::~MultiBookEngine() { Finish(); }
+
+bool MultiBookEngine::MarkStarted() {
+  bool expected = false;
+  if (!started_.compare_exchange_strong(expected, true)) {
+    es_ << "Matching Engine was already started" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+template <typename Function>
+void MultiBookEngine::Run(Function read) {
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    Shard& shard = *shards_[i];
+    shard.worker = std::thread(&MultiBookEngine::Work, this, std::ref(shard));
+    if (options_.pin_workers) PinToCpu(shard.worker, i);
+  }
+  merger_ = std::thread(&MultiBookEngine::Merge, this);
+  RouterTarget target(*this);
+  read(target);
+  target.CommitErrors();
+  Finish();
+}
+
+void MultiBookEngine::Finish() {
+  if (!merger_.joinable()) return;
+  for (auto& shard : shards_) shard->inputs.Close();
+  routes_.Close();
+  for (auto& shard : shards_) shard->worker.join();
+  merger_.join();
+}
+
+void MultiBookEngine::Start() {
+  if (!MarkStarted()) return;
+
+  Run([this](auto& target) {
+    ReadInput(is_, options_.input_format, target);
+  });
+}
+
+void MultiBookEngine::Replay(std::string_view input) {
+  if (!MarkStarted()) return;
+
+  Run([this, input](auto& target) {
+    ProcessInput(input, options_.input_format, target);
+  });
+}
+
+void MultiBookEngine::Work(Shard& shard) {
+  InputMessage batch[kBatchSize];
+  while (size_t n = shard.inputs.PopBatch(batch, kBatchSize)) {
+    for (size_t i = 0; i < n; ++i) {
+      const Symbol& symbol = SymbolOf(batch[i]);
+      std::unique_ptr<OrderBook>& book = shard.books[symbol];
+      if (book == nullptr) {
+        OrderBookOptions options = options_.order_book;
+        options.symbol = symbol;
+        book = std::make_unique<OrderBook>(shard.sink, shard.errors, options);
+      }
+      std::visit([&book](const auto& req) { book->ProcessOrder(req); },
+                 batch[i]);
+      if (shard.errors.tellp() > 0) {
+        shard.outputs.Push(shard.errors.str());
+        shard.errors.str("");
+      }
+      shard.outputs.Push(EndOfMessage{});
+    }
+  }
+  shard.outputs.Close();
+}
+
+void MultiBookEngine::Merge() {
+  Route routes[kBatchSize];
+  while (true) {
+    size_t n = routes_.TryPopBatch(routes, kBatchSize);
+    if (n == 0) {
+      // Caught up with the reader, deliver what we have before waiting for
+      // more.
+      sink_->Flush();
+      n = routes_.PopBatch(routes, kBatchSize);
+      if (n == 0) break;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (const auto* error = std::get_if<std::string>(&routes[i])) {
+        es_ << *error << std::flush;
+        continue;
+      }
+      Shard& shard = *shards_[std::get<size_t>(routes[i])];
+      while (true) {
+        if (shard.next == shard.size) {
+          // The worker pushes an end marker for every message routed to it
+          // before it's done, so there's always more output to wait for.
+          shard.size = shard.outputs.PopBatch(shard.batch, kBatchSize);
+          shard.next = 0;
+        }
+        const ShardOutput& output = shard.batch[shard.next++];
+        if (std::holds_alternative<EndOfMessage>(output)) break;
+        if (const auto* event = std::get_if<OutputEvent>(&output)) {
+          PublishEvent(*event, *sink_);
+        } else {
+          es_ << std::get<std::string>(output) << std::flush;
+        }
+      }
+    }
+  }
+  sink_->Flush();
+}
+
+}  // namespace mukhi::matching_engine
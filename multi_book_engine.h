@@ -0,0 +1,108 @@
+#ifndef MATCHING_ENGINE_MULTI_BOOK_ENGINE_H
+#define MATCHING_ENGINE_MULTI_BOOK_ENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "event_sink.h"
+#include "input_reader.h"
+#include "messages.h"
+#include "order_book.h"
+#include "spsc_ring.h"
+
+namespace mukhi::matching_engine {
+
+struct MultiBookEngineOptions {
+  InputFormat input_format = InputFormat::kAuto;
+  // Options of every order book, except for the symbol which is set to that of
+  // the instrument.
+  OrderBookOptions order_book;
+  // Number of worker threads the order books are spread over.
+  size_t num_shards = 1;
+  // Pins worker `i` to CPU `i` modulo the number of CPUs. Failures to pin are
+  // ignored.
+  bool pin_workers = true;
+  // Capacity of each of the rings between the threads.
+  size_t ring_capacity = 1 << 14;
+  // See `MatchingEngineOptions`.
+  size_t output_flush_threshold = BufferedSink::kDefaultFlushThreshold;
+  OutputFormat output_format = OutputFormat::kText;
+};
+
+/*
+Same as `MatchingEngine`, but for many instruments: every message goes to the
+order book of its symbol, which is created on its first message.
+
+The order books are sharded over a pool of worker threads by the hash of their
+symbol, so that the instruments are matched in parallel. The calling thread
+reads the input and routes every message to the ring of its shard, which keeps
+the messages of a symbol in order. Along with it, the reader records the shard
+of every message in a route ring, in input order. A merging thread follows the
+routes and takes the events of each message from the output ring of its shard,
+up to a marker the worker pushes once done with the message. The output, events
+and errors alike, is therefore exactly the same, line by line, as processing
+the messages one by one, whatever the number of shards.
+
+The merge is the only serial stage past the reader, and it merely formats
+events, so the throughput of matching scales with the number of shards as long
+as the flow is spread over enough symbols.
+
+An object of this class keeps references to the streams provided during
+construction time and expects them to stay alive for the lifetime of the object.
+
+This class is thread-safe. If multiple threads try to call `Start` (or
+`Replay`) only one will be successful.
+*/
+class MultiBookEngine {
+ public:
+  MultiBookEngine(std::istream& is, std::ostream& os, std::ostream& es,
+                  const MultiBookEngineOptions& options = {});
+  ~MultiBookEngine();
+
+  // See `MatchingEngine::Start`.
+  void Start();
+  // See `MatchingEngine::Replay`.
+  void Replay(std::string_view input);
+
+ private:
+  // Index of the shard of the next message, or an error found while reading.
+  using Route = std::variant<size_t, std::string>;
+  struct Shard;
+  class RouterTarget;
+
+  // Returns false if the engine was already started.
+  bool MarkStarted();
+  // Starts the workers and the merger, calls `read` with the target that
+  // routes the messages it reads, then waits for the output to be flushed.
+  template <typename Function>
+  void Run(Function read);
+  // Closes the rings and waits for all the threads to finish, if they were
+  // started.
+  void Finish();
+
+  void Work(Shard& shard);
+  void Merge();
+
+  std::istream& is_;
+  std::ostream& os_;
+  std::ostream& es_;
+  const MultiBookEngineOptions options_;
+
+  const std::unique_ptr<BufferedSink> sink_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  SpscRing<Route> routes_;
+  std::thread merger_;
+
+  std::atomic_bool started_ = false;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_MULTI_BOOK_ENGINE_H
@@ -0,0 +1,183 @@
+#include "multi_book_engine.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "matching_engine.h"
+
+namespace mukhi::matching_engine {
+
+// Processes `input` one line at a time, with an order book per symbol.
+std::pair<std::string, std::string> RunSerially(const std::string& input) {
+  std::ostringstream os;
+  std::ostringstream es;
+  std::map<std::string, std::unique_ptr<OrderBook>> books;
+  std::istringstream is(input);
+  std::string line;
+  while (std::getline(is, line)) {
+    auto msg = parse(line, es);
+    if (!msg.has_value()) continue;
+    std::visit(
+        [&](const auto& req) {
+          auto& book = books[std::string(req.symbol.view())];
+          if (book == nullptr) {
+            book = std::make_unique<OrderBook>(
+                os, es, OrderBookOptions{.symbol = req.symbol});
+          }
+          book->ProcessOrder(req);
+        },
+        *msg);
+  }
+  return {os.str(), es.str()};
+}
+
+std::pair<std::string, std::string> RunMultiBook(
+    const std::string& input, const MultiBookEngineOptions& options,
+    bool replay) {
+  std::istringstream is(input);
+  std::ostringstream os;
+  std::ostringstream es;
+  MultiBookEngine engine(is, os, es, options);
+  if (replay) {
+    engine.Replay(input);
+  } else {
+    engine.Start();
+  }
+  return {os.str(), es.str()};
+}
+
+TEST(MultiBookEngineTest, BooksAreIndependent) {
+  // Same order ids and prices, different instruments.
+  std::string input =
+      "0,1,0,10,100,A\n"
+      "0,1,1,10,100,B\n"
+      "0,2,1,4,100,A\n"
+      "1,1,B\n"
+      "1,1,B\n"
+      "0,3,1,6,100\n"
+      "0,4,0,1,100\n";
+  auto [os, es] = RunMultiBook(input, {.num_shards = 2}, /*replay=*/false);
+  EXPECT_EQ(os, "2,4,100,A\n3,2,A\n4,1,6,A\n2,1,100\n3,4\n4,3,5\n");
+  EXPECT_EQ(es, "No such order with id: 1\n");
+}
+
+TEST(MultiBookEngineTest, SameAsOneBookPerSymbol) {
+  // Orders for a few instruments and the default one, around slowly moving
+  // prices, with cancels, some for the wrong instrument, and ill-formed
+  // lines.
+  const std::string symbols[] = {"", "A", "BB", "CCC", "DDDD", "E"};
+  std::mt19937_64 rng(7);
+  std::string input;
+  for (OrderId id = 1; id < 20000; ++id) {
+    std::string symbol = symbols[rng() % std::size(symbols)];
+    if (!symbol.empty()) symbol = "," + symbol;
+    switch (rng() % 8) {
+      case 0:
+        input += "1," + std::to_string(rng() % id) + symbol + "\n";
+        break;
+      case 1:
+        input += "0," + std::to_string(id) + ",1,1,bad" + symbol + "\n";
+        break;
+      default:
+        input += "0," + std::to_string(id) + "," + std::to_string(rng() % 2) +
+                 "," + std::to_string(1 + rng() % 50) + "," +
+                 std::to_string(1000 + id / 100 + rng() % 20) + symbol + "\n";
+    }
+  }
+
+  auto expected = RunSerially(input);
+  EXPECT_NE(expected.first, "");
+  EXPECT_NE(expected.second, "");
+  for (size_t num_shards : {1, 3, 8}) {
+    MultiBookEngineOptions options{.num_shards = num_shards,
+                                   .ring_capacity = 16,
+                                   .output_flush_threshold = 100};
+    EXPECT_EQ(RunMultiBook(input, options, /*replay=*/false), expected)
+        << num_shards << " shards";
+    EXPECT_EQ(RunMultiBook(input, options, /*replay=*/true), expected)
+        << num_shards << " shards";
+  }
+}
+
+TEST(MultiBookEngineTest, SameAsMatchingEngineWithoutSymbols) {
+  std::string input =
+      "0,1000000,1,1,1075\n"
+      "0,1000001,0,9,1000\n"
+      "0,1000002,0,30,975\n"
+      "0,1000003,1,10,1050\n"
+      "bad\n"
+      "0,1000004,0,10,950\n"
+      "0,1000005,1,2,1025\n"
+      "0,1000006,0,1,1000\n"
+      "1,1000004\n"
+      "0,1000007,1,5,1025\n"
+      "0,1000008,0,3,1050\n";
+  std::istringstream is(input);
+  std::ostringstream os;
+  std::ostringstream es;
+  MatchingEngine(is, os, es).Start();
+  EXPECT_EQ(RunMultiBook(input, {.num_shards = 4}, /*replay=*/false),
+            std::make_pair(os.str(), es.str()));
+}
+
+// Input that takes `delay` to arrive, like a quiet socket.
+class SlowStreambuf : public std::streambuf {
+ public:
+  SlowStreambuf(std::string input, std::chrono::milliseconds delay)
+      : input_(std::move(input)), delay_(delay) {}
+
+ protected:
+  int_type underflow() override {
+    if (delivered_) return traits_type::eof();
+    std::this_thread::sleep_for(delay_);
+    delivered_ = true;
+    setg(input_.data(), input_.data(), input_.data() + input_.size());
+    return traits_type::to_int_type(input_[0]);
+  }
+
+ private:
+  std::string input_;
+  std::chrono::milliseconds delay_;
+  bool delivered_ = false;
+};
+
+TEST(MultiBookEngineTest, IdleShardsSleep) {
+  SlowStreambuf input("0,1,0,1,1,A\n0,2,1,1,1,B\n",
+                      std::chrono::milliseconds(500));
+  std::istream is(&input);
+  std::ostringstream os;
+  std::ostringstream es;
+  MultiBookEngine engine(is, os, es, {.num_shards = 2});
+  // While waiting for input, the workers and the merging thread sleep instead
+  // of spinning.
+  std::clock_t start = std::clock();
+  engine.Start();
+  EXPECT_LT(std::clock() - start, CLOCKS_PER_SEC / 10);
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST(MultiBookEngineTest, NoRestart) {
+  std::istringstream is("0,1,0,1,1,A\n");
+  std::ostringstream os;
+  std::ostringstream es;
+  MultiBookEngine engine(is, os, es);
+  engine.Start();
+  engine.Start();
+  engine.Replay("0,2,1,1,1,A\n");
+  EXPECT_EQ(os.str(), "");
+  EXPECT_EQ(es.str(),
+            "Matching Engine was already started\n"
+            "Matching Engine was already started\n");
+}
+
+}  // namespace mukhi::matching_engine
@@ -1,178 +1,525 @@
 #include "order_book.h"
 
-#include <functional>
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <utility>
+#include <variant>
 
 namespace mukhi::matching_engine {
 namespace {
-template <typename MapType, typename MapIteratorType>
-void RemoveFromOrderMap(MapType& m, MapIteratorType map_itr,
-                        OrderList::iterator order_list_itr,
-                        PriceIndex& price_index) {
-  if (map_itr->second.size() == 1) {
+template <typename MapType, typename PriceIndexType, typename Moved>
+void RemoveFromOrderMap(MapType& m, typename MapType::iterator map_itr,
+                        OrderQueue::Ticket ticket, PriceIndexType& price_index,
+                        std::vector<OrderQueue>& spare_queues, Moved moved) {
+  if (map_itr->second.orders.size() == 1) {
     // If there's only one order for that price, we can remove the map entry
     // itself. And also remove from price index.
-    price_index.erase(map_itr->first);
+    if constexpr (!IsPriceLadder<MapType>::value) {
+      price_index.erase(map_itr->first);
+    }
+    map_itr->second.orders.erase(ticket);
+    spare_queues.push_back(std::move(map_itr->second.orders));
     m.erase(map_itr);
   } else {
-    // Remove the order from the `OrderList`.
-    map_itr->second.erase(order_list_itr);
+    // Remove the order from the `OrderQueue`, and the tombstones it left
+    // behind once they pile up.
+    OrderQueue& orders = map_itr->second.orders;
+    map_itr->second.qty -= orders.at(ticket).qty;
+    orders.erase(ticket);
+    if (orders.NeedsCompaction()) orders.Compact(moved);
   }
 }
+}  // namespace
 
-template <typename MapType, typename MapTypeIterator>
-std::pair<MapTypeIterator, OrderList::iterator> AddToOrderMap(MapType& m,
-                                                              Order o) {
-  auto [order_map_itr, success] =
-      m.emplace(std::make_pair(o.price, OrderList()));
-  OrderList& order_list = order_map_itr->second;
-  OrderList::iterator order_list_itr =
-      order_list.insert(order_list.end(), std::move(o));
-  return {order_map_itr, order_list_itr};
-}
+OrderBook::OrderBook(std::ostream& os, std::ostream& es,
+                     const OrderBookOptions& options)
+    : OrderBook(std::make_unique<BufferedTextSink>(os, /*flush_threshold=*/0),
+                nullptr, es, options) {}
 
-// Following helper functions help keep matching logic agnostic of if the
-// incoming order is buy or sell.
-bool IncomingSellMatcher(Price incoming, Price resting) {
-  return incoming <= resting;
+OrderBook::OrderBook(EventSink& sink, std::ostream& es,
+                     const OrderBookOptions& options)
+    : OrderBook(nullptr, &sink, es, options) {}
+
+OrderBook::OrderBook(std::unique_ptr<EventSink> owned_sink, EventSink* sink,
+                     std::ostream& es, const OrderBookOptions& options)
+    : owned_sink_(std::move(owned_sink)),
+      output_sink_(sink != nullptr ? *sink : *owned_sink_),
+      output_es_(es),
+      sink_(&output_sink_),
+      es_(&output_es_),
+      symbol_(options.symbol),
+      publish_depth_updates_(options.publish_depth_updates),
+      publish_bbo_updates_(options.publish_bbo_updates),
+      order_id_index_(options.order_capacity) {
+  if (options.tick_grid.has_value()) {
+    sells_.ladder.emplace(*options.tick_grid);
+    buys_.ladder.emplace(*options.tick_grid);
+  }
+  bbo_.symbol = symbol_;
 }
-bool IncomingBuyMatcher(Price incoming, Price resting) {
-  return resting <= incoming;
+
+/*
+Times the stages of a request, if it's sampled. Events are published
+in the middle of matching, so the ticks spent publishing, see
+`StartPublishing`, are taken out of the stage they're published in and counted
+as a stage of their own.
+*/
+class OrderBook::RequestTimer {
+ public:
+  RequestTimer(LatencyStats* stats, const uint64_t& publish_ticks)
+      : stats_(stats), publish_ticks_(publish_ticks) {
+    if (stats_ == nullptr) return;
+    start_ = stage_start_ = ReadTsc();
+    publish_start_ = stage_publish_start_ = publish_ticks_;
+  }
+
+  // Ends `stage`, which started when the previous one ended. A stage may be
+  // gone through more than once, e.g. by a cancel-replace, in which case its
+  // ticks add up.
+  void EndStage(LatencyStage stage) {
+    if (stats_ == nullptr) return;
+    uint64_t now = ReadTsc();
+    uint64_t publish = publish_ticks_;
+    uint64_t ticks = (now - stage_start_) - (publish - stage_publish_start_);
+    std::optional<uint64_t>& stage_ticks =
+        stage == LatencyStage::kMatch ? match_ticks_ : book_update_ticks_;
+    stage_ticks = stage_ticks.value_or(0) + ticks;
+    stage_start_ = now;
+    stage_publish_start_ = publish;
+  }
+
+  // Records the stages of the request. A request rejected before the end of
+  // its match stage spent all its time checking it, i.e. matching.
+  void Finish(MessageType type, Outcome outcome) {
+    if (stats_ == nullptr) return;
+    uint64_t total = ReadTsc() - start_;
+    uint64_t publish = publish_ticks_ - publish_start_;
+    auto record = [&](LatencyStage stage, uint64_t ticks) {
+      stats_->histogram(stage, type, outcome).Record(ticks);
+    };
+    record(LatencyStage::kMatch, match_ticks_.value_or(total - publish));
+    if (book_update_ticks_.has_value()) {
+      record(LatencyStage::kBookUpdate, *book_update_ticks_);
+    }
+    if (publish > 0) record(LatencyStage::kPublish, publish);
+    record(LatencyStage::kTotal, total);
+  }
+
+ private:
+  LatencyStats* const stats_;
+  // Of the order book.
+  const uint64_t& publish_ticks_;
+  uint64_t start_;
+  uint64_t publish_start_;
+  uint64_t stage_start_;
+  uint64_t stage_publish_start_;
+  std::optional<uint64_t> match_ticks_;
+  std::optional<uint64_t> book_update_ticks_;
+};
+
+void OrderBook::UpdateOutputs() {
+  if (muted_) {
+    sink_ = &null_sink_;
+    es_ = &null_es_;
+    stats_ = nullptr;
+    return;
+  }
+  sample_countdown_ = 1;
+  sink_ = &output_sink_;
+  es_ = &output_es_;
+  stats_ = latency_stats_;
 }
 
-}  // namespace
-void OrderBook::ExecuteTrades(Order& incoming_order, OrderList& order_list) {
-  while (incoming_order.qty > 0 && !order_list.empty()) {
-    Order& resting_order = order_list.front();
+void OrderBook::ExecuteTrades(Order& incoming_order, Price price,
+                              PriceLevel& level) {
+  OrderQueue& orders = level.orders;
+  while (incoming_order.qty > 0 && !orders.empty()) {
+    OrderQueue::Entry& resting_order = orders.front();
     TradeEvent te;
     te.qty = std::min(incoming_order.qty, resting_order.qty);
+    level.qty -= te.qty;
     // Price of the resting order is trade event's price
-    te.price = resting_order.price;
+    te.price = price;
+    te.symbol = symbol_;
     // Generate messages
-    os_ << te << std::endl;
+    uint64_t publish_start = StartPublishing();
+    sink_->OnTradeEvent(te);
     if (te.qty == incoming_order.qty) {
-      OrderFullyFilled o{.order_id = incoming_order.id};
-      os_ << o << std::endl;
+      sink_->OnOrderFullyFilled(
+          OrderFullyFilled{.order_id = incoming_order.id, .symbol = symbol_});
       incoming_order.qty = 0;
     } else {
       incoming_order.qty -= te.qty;
-      OrderPartiallyFilled o{.order_id = incoming_order.id,
-                             .remaining = incoming_order.qty};
-      os_ << o << std::endl;
+      sink_->OnOrderPartiallyFilled(OrderPartiallyFilled{
+          .order_id = incoming_order.id,
+          .remaining = incoming_order.qty,
+          .symbol = symbol_});
     }
     if (te.qty == resting_order.qty) {
-      OrderFullyFilled o{.order_id = resting_order.id};
-      os_ << o << std::endl;
+      sink_->OnOrderFullyFilled(
+          OrderFullyFilled{.order_id = resting_order.id, .symbol = symbol_});
+      EndPublishing(publish_start);
       // Remove resting order from the book.
       order_id_index_.erase(resting_order.id);
-      order_list.pop_front();
+      orders.pop_front();
     } else {
       resting_order.qty -= te.qty;
-      OrderPartiallyFilled o{.order_id = resting_order.id,
-                             .remaining = resting_order.qty};
-      os_ << o << std::endl;
+      sink_->OnOrderPartiallyFilled(OrderPartiallyFilled{
+          .order_id = resting_order.id,
+          .remaining = resting_order.qty,
+          .symbol = symbol_});
+      EndPublishing(publish_start);
     }
   }
 }
 
-template <typename MapType>
-void OrderBook::MatchOrders(Order& incoming_order, MapType& resting_orders,
-                            MatchingFunction match) {
-  for (auto itr = resting_orders.begin();
-       itr != resting_orders.end() && incoming_order.qty > 0;) {
+template <Side S, typename Levels>
+void OrderBook::MatchOrders(Order& incoming_order, Levels& levels) {
+  Quantity qty = incoming_order.qty;
+  for (auto itr = levels.begin();
+       itr != levels.end() && incoming_order.qty > 0;) {
     Price resting_price = itr->first;
-    if (!match(incoming_order.price, resting_price)) break;
+    if (!SidePolicy<S>::Crosses(incoming_order.price, resting_price)) break;
 
-    OrderList& order_list = itr->second;
-    ExecuteTrades(incoming_order, order_list);
-    if (order_list.empty()) {
+    PriceLevel& level = itr->second;
+    ExecuteTrades(incoming_order, resting_price, level);
+    PublishDepth(S, resting_price, level.qty, level.orders.size());
+    if (level.orders.empty()) {
       // Remove this resting price from order book.
-      price_index_.erase(resting_price);
-      itr = resting_orders.erase(itr);
+      if constexpr (!IsPriceLadder<Levels>::value) {
+        side<S>().price_index.erase(resting_price);
+      }
+      spare_queues_.push_back(std::move(level.orders));
+      itr = levels.erase(itr);
     } else {
-      ++itr;
+      // Resting orders are left at this price only if the incoming order has
+      // been fully filled.
+      break;
     }
   }
+  // Only the best levels trade.
+  if (incoming_order.qty != qty) RefreshBest<S>();
 }
 
-void OrderBook::AddOrder(Order o) {
-  auto price_index_itr = price_index_.find(o.price);
-  if (price_index_itr != price_index_.end()) {
-    // An order list for this price already exists.
-    IteratorVariant order_map_itr = price_index_itr->second;
-    OrderList::iterator order_list_itr;
-    OrderList* list;
-    if (o.side == Side::kSell) {
-      list = &order_map_itr.sell_order_map_it->second;
-    } else {
-      list = &order_map_itr.buy_order_map_it->second;
+template <Side S>
+void OrderBook::AddOrder(const Order& o) {
+  BookSide<S>& book = side<S>();
+  PriceLevel* level;
+  if (book.ladder.has_value()) {
+    auto ladder_itr = book.ladder->find(o.price);
+    if (ladder_itr == book.ladder->end()) {
+      ladder_itr = book.ladder->emplace(std::make_pair(o.price, NewLevel()))
+                       .first;
     }
-    order_list_itr = list->insert(list->end(), std::move(o));
-    order_id_index_.emplace(
-        std::make_pair(o.id, OrderEntry{order_map_itr, order_list_itr}));
+    level = &ladder_itr->second;
+  } else if (auto price_index_itr = book.price_index.find(o.price);
+             price_index_itr != book.price_index.end()) {
+    // A level for this price already exists.
+    level = &price_index_itr->second->second;
   } else {
-    Price price = o.price;
-    OrderId id = o.id;
-    OrderEntry entry;
-    if (o.side == Side::kSell) {
-      auto [map_itr, list_itr] =
-          AddToOrderMap<SellOrderMap, SellOrderMap::iterator>(sell_orders_,
-                                                              std::move(o));
-      entry.first.sell_order_map_it = map_itr;
-      entry.second = list_itr;
-    } else {
-      auto [map_itr, list_itr] =
-          AddToOrderMap<BuyOrderMap, BuyOrderMap::iterator>(buy_orders_,
-                                                            std::move(o));
-      entry.first.buy_order_map_it = map_itr;
-      entry.second = list_itr;
+    auto order_map_itr =
+        book.orders.emplace(std::make_pair(o.price, NewLevel())).first;
+    book.price_index.emplace(o.price, order_map_itr);
+    level = &order_map_itr->second;
+  }
+  OrderQueue::Ticket ticket = level->orders.push_back(o.id, o.qty);
+  order_id_index_.emplace(std::make_pair(
+      o.id, OrderHandle{.price = o.price, .ticket = ticket, .side = S}));
+  level->qty += o.qty;
+  PublishDepth(S, o.price, level->qty, level->orders.size());
+  const DepthLevel& best = S == Side::kBuy ? bbo_.bid : bbo_.ask;
+  if (best.qty == 0 || !typename BookSide<S>::Compare()(best.price, o.price)) {
+    RefreshBest<S>();
+  }
+}
+
+PriceLevel OrderBook::NewLevel() {
+  PriceLevel level;
+  if (!spare_queues_.empty()) {
+    level.orders = std::move(spare_queues_.back());
+    spare_queues_.pop_back();
+  }
+  return level;
+}
+
+template <Side S>
+PriceLevel& OrderBook::LevelAt(Price price) {
+  BookSide<S>& book = side<S>();
+  return book.ladder.has_value() ? book.ladder->find(price)->second
+                                 : book.price_index.find(price)->second->second;
+}
+
+template <Side S>
+void OrderBook::RemoveOrder(const OrderHandle& handle) {
+  BookSide<S>& book = side<S>();
+  Price price = handle.price;
+  // Orders moved by compacting the level get new tickets.
+  auto moved = [this](OrderId id, OrderQueue::Ticket ticket) {
+    order_id_index_.find(id)->second.ticket = ticket;
+  };
+  if (book.ladder.has_value()) {
+    auto itr = book.ladder->find(price);
+    PublishDepth(S, price,
+                 itr->second.qty - itr->second.orders.at(handle.ticket).qty,
+                 itr->second.orders.size() - 1);
+    RemoveFromOrderMap(*book.ladder, itr, handle.ticket, book.price_index,
+                       spare_queues_, moved);
+  } else {
+    auto itr = book.price_index.find(price)->second;
+    PublishDepth(S, price,
+                 itr->second.qty - itr->second.orders.at(handle.ticket).qty,
+                 itr->second.orders.size() - 1);
+    RemoveFromOrderMap(book.orders, itr, handle.ticket, book.price_index,
+                       spare_queues_, moved);
+  }
+  if (price == (S == Side::kBuy ? bbo_.bid : bbo_.ask).price) {
+    RefreshBest<S>();
+  }
+}
+
+template <Side S>
+void OrderBook::ReduceOrder(const OrderHandle& handle, Quantity qty) {
+  PriceLevel& level = LevelAt<S>(handle.price);
+  OrderQueue::Entry& order = level.orders.at(handle.ticket);
+  level.qty -= order.qty - qty;
+  order.qty = qty;
+  PublishDepth(S, handle.price, level.qty, level.orders.size());
+  if (handle.price == (S == Side::kBuy ? bbo_.bid : bbo_.ask).price) {
+    RefreshBest<S>();
+  }
+}
+
+template <Side S>
+void OrderBook::RefreshBest() {
+  DepthLevel best{};
+  auto top = [&best](auto& levels) {
+    if (levels.empty()) return;
+    auto itr = levels.begin();
+    best = DepthLevel{.price = itr->first,
+                      .qty = itr->second.qty,
+                      .num_orders = itr->second.orders.size()};
+  };
+  BookSide<S>& book = side<S>();
+  if (book.ladder.has_value()) {
+    top(*book.ladder);
+  } else {
+    top(book.orders);
+  }
+  DepthLevel& cached = S == Side::kBuy ? bbo_.bid : bbo_.ask;
+  if (best.price != cached.price || best.qty != cached.qty ||
+      best.num_orders != cached.num_orders) {
+    cached = best;
+    bbo_changed_ = true;
+  }
+}
+
+template <Side S>
+std::vector<DepthLevel> OrderBook::DepthOf(size_t n) const {
+  std::vector<DepthLevel> depth;
+  auto collect = [&depth, n](auto& levels) {
+    for (auto itr = levels.begin(); itr != levels.end() && depth.size() < n;
+         ++itr) {
+      depth.push_back(DepthLevel{.price = itr->first,
+                                 .qty = itr->second.qty,
+                                 .num_orders = itr->second.orders.size()});
     }
-    price_index_.emplace(std::make_pair(price, entry.first));
-    order_id_index_.emplace(std::make_pair(id, std::move(entry)));
+  };
+  const BookSide<S>& book = side<S>();
+  if (book.ladder.has_value()) {
+    // Iterating doesn't modify the ladder, but it only has mutable iterators.
+    collect(const_cast<typename BookSide<S>::OrderLadder&>(*book.ladder));
+  } else {
+    collect(book.orders);
+  }
+  return depth;
+}
+
+std::vector<DepthLevel> OrderBook::Depth(Side side, size_t n) const {
+  return side == Side::kSell ? DepthOf<Side::kSell>(n)
+                             : DepthOf<Side::kBuy>(n);
+}
+
+template <Side S>
+void OrderBook::MatchIncomingOrder(Order& incoming_order) {
+  constexpr Side kOpposite = SidePolicy<S>::kOpposite;
+  BookSide<kOpposite>& resting = side<kOpposite>();
+  if (resting.ladder.has_value()) {
+    MatchOrders<kOpposite>(incoming_order, *resting.ladder);
+  } else {
+    MatchOrders<kOpposite>(incoming_order, resting.orders);
+  }
+}
+
+template <Side S>
+void OrderBook::ProcessIncomingOrder(Order& incoming_order,
+                                     RequestTimer& timer) {
+  MatchIncomingOrder<S>(incoming_order);
+  timer.EndStage(LatencyStage::kMatch);
+  if (incoming_order.qty > 0) {
+    AddOrder<S>(incoming_order);
+    timer.EndStage(LatencyStage::kBookUpdate);
   }
 }
 
 void OrderBook::ProcessOrder(const AddOrderRequest& req) {
+  RequestTimer timer(SampleRequest(), publish_ticks_);
+  ++sequence_;
   // Check that order id isn't being repeated
   auto order_id_index_itr = order_id_index_.find(req.order_id);
   if (order_id_index_itr != order_id_index_.end()) {
-    es_ << "Unable to process: Order id is being repeated: " << req.order_id
+    *es_ << "Unable to process: Order id is being repeated: " << req.order_id
         << std::endl;
+    timer.Finish(MessageType::kAddOrderRequest, Outcome::kRejected);
+    return;
+  }
+  if (sells_.ladder.has_value() && !sells_.ladder->Contains(req.price)) {
+    *es_ << "Unable to process: Price is not on the tick grid: " << req.price
+        << std::endl;
+    timer.Finish(MessageType::kAddOrderRequest, Outcome::kRejected);
     return;
   }
 
   Order incoming_order{
       .id = req.order_id, .side = req.side, .qty = req.qty, .price = req.price};
   if (incoming_order.side == Side::kSell) {
-    MatchOrders(incoming_order, buy_orders_, IncomingSellMatcher);
+    ProcessIncomingOrder<Side::kSell>(incoming_order, timer);
   } else {
-    MatchOrders(incoming_order, sell_orders_, IncomingBuyMatcher);
+    ProcessIncomingOrder<Side::kBuy>(incoming_order, timer);
   }
-  if (incoming_order.qty > 0) {
-    AddOrder(std::move(incoming_order));
+  MaybePublishBbo();
+  Outcome outcome = incoming_order.qty == req.qty ? Outcome::kRested
+                    : incoming_order.qty > 0      ? Outcome::kPartiallyFilled
+                                                  : Outcome::kFullyFilled;
+  timer.Finish(MessageType::kAddOrderRequest, outcome);
+}
+
+void OrderBook::PrefetchIndex(const InputMessage& msg) const {
+  order_id_index_.Prefetch(
+      std::visit([](const auto& req) { return req.order_id; }, msg));
+}
+
+void OrderBook::PrefetchOrder(const InputMessage& msg) const {
+  if (const auto* add = std::get_if<AddOrderRequest>(&msg)) {
+    // Levels of the b-trees are behind a hash map and a tree node, which
+    // aren't worth chasing ahead of time.
+    if (add->side == Side::kSell && sells_.ladder.has_value()) {
+      sells_.ladder->Prefetch(add->price);
+    } else if (add->side == Side::kBuy && buys_.ladder.has_value()) {
+      buys_.ladder->Prefetch(add->price);
+    }
+    return;
+  }
+  // The level of the order of a cancel or modify, on the ladder.
+  OrderId id = std::visit([](const auto& req) { return req.order_id; }, msg);
+  auto itr = order_id_index_.find(id);
+  if (itr == order_id_index_.end()) return;
+  const OrderHandle& handle = itr->second;
+  if (handle.side == Side::kSell && sells_.ladder.has_value()) {
+    sells_.ladder->Prefetch(handle.price);
+  } else if (handle.side == Side::kBuy && buys_.ladder.has_value()) {
+    buys_.ladder->Prefetch(handle.price);
+  }
+}
+
+void OrderBook::ProcessBatch(const InputMessage* msgs, size_t n) {
+  // How far ahead the index slots, then the levels, are prefetched. A slot
+  // must have arrived by the time the level it leads to is.
+  constexpr size_t kIndexDistance = 8;
+  constexpr size_t kOrderDistance = 4;
+  for (size_t i = 0; i < std::min(n, kIndexDistance); ++i) {
+    PrefetchIndex(msgs[i]);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (i + kIndexDistance < n) PrefetchIndex(msgs[i + kIndexDistance]);
+    if (i + kOrderDistance < n) PrefetchOrder(msgs[i + kOrderDistance]);
+    std::visit([this](const auto& req) { ProcessOrder(req); }, msgs[i]);
   }
 }
 
 void OrderBook::ProcessOrder(const CancelOrderRequest& req) {
+  RequestTimer timer(SampleRequest(), publish_ticks_);
+  ++sequence_;
   auto order_id_index_itr = order_id_index_.find(req.order_id);
   if (order_id_index_itr == order_id_index_.end()) {
-    es_ << "No such order with id: " << req.order_id << std::endl;
+    *es_ << "No such order with id: " << req.order_id << std::endl;
+    timer.Finish(MessageType::kCancelOrderRequest, Outcome::kRejected);
     return;
   }
-  IteratorVariant order_map_itr = order_id_index_itr->second.first;
-  OrderList::iterator order_list_itr = order_id_index_itr->second.second;
+  OrderHandle handle = order_id_index_itr->second;
+  timer.EndStage(LatencyStage::kMatch);
 
   // Remove from order id index
   order_id_index_.erase(order_id_index_itr);
 
-  // Remove from order list or the order map
-  if (order_list_itr->side == Side::kBuy) {
-    RemoveFromOrderMap(buy_orders_, order_map_itr.buy_order_map_it,
-                       order_list_itr, price_index_);
+  // Remove from order queue or the order map
+  if (handle.side == Side::kBuy) {
+    RemoveOrder<Side::kBuy>(handle);
   } else {
-    RemoveFromOrderMap(sell_orders_, order_map_itr.sell_order_map_it,
-                       order_list_itr, price_index_);
+    RemoveOrder<Side::kSell>(handle);
+  }
+  timer.EndStage(LatencyStage::kBookUpdate);
+  MaybePublishBbo();
+  timer.Finish(MessageType::kCancelOrderRequest, Outcome::kCanceled);
+}
+
+template <Side S>
+Outcome OrderBook::ModifyOrder(OrderHandle handle,
+                               const ModifyOrderRequest& req,
+                               RequestTimer& timer) {
+  if (req.qty == 0) {
+    timer.EndStage(LatencyStage::kMatch);
+    order_id_index_.erase(req.order_id);
+    RemoveOrder<S>(handle);
+    timer.EndStage(LatencyStage::kBookUpdate);
+    return Outcome::kCanceled;
+  }
+  Quantity qty = LevelAt<S>(handle.price).orders.at(handle.ticket).qty;
+  if (req.price == handle.price && req.qty <= qty) {
+    // Reduced in place, the order keeps its time priority.
+    timer.EndStage(LatencyStage::kMatch);
+    if (req.qty != qty) ReduceOrder<S>(handle, req.qty);
+    timer.EndStage(LatencyStage::kBookUpdate);
+    return Outcome::kRested;
+  }
+
+  // Cancel-replace: the order is taken out of the book and matched like a new
+  // one, then what's left of it goes to the back of the level of its new
+  // price.
+  order_id_index_.erase(req.order_id);
+  RemoveOrder<S>(handle);
+  timer.EndStage(LatencyStage::kBookUpdate);
+  Order order{
+      .id = req.order_id, .side = S, .qty = req.qty, .price = req.price};
+  MatchIncomingOrder<S>(order);
+  timer.EndStage(LatencyStage::kMatch);
+  if (order.qty == 0) return Outcome::kFullyFilled;
+  AddOrder<S>(order);
+  timer.EndStage(LatencyStage::kBookUpdate);
+  return order.qty == req.qty ? Outcome::kRested : Outcome::kPartiallyFilled;
+}
+
+void OrderBook::ProcessOrder(const ModifyOrderRequest& req) {
+  RequestTimer timer(SampleRequest(), publish_ticks_);
+  ++sequence_;
+  auto order_id_index_itr = order_id_index_.find(req.order_id);
+  if (order_id_index_itr == order_id_index_.end()) {
+    *es_ << "No such order with id: " << req.order_id << std::endl;
+    timer.Finish(MessageType::kModifyOrderRequest, Outcome::kRejected);
+    return;
+  }
+  if (sells_.ladder.has_value() && !sells_.ladder->Contains(req.price)) {
+    *es_ << "Unable to process: Price is not on the tick grid: " << req.price
+        << std::endl;
+    timer.Finish(MessageType::kModifyOrderRequest, Outcome::kRejected);
+    return;
   }
+  OrderHandle handle = order_id_index_itr->second;
+  Outcome outcome = handle.side == Side::kSell
+                        ? ModifyOrder<Side::kSell>(handle, req, timer)
+                        : ModifyOrder<Side::kBuy>(handle, req, timer);
+  MaybePublishBbo();
+  timer.Finish(MessageType::kModifyOrderRequest, outcome);
 }
 
-}  // namespace mukhi::matching_engine
\ No newline at end of file
+}  // namespace mukhi::matching_engine
@@ -1,54 +1,139 @@
 #ifndef MATCHING_ENGINE_ORDER_BOOK_H
 #define MATCHING_ENGINE_ORDER_BOOK_H
 
+#include <cstdint>
 #include <functional>
-#include <list>
 #include <map>
+#include <memory>
+#include <optional>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
+#include "event_sink.h"
+#include "latency_stats.h"
 #include "messages.h"
+#include "order_id_map.h"
+#include "order_queue.h"
+#include "price_ladder.h"
 
 namespace mukhi::matching_engine {
 
-struct Order {
-  OrderId id;
-  Side side;
-  Quantity qty;
+/*
+Compile-time policies of the two sides of the book. `Compare` orders the
+resting orders of a side by priority, best price first, and `Crosses` tells
+whether an incoming order of the other side trades with a resting order of the
+side. Since both are known at compile time, matching is specialized for each
+side and the comparisons are inlined.
+*/
+template <Side S>
+struct SidePolicy;
+
+template <>
+struct SidePolicy<Side::kSell> {
+  using Compare = std::less<Price>;
+  static constexpr Side kOpposite = Side::kBuy;
+  static constexpr bool Crosses(Price incoming, Price resting) {
+    return resting <= incoming;
+  }
+};
+
+template <>
+struct SidePolicy<Side::kBuy> {
+  using Compare = std::greater<Price>;
+  static constexpr Side kOpposite = Side::kSell;
+  static constexpr bool Crosses(Price incoming, Price resting) {
+    return incoming <= resting;
+  }
+};
+
+// The resting orders at a price, in time priority, and their total quantity,
+// which is kept up to date as orders are added, filled and canceled.
+struct PriceLevel {
+  OrderQueue orders;
+  Quantity qty = 0;
+};
+
+// The resting orders of side `S`, in price-time priority.
+template <Side S>
+struct BookSide {
+  using Compare = typename SidePolicy<S>::Compare;
+  using OrderMap = std::map<Price, PriceLevel, Compare>;
+  using OrderLadder = PriceLadder<PriceLevel, Compare>;
+
+  OrderMap orders;
+  // Used instead of `orders` in fixed-point price mode.
+  std::optional<OrderLadder> ladder;
+  /**
+   Following map is for optimizing insertion of orders at any price. If there
+   exists an order at the same price, insertion can happen in constant time
+   instead of the default log(n) of b-tree. It also finds the level of an
+   order being canceled in constant time. Unused in fixed-point price mode,
+   where levels are found by price in constant time anyway.
+   */
+  std::unordered_map<Price, typename OrderMap::iterator> price_index;
+};
+
+using SellOrderMap = BookSide<Side::kSell>::OrderMap;
+using BuyOrderMap = BookSide<Side::kBuy>::OrderMap;
+using SellOrderLadder = BookSide<Side::kSell>::OrderLadder;
+using BuyOrderLadder = BookSide<Side::kBuy>::OrderLadder;
+// Where a resting order is: its side and price lead to its level, and its
+// ticket to its entry in the queue of the level. Tickets are updated when the
+// queue is compacted.
+struct OrderHandle {
   Price price;
+  OrderQueue::Ticket ticket;
+  Side side;
 };
-using OrderList = std::list<Order>;
-using SellOrderMap = std::map<Price, OrderList>;
-using BuyOrderMap = std::map<Price, OrderList, std::greater<Price>>;
-/**
- Note that we don't use a std::variant here since the types
-`std::map<PriceOrderList>::iterator` and `std::map<Price, OrderList,
- std::greater<Price>>::iterator` can't be disambigauted. We could technically
-use the same type `std::map<Price,OrderList>::iterator` to capture instances of
-both but that seems like a risky optimization, so to be on the safer side we use
-a struct here.
-*/
-struct IteratorVariant {
-  SellOrderMap::iterator sell_order_map_it;
-  BuyOrderMap::iterator buy_order_map_it;
+using OrderIdIndex = OrderIdMap<OrderHandle>;
+
+struct OrderBookOptions {
+  /**
+   Enables the fixed-point price mode: resting orders are kept on a
+   `PriceLadder` per side instead of a b-tree, and orders with a price that
+   isn't on the grid are rejected. `tick_size` must be positive and `min_price`
+   must not exceed `max_price`.
+   */
+  std::optional<TickGrid> tick_grid;
+
+  // Number of resting orders to preallocate memory for in their index. The
+  // book grows past it as needed.
+  size_t order_capacity = 4096;
+
+  // Symbol of the instrument traded in the book, which all the events it
+  // publishes carry. The book doesn't check the symbol of the requests, routing
+  // them is up to the caller.
+  Symbol symbol;
+
+  // Publishes a `DepthUpdate` whenever the total quantity of a level changes,
+  // once the request changing it is done with the level.
+  bool publish_depth_updates = false;
+  // Publishes the `Bbo` at the end of every request that changed it.
+  bool publish_bbo_updates = false;
 };
-using OrderEntry = std::pair<IteratorVariant, OrderList::iterator>;
-using PriceIndex = std::unordered_map<Price, IteratorVariant>;
 
 /*
 Keeps track of orders that haven't yet been fully filled.
 
-An object of this class keeps references to the streams provided during
-construction and expects these streams to stay alive during the lifetime of the
-object.
+Trade events and fills are published to an `EventSink`, and errors are printed
+on a stream. An object of this class keeps references to the sink and the
+streams provided during construction and expects them to stay alive during the
+lifetime of the object.
 
 Following are the time complexities of various operations on the order book:
 
 * Inserting a new order (partially matched or unmatched): If an order with same
 price and same type (buy/sell) already exists in the book then O(1), otherwise
-O(log(n)).
+O(log(n)). In fixed-point price mode (see `OrderBookOptions`) always O(1).
+
+* Modifying: a lower quantity at the same price is O(1), and keeps the time
+priority of the order. Other changes cost as much as a deletion followed by an
+insertion of an order matched along the way.
 
 * Deletion (canceled or fulfilled): O(1) (Note: that complexity of deleting from
-a b-tree with an iterator to the node being deleted is amortized constant).
+a b-tree with an iterator to the node being deleted is amortized constant, and
+so is that of compacting the queue of a level after cancels, see `OrderQueue`).
 
 * Matching: O(m), where m is the number of resting orders an incoming order
 matches. So determining if there's at least one match is constant time
@@ -58,41 +143,222 @@ This class is not thread-safe.
 */
 class OrderBook {
  public:
-  OrderBook(std::ostream& os, std::ostream& es) : os_(os), es_(es) {}
+  OrderBook(EventSink& sink, std::ostream& es,
+            const OrderBookOptions& options = {});
+  // Writes every event to `os` as soon as it's published, see
+  // `BufferedTextSink`.
+  OrderBook(std::ostream& os, std::ostream& es,
+            const OrderBookOptions& options = {});
 
   void ProcessOrder(const AddOrderRequest& req);
   void ProcessOrder(const CancelOrderRequest& req);
+  void ProcessOrder(const ModifyOrderRequest& req);
+
+  /**
+  Processes the `n` messages of `msgs` in order, as `ProcessOrder` would one at
+  a time. While a message is processed, the index slots of the orders of the
+  messages a few places ahead are prefetched, then the price levels they lead
+  to, so that the cache misses of a message overlap with the work on the ones
+  before it instead of stalling it.
+  */
+  void ProcessBatch(const InputMessage* msgs, size_t n);
+
+  // Returns true if the order `id` is resting in the book.
+  bool Contains(OrderId id) const {
+    return order_id_index_.find(id) != order_id_index_.end();
+  }
+
+  // Returns the best `n` levels of `side`, best first, or all of them if there
+  // are fewer. Levels keep their total quantity and number of orders, so this
+  // takes O(n), whatever the number of orders.
+  std::vector<DepthLevel> Depth(Side side, size_t n) const;
+
+  // The best bid and offer. Cached and only updated when the best level of a
+  // side changes, so reading it is as cheap as reading a field.
+  const Bbo& BestBidOffer() const { return bbo_; }
+
+  // Number of requests processed so far, rejected ones included, counting
+  // from the sequence number of the snapshot loaded, if any.
+  uint64_t sequence() const { return sequence_; }
+
+  // Writes the resting orders of the book to `os` in a compact, versioned and
+  // checksummed binary format, along with `sequence()`. Levels are written in
+  // priority order, and the orders of each level in time priority. Returns
+  // false if writing to `os` fails.
+  //
+  // Snapshots are a bulk copy of the book, meant to restart from in well under
+  // a second instead of replaying all the input since the start of the day.
+  bool SaveSnapshot(std::ostream& os) const;
+
+  // Restores a book saved by `SaveSnapshot` into this one, which must be
+  // empty, e.g. freshly constructed. The snapshot must be for the same symbol,
+  // and in fixed-point price mode all its prices must be on the tick grid.
+  //
+  // Returns false after reporting to the error stream if the snapshot can't be
+  // loaded, including when it's corrupt, in which case the book is left empty.
+  bool LoadSnapshot(std::string_view snapshot);
+
+  // While muted, events aren't published and errors aren't reported, e.g. to
+  // rebuild the book by replaying requests it had processed before a restart.
+  void set_muted(bool muted) {
+    muted_ = muted;
+    UpdateOutputs();
+  }
+
+  // Records the latency of the requests sampled into `stats`, by stage,
+  // message type and outcome, see `LatencyStats`. Requests processed while
+  // muted aren't recorded. `stats` must outlive the book, or be unset with
+  // nullptr.
+  void set_latency_stats(LatencyStats* stats) {
+    latency_stats_ = stats;
+    UpdateOutputs();
+  }
 
  private:
-  // Incoming price, resting price -> successful match.
-  using MatchingFunction = std::function<bool(Price, Price)>;
-  // Match incoming order against resting orders.
-  template <typename MapType>
-  void MatchOrders(Order& incoming_order, MapType& resting_orders,
-                   MatchingFunction match);
-  // Add a new order to the book.
-  void AddOrder(Order o);
-  // Execute trades against the order list of specific price.
-  void ExecuteTrades(Order& incoming_order, OrderList& order_list);
-
-  std::ostream& os_;
-  std::ostream& es_;
-
-  // Tracks all sell orders and keeps them sorted by price.
-  SellOrderMap sell_orders_;
-  // Tracks all buy orders and keeps them sorted by price.
-  BuyOrderMap buy_orders_;
-  // Tracks all orders by id.
-  std::unordered_map<OrderId, OrderEntry> order_id_index_;
+  class SnapshotWriter;
+  class SnapshotReader;
+  class RequestTimer;
 
-  /**
-   Following map is for optimizing insertion of orders at any price. If there
-   exists an order at the same price, insertion can happen in constant time
-   instead of the default log(n) of b-tree. Note that we can keep the same map
-   for both buy and sell since at a given price only one type of the order can
-   be in the book (otherwise they will result in a trade).
-   */
-  PriceIndex price_index_;
+  // Publishes to `sink` if it's set, otherwise to `owned_sink`.
+  OrderBook(std::unique_ptr<EventSink> owned_sink, EventSink* sink,
+            std::ostream& es, const OrderBookOptions& options);
+
+  // The resting orders of side `S`.
+  template <Side S>
+  BookSide<S>& side() {
+    if constexpr (S == Side::kSell) {
+      return sells_;
+    } else {
+      return buys_;
+    }
+  }
+  template <Side S>
+  const BookSide<S>& side() const {
+    return const_cast<OrderBook*>(this)->side<S>();
+  }
+
+  // Matches an incoming order of side `S` against the other side, and adds
+  // what's left of it to the book.
+  template <Side S>
+  void ProcessIncomingOrder(Order& incoming_order, RequestTimer& timer);
+  // Matches an incoming order of side `S` against the other side.
+  template <Side S>
+  void MatchIncomingOrder(Order& incoming_order);
+  // Applies a modify request to the resting order of side `S` at `handle`, and
+  // returns what came of it.
+  template <Side S>
+  Outcome ModifyOrder(OrderHandle handle, const ModifyOrderRequest& req,
+                      RequestTimer& timer);
+  // Match incoming order against resting orders of side `S`, kept in `levels`.
+  template <Side S, typename Levels>
+  void MatchOrders(Order& incoming_order, Levels& levels);
+  template <Side S>
+  std::vector<DepthLevel> DepthOf(size_t n) const;
+  // Updates the cached best level of side `S` from its levels.
+  template <Side S>
+  void RefreshBest();
+  // Publishes the BBO if it changed since it was last published, if enabled.
+  void MaybePublishBbo() {
+    if (!bbo_changed_) return;
+    bbo_changed_ = false;
+    if (!publish_bbo_updates_) return;
+    uint64_t publish_start = StartPublishing();
+    sink_->OnBboUpdate(bbo_);
+    EndPublishing(publish_start);
+  }
+  // Time the publishing of events, if the request is timed: returns the
+  // start of a block of events, and adds the ticks since to `publish_ticks_`.
+  uint64_t StartPublishing() const { return timed_ ? ReadTsc() : 0; }
+  void EndPublishing(uint64_t start) {
+    if (timed_) publish_ticks_ += ReadTsc() - start;
+  }
+  // Returns where to record the latency of the request starting, if it's
+  // sampled.
+  LatencyStats* SampleRequest() {
+    timed_ = stats_ != nullptr && --sample_countdown_ == 0;
+    if (!timed_) return nullptr;
+    sample_countdown_ = stats_->sample_interval();
+    return stats_;
+  }
+  // Start loading what processing `msg` will touch: the slot of its order in
+  // the index, then its price level, once the slot has been loaded.
+  void PrefetchIndex(const InputMessage& msg) const;
+  void PrefetchOrder(const InputMessage& msg) const;
+  // Add a new order to the book, at the back of the level of its price.
+  template <Side S>
+  void AddOrder(const Order& o);
+  // An empty level, which reuses the queue of a level gone if there's one.
+  PriceLevel NewLevel();
+  // The level of side `S` at `price`, which must exist.
+  template <Side S>
+  PriceLevel& LevelAt(Price price);
+  // Removes a resting order, already out of the index, from its level.
+  template <Side S>
+  void RemoveOrder(const OrderHandle& handle);
+  // Lowers the quantity of a resting order to `qty`, in place.
+  template <Side S>
+  void ReduceOrder(const OrderHandle& handle, Quantity qty);
+  // Execute trades against the orders of a price level.
+  void ExecuteTrades(Order& incoming_order, Price price, PriceLevel& level);
+  // Publishes the new state of a level, if enabled. Both `qty` and
+  // `num_orders` are 0 once the level is gone.
+  void PublishDepth(Side side, Price price, Quantity qty, size_t num_orders) {
+    if (!publish_depth_updates_) return;
+    uint64_t publish_start = StartPublishing();
+    sink_->OnDepthUpdate(DepthUpdate{.side = side,
+                                     .price = price,
+                                     .qty = qty,
+                                     .num_orders = num_orders,
+                                     .symbol = symbol_});
+    EndPublishing(publish_start);
+  }
+
+  template <Side S>
+  void SaveLevels(SnapshotWriter& writer) const;
+  // Returns false, after reporting why, if the levels can't be loaded.
+  template <Side S>
+  bool LoadLevels(SnapshotReader& reader);
+  // Points `sink_`, `es_` and `stats_` to where events, errors and latencies
+  // go, depending on whether the book is muted.
+  void UpdateOutputs();
+  // Frees all the resting orders.
+  void Clear();
+  template <Side S>
+  void ClearSide();
+
+  // Only set when constructed with an output stream.
+  std::unique_ptr<EventSink> owned_sink_;
+  EventSink& output_sink_;
+  std::ostream& output_es_;
+  // Where events and errors go: the above, or nowhere while muted.
+  EventSink* sink_;
+  std::ostream* es_;
+  NullEventSink null_sink_;
+  std::ostream null_es_{nullptr};
+  bool muted_ = false;
+  LatencyStats* latency_stats_ = nullptr;
+  // Where latencies are recorded, if anywhere.
+  LatencyStats* stats_ = nullptr;
+  // Requests left until the next one sampled.
+  uint32_t sample_countdown_ = 1;
+  // Whether the request being processed is timed.
+  bool timed_ = false;
+  // Ticks spent publishing the events of timed requests so far.
+  uint64_t publish_ticks_ = 0;
+  const Symbol symbol_;
+  const bool publish_depth_updates_;
+  const bool publish_bbo_updates_;
+
+  BookSide<Side::kSell> sells_;
+  BookSide<Side::kBuy> buys_;
+  // Tracks all orders by id.
+  OrderIdIndex order_id_index_;
+  // The emptied queues of the levels gone, kept so that new levels don't
+  // allocate their buffers again.
+  std::vector<OrderQueue> spare_queues_;
+  uint64_t sequence_ = 0;
+  Bbo bbo_;
+  bool bbo_changed_ = false;
 
 #ifdef UNIT_TEST
   friend class OrderBookTest;
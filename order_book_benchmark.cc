@@ -0,0 +1,207 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "event_sink.h"
+#include "order_book.h"
+
+// Every benchmark takes the price mode as its first argument: 0 for the
+// default b-tree mode and 1 for the fixed-point price mode.
+
+namespace mukhi::matching_engine {
+namespace {
+
+constexpr Price kMid = 100000;
+
+OrderBookOptions Options(const benchmark::State& state) {
+  OrderBookOptions options;
+  if (state.range(0) == 1) {
+    options.tick_grid =
+        TickGrid{.tick_size = 1, .min_price = 1, .max_price = 2 * kMid};
+  }
+  return options;
+}
+
+AddOrderRequest Add(OrderId id, Side side, Quantity qty, Price price) {
+  return AddOrderRequest{
+      .order_id = id, .side = side, .qty = qty, .price = price};
+}
+
+// Resting orders that never cross, spread over 1500 levels per side (like
+// testdata/no_trade).
+void BM_InsertOnly(benchmark::State& state) {
+  constexpr int kOrders = 6000;
+  std::vector<AddOrderRequest> orders;
+  for (int i = 0; i < kOrders; ++i) {
+    Price offset = 1 + (i / 2) % 1500;
+    orders.push_back(i % 2 == 0 ? Add(i, Side::kBuy, 5, kMid - offset)
+                                : Add(i, Side::kSell, 5, kMid + offset));
+  }
+
+  NullEventSink sink;
+  NullStream es;
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto book = std::make_unique<OrderBook>(sink, es, Options(state));
+    state.ResumeTiming();
+    uint64_t start = AllocationCount();
+    for (const AddOrderRequest& req : orders) book->ProcessOrder(req);
+    allocations += AllocationCount() - start;
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
+  }
+  ReportPerOp(state, state.iterations() * kOrders, allocations);
+}
+BENCHMARK(BM_InsertOnly)->ArgName("ladder")->Arg(0)->Arg(1);
+
+// A single level that grows deep and is then consumed from the front by
+// incoming orders of the opposite side (like testdata/order_book_grows_large).
+void BM_DeepBook(benchmark::State& state) {
+  const int depth = state.range(1);
+  std::vector<AddOrderRequest> orders;
+  for (int i = 0; i < depth; ++i) orders.push_back(Add(i, Side::kBuy, 5, kMid));
+  for (int i = 0; i < depth; ++i) {
+    // Each sell fills one and a half resting buys on average.
+    orders.push_back(Add(depth + i, Side::kSell, i % 2 == 0 ? 5 : 10, kMid));
+  }
+
+  NullEventSink sink;
+  NullStream es;
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto book = std::make_unique<OrderBook>(sink, es, Options(state));
+    state.ResumeTiming();
+    uint64_t start = AllocationCount();
+    for (const AddOrderRequest& req : orders) book->ProcessOrder(req);
+    allocations += AllocationCount() - start;
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
+  }
+  ReportPerOp(state, state.iterations() * orders.size(), allocations);
+}
+BENCHMARK(BM_DeepBook)
+    ->ArgNames({"ladder", "depth"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}});
+
+// A book of steady size where every op cancels the oldest resting order and
+// adds a new one at a random level near the touch.
+void BM_CancelHeavy(benchmark::State& state) {
+  const int depth = state.range(1);
+  std::mt19937_64 rng(42);
+  std::vector<AddOrderRequest> orders;
+  for (int i = 0; i < 1 << 16; ++i) {
+    Price offset = 1 + rng() % 100;
+    orders.push_back(rng() % 2 == 0 ? Add(i, Side::kBuy, 5, kMid - offset)
+                                    : Add(i, Side::kSell, 5, kMid + offset));
+  }
+
+  NullEventSink sink;
+  NullStream es;
+  OrderBook book(sink, es, Options(state));
+  OrderId next = 0;
+  OrderId oldest = 0;
+  auto add = [&] {
+    AddOrderRequest req = orders[next % orders.size()];
+    req.order_id = next++;
+    book.ProcessOrder(req);
+  };
+  for (int i = 0; i < depth; ++i) add();
+
+  uint64_t start = AllocationCount();
+  for (auto _ : state) {
+    book.ProcessOrder(CancelOrderRequest{.order_id = oldest++});
+    add();
+  }
+  ReportPerOp(state, state.iterations() * 2, AllocationCount() - start);
+}
+BENCHMARK(BM_CancelHeavy)
+    ->ArgNames({"ladder", "depth"})
+    ->ArgsProduct({{0, 1}, {1000, 100000}});
+
+// A single aggressive order sweeping every level of the opposite side.
+void BM_AggressiveSweep(benchmark::State& state) {
+  const int levels = state.range(1);
+  constexpr int kOrdersPerLevel = 4;
+
+  NullEventSink sink;
+  NullStream es;
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto book = std::make_unique<OrderBook>(sink, es, Options(state));
+    OrderId id = 0;
+    for (int level = 0; level < levels; ++level) {
+      for (int i = 0; i < kOrdersPerLevel; ++i) {
+        book->ProcessOrder(Add(id++, Side::kSell, 5, kMid + 2 * level));
+      }
+    }
+    AddOrderRequest sweep =
+        Add(id, Side::kBuy, 5 * kOrdersPerLevel * levels, kMid + 2 * levels);
+    state.ResumeTiming();
+    uint64_t start = AllocationCount();
+    book->ProcessOrder(sweep);
+    allocations += AllocationCount() - start;
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
+  }
+  // An op is the fill of one resting order.
+  ReportPerOp(state, state.iterations() * levels * kOrdersPerLevel,
+              allocations);
+}
+BENCHMARK(BM_AggressiveSweep)
+    ->ArgNames({"ladder", "levels"})
+    ->ArgsProduct({{0, 1}, {16, 1024}});
+
+// Restores a book of a million orders, spread over the levels near the touch,
+// from a snapshot.
+void BM_LoadSnapshot(benchmark::State& state) {
+  constexpr int kNumOrders = 1 << 20;
+  NullEventSink sink;
+  NullStream es;
+  std::string snapshot;
+  {
+    OrderBook book(sink, es, Options(state));
+    std::mt19937_64 rng(42);
+    for (int i = 0; i < kNumOrders; ++i) {
+      Price offset = 1 + rng() % 1000;
+      book.ProcessOrder(rng() % 2 == 0
+                            ? Add(i, Side::kBuy, 5, kMid - offset)
+                            : Add(i, Side::kSell, 5, kMid + offset));
+    }
+    std::ostringstream os;
+    book.SaveSnapshot(os);
+    snapshot = os.str();
+  }
+
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto book = std::make_unique<OrderBook>(sink, es, Options(state));
+    state.ResumeTiming();
+    uint64_t start = AllocationCount();
+    benchmark::DoNotOptimize(book->LoadSnapshot(snapshot));
+    allocations += AllocationCount() - start;
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
+  }
+  ReportPerOp(state, state.iterations() * kNumOrders, allocations);
+}
+BENCHMARK(BM_LoadSnapshot)
+    ->ArgName("ladder")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace mukhi::matching_engine
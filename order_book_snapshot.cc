@@ -0,0 +1,311 @@
+#include "order_book.h"
+
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace mukhi::matching_engine {
+
+namespace {
+/*
+Format of the snapshots, in which all integers are little-endian, prices are
+IEEE 754 doubles, and every field is 8 bytes or part of an 8 byte group:
+
+Header (40 bytes): magic u32 ("MEOB"), version u16, reserved u16, sequence
+u64, number of orders u64, symbol (16 bytes, padded with zeros).
+
+Sell side, then buy side: number of levels u64, then for each level in
+priority order: price f64, number of orders u64, then for each order in time
+priority: orderid u64, quantity u64.
+
+Trailer (8 bytes): checksum u64 of everything before it.
+*/
+constexpr uint32_t kSnapshotMagic = 0x424F454D;
+constexpr uint16_t kSnapshotVersion = 1;
+constexpr size_t kHeaderSize = 40;
+constexpr size_t kTrailerSize = 8;
+// Size of a level or an order.
+constexpr size_t kEntrySize = 16;
+constexpr uint64_t kChecksumSeed = 0xCBF29CE484222325;
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Snapshots are stored in the native byte order");
+
+/*
+Hashes the 8 byte words of `data`, of which the size must be a multiple of 8,
+starting from `checksum`. Both steps of a round are invertible, so a change of
+any single word always changes the result. This detects corruption, it isn't
+meant to resist tampering.
+*/
+uint64_t Checksum(uint64_t checksum, std::string_view data) {
+  for (size_t i = 0; i + 8 <= data.size(); i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data.data() + i, 8);
+    checksum = (checksum ^ word) * 0x9E3779B97F4A7C15;
+    checksum ^= checksum >> 29;
+  }
+  return checksum;
+}
+
+bool Fail(std::ostream& es, std::string_view reason) {
+  es << "Unable to load snapshot: " << reason << std::endl;
+  return false;
+}
+}  // namespace
+
+// Writes the snapshot in large chunks, hashing them on the way out.
+class OrderBook::SnapshotWriter {
+ public:
+  explicit SnapshotWriter(std::ostream& os) : os_(os) {
+    buf_.reserve(kBufferSize + kEntrySize);
+  }
+
+  template <typename T>
+  void Append(T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    buf_.append(bytes, sizeof(T));
+  }
+
+  void AppendSymbol(const Symbol& symbol) {
+    char bytes[Symbol::kMaxSize] = {};
+    std::string_view s = symbol.view();
+    std::memcpy(bytes, s.data(), s.size());
+    buf_.append(bytes, Symbol::kMaxSize);
+  }
+
+  // Writes out the buffer once it's full, at the end of an entry.
+  void MaybeFlush() {
+    if (buf_.size() >= kBufferSize) Flush();
+  }
+
+  // Appends the checksum and writes out the rest of the snapshot.
+  bool Finish() {
+    Flush();
+    Append(checksum_);
+    os_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+    os_.flush();
+    return static_cast<bool>(os_);
+  }
+
+ private:
+  static constexpr size_t kBufferSize = 64 << 10;
+
+  void Flush() {
+    checksum_ = Checksum(checksum_, buf_);
+    os_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+    buf_.clear();
+  }
+
+  std::ostream& os_;
+  std::string buf_;
+  uint64_t checksum_ = kChecksumSeed;
+};
+
+// Reads the fields of a snapshot, which has been checked to be complete.
+class OrderBook::SnapshotReader {
+ public:
+  explicit SnapshotReader(std::string_view data) : data_(data) {}
+
+  // Returns false if there are fewer than `sizeof(T)` bytes left.
+  template <typename T>
+  bool Read(T& value) {
+    if (data_.size() < sizeof(T)) return false;
+    std::memcpy(&value, data_.data(), sizeof(T));
+    data_.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  std::string_view ReadSymbol() {
+    std::string_view s = data_.substr(0, Symbol::kMaxSize);
+    data_.remove_prefix(s.size());
+    return s.substr(0, strnlen(s.data(), s.size()));
+  }
+
+  size_t size() const { return data_.size(); }
+
+ private:
+  std::string_view data_;
+};
+
+template <Side S>
+void OrderBook::SaveLevels(SnapshotWriter& writer) const {
+  auto save = [&writer](auto& levels) {
+    writer.Append<uint64_t>(levels.size());
+    for (const auto& [price, level] : levels) {
+      writer.Append(price);
+      writer.Append<uint64_t>(level.orders.size());
+      for (const OrderQueue::Entry& order : level.orders) {
+        writer.Append(order.id);
+        writer.Append(order.qty);
+        writer.MaybeFlush();
+      }
+    }
+  };
+  const BookSide<S>& book = side<S>();
+  if (book.ladder.has_value()) {
+    // Iterating doesn't modify the ladder, but it only has mutable iterators.
+    save(const_cast<typename BookSide<S>::OrderLadder&>(*book.ladder));
+  } else {
+    save(book.orders);
+  }
+}
+
+bool OrderBook::SaveSnapshot(std::ostream& os) const {
+  SnapshotWriter writer(os);
+  writer.Append(kSnapshotMagic);
+  writer.Append(kSnapshotVersion);
+  writer.Append<uint16_t>(0);
+  writer.Append(sequence_);
+  writer.Append<uint64_t>(order_id_index_.size());
+  writer.AppendSymbol(symbol_);
+  SaveLevels<Side::kSell>(writer);
+  SaveLevels<Side::kBuy>(writer);
+  return writer.Finish();
+}
+
+template <Side S>
+bool OrderBook::LoadLevels(SnapshotReader& reader) {
+  BookSide<S>& book = side<S>();
+  typename BookSide<S>::Compare compare;
+  uint64_t num_levels;
+  if (!reader.Read(num_levels) || num_levels > reader.size() / kEntrySize) {
+    return Fail(*es_, "truncated");
+  }
+  if (!book.ladder.has_value()) book.price_index.reserve(num_levels);
+  std::optional<Price> previous_price;
+  for (uint64_t i = 0; i < num_levels; ++i) {
+    Price price;
+    uint64_t num_orders;
+    if (!reader.Read(price) || !reader.Read(num_orders) ||
+        num_orders > reader.size() / kEntrySize) {
+      return Fail(*es_, "truncated");
+    }
+    if (num_orders == 0 ||
+        (previous_price.has_value() && !compare(*previous_price, price))) {
+      return Fail(*es_, "levels are out of order");
+    }
+    previous_price = price;
+
+    PriceLevel* level;
+    if (book.ladder.has_value()) {
+      if (!book.ladder->Contains(price)) {
+        return Fail(*es_, "price is not on the tick grid");
+      }
+      level = &book.ladder->emplace(std::make_pair(price, PriceLevel()))
+                   .first->second;
+    } else {
+      // Levels come in order, so each one goes right at the end of the map.
+      auto order_map_itr = book.orders.emplace_hint(
+          book.orders.end(), std::make_pair(price, PriceLevel()));
+      book.price_index.emplace(price, order_map_itr);
+      level = &order_map_itr->second;
+    }
+    for (uint64_t j = 0; j < num_orders; ++j) {
+      OrderId id = 0;
+      Quantity qty = 0;
+      reader.Read(id);
+      reader.Read(qty);
+      if (qty == 0) return Fail(*es_, "order without quantity");
+      OrderHandle handle{.price = price,
+                         .ticket = level->orders.push_back(id, qty),
+                         .side = S};
+      level->qty += qty;
+      if (!order_id_index_.emplace(std::make_pair(id, handle)).second) {
+        return Fail(*es_, "order id is repeated");
+      }
+    }
+  }
+  return true;
+}
+
+bool OrderBook::LoadSnapshot(std::string_view snapshot) {
+  if (!order_id_index_.empty()) {
+    return Fail(*es_, "the order book isn't empty");
+  }
+  if (snapshot.size() < kHeaderSize + kTrailerSize ||
+      snapshot.size() % 8 != 0) {
+    return Fail(*es_, "truncated");
+  }
+  std::string_view body = snapshot.substr(0, snapshot.size() - kTrailerSize);
+  uint64_t checksum;
+  std::memcpy(&checksum, snapshot.data() + body.size(), kTrailerSize);
+  if (Checksum(kChecksumSeed, body) != checksum) {
+    return Fail(*es_, "checksum mismatch");
+  }
+
+  SnapshotReader reader(body);
+  uint32_t magic = 0;
+  uint16_t version = 0;
+  uint16_t reserved = 0;
+  uint64_t sequence = 0;
+  uint64_t num_orders = 0;
+  if (!reader.Read(magic) || !reader.Read(version) || !reader.Read(reserved) ||
+      !reader.Read(sequence) || !reader.Read(num_orders)) {
+    return Fail(*es_, "truncated");
+  }
+  if (magic != kSnapshotMagic) return Fail(*es_, "not a snapshot");
+  if (version != kSnapshotVersion) {
+    return Fail(*es_, "unsupported version " + std::to_string(version));
+  }
+  if (reader.ReadSymbol() != symbol_.view()) {
+    return Fail(*es_, "snapshot of another symbol");
+  }
+  if (num_orders > reader.size() / kEntrySize) return Fail(*es_, "truncated");
+
+  order_id_index_.reserve(num_orders);
+  bool loaded = LoadLevels<Side::kSell>(reader) &&
+                LoadLevels<Side::kBuy>(reader) &&
+                (reader.size() == 0 || Fail(*es_, "trailing data")) &&
+                (order_id_index_.size() == num_orders ||
+                 Fail(*es_, "wrong number of orders"));
+  auto best_price = [](auto& book) -> std::optional<Price> {
+    if (book.ladder.has_value()) {
+      if (book.ladder->empty()) return std::nullopt;
+      return book.ladder->begin()->first;
+    }
+    if (book.orders.empty()) return std::nullopt;
+    return book.orders.begin()->first;
+  };
+  if (loaded) {
+    std::optional<Price> best_sell = best_price(sells_);
+    std::optional<Price> best_buy = best_price(buys_);
+    if (best_sell.has_value() && best_buy.has_value() &&
+        *best_sell <= *best_buy) {
+      loaded = Fail(*es_, "the book is crossed");
+    }
+  }
+  if (!loaded) {
+    Clear();
+    return false;
+  }
+  sequence_ = sequence;
+  RefreshBest<Side::kSell>();
+  RefreshBest<Side::kBuy>();
+  // Loading isn't a change of the market.
+  bbo_changed_ = false;
+  return true;
+}
+
+template <Side S>
+void OrderBook::ClearSide() {
+  BookSide<S>& book = side<S>();
+  if (book.ladder.has_value()) {
+    for (auto itr = book.ladder->begin(); itr != book.ladder->end();) {
+      itr = book.ladder->erase(itr);
+    }
+  } else {
+    book.orders.clear();
+    book.price_index.clear();
+  }
+}
+
+void OrderBook::Clear() {
+  ClearSide<Side::kSell>();
+  ClearSide<Side::kBuy>();
+  order_id_index_.clear();
+}
+
+}  // namespace mukhi::matching_engine
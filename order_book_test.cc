@@ -4,6 +4,10 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
 
 // Note that the code in these tests may seem repetitive but keeping with the
 // DRY vs DAMP concept we are purposefully repeating code in order to keep
@@ -15,12 +19,21 @@ class OrderBookTest : public ::testing::Test {
  protected:
   void SetUp() { b = std::make_unique<OrderBook>(oss, ess); }
 
-  const SellOrderMap& sell_order_map() const { return b->sell_orders_; }
-  const BuyOrderMap& buy_order_map() const { return b->buy_orders_; }
-  const std::unordered_map<OrderId, OrderEntry>& order_id_index() const {
-    return b->order_id_index_;
+  const SellOrderMap& sell_order_map() const { return b->sells_.orders; }
+  const BuyOrderMap& buy_order_map() const { return b->buys_.orders; }
+  const OrderIdIndex& order_id_index() const { return b->order_id_index_; }
+  // Number of prices in the price indexes of both sides.
+  size_t price_index_size() const {
+    return b->sells_.price_index.size() + b->buys_.price_index.size();
+  }
+  SellOrderLadder& sell_order_ladder() const { return *b->sells_.ladder; }
+  BuyOrderLadder& buy_order_ladder() const { return *b->buys_.ladder; }
+
+  // Recreates the order book in fixed-point price mode.
+  void UseTickGrid(const TickGrid& grid) {
+    b = std::make_unique<OrderBook>(oss, ess,
+                                    OrderBookOptions{.tick_grid = grid});
   }
-  const PriceIndex& price_index() const { return b->price_index_; }
 
   std::ostringstream oss;
   std::ostringstream ess;
@@ -37,7 +50,7 @@ TEST_F(OrderBookTest, SingleInsert) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 }
 
@@ -51,7 +64,7 @@ TEST_F(OrderBookTest, RepeatedOrderId) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   // Repeat the order id.
@@ -63,7 +76,7 @@ TEST_F(OrderBookTest, RepeatedOrderId) {
   // State remains unchanged.
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 }
 
@@ -76,7 +89,7 @@ TEST_F(OrderBookTest, SingleCancel) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
   EXPECT_EQ(order_id_index().size(), 0);
 }
 
@@ -90,7 +103,7 @@ TEST_F(OrderBookTest, SingleInsertAndCancelSell) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   CancelOrderRequest can{.order_id = 1111};
@@ -100,7 +113,7 @@ TEST_F(OrderBookTest, SingleInsertAndCancelSell) {
   EXPECT_EQ(oss.str(), "");
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
   EXPECT_EQ(order_id_index().size(), 0);
 }
 
@@ -114,7 +127,7 @@ TEST_F(OrderBookTest, SingleInsertAndCancelBuy) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   CancelOrderRequest can{.order_id = 1111};
@@ -124,7 +137,7 @@ TEST_F(OrderBookTest, SingleInsertAndCancelBuy) {
   EXPECT_EQ(oss.str(), "");
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
   EXPECT_EQ(order_id_index().size(), 0);
 }
 
@@ -138,7 +151,7 @@ TEST_F(OrderBookTest, MultipleSellInserts) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest req2{
@@ -149,9 +162,9 @@ TEST_F(OrderBookTest, MultipleSellInserts) {
   EXPECT_EQ(oss.str(), "");
 
   EXPECT_EQ(sell_order_map().size(), 1);
-  EXPECT_EQ(sell_order_map().begin()->second.size(), 2);
+  EXPECT_EQ(sell_order_map().begin()->second.orders.size(), 2);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 2);
 
   AddOrderRequest req3{
@@ -163,7 +176,7 @@ TEST_F(OrderBookTest, MultipleSellInserts) {
 
   EXPECT_EQ(sell_order_map().size(), 2);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 2);
+  EXPECT_EQ(price_index_size(), 2);
   EXPECT_EQ(order_id_index().size(), 3);
 }
 
@@ -177,7 +190,7 @@ TEST_F(OrderBookTest, MultipleBuyInserts) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest req2{
@@ -189,8 +202,8 @@ TEST_F(OrderBookTest, MultipleBuyInserts) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(buy_order_map().begin()->second.size(), 2);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(buy_order_map().begin()->second.orders.size(), 2);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 2);
 
   AddOrderRequest req3{
@@ -202,7 +215,7 @@ TEST_F(OrderBookTest, MultipleBuyInserts) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 2);
-  EXPECT_EQ(price_index().size(), 2);
+  EXPECT_EQ(price_index_size(), 2);
   EXPECT_EQ(order_id_index().size(), 3);
 }
 
@@ -216,7 +229,7 @@ TEST_F(OrderBookTest, MultipleInsertsAndCancel) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest add2{
@@ -228,8 +241,8 @@ TEST_F(OrderBookTest, MultipleInsertsAndCancel) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(buy_order_map().begin()->second.size(), 2);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(buy_order_map().begin()->second.orders.size(), 2);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 2);
 
   CancelOrderRequest can1{.order_id = 1111};
@@ -240,7 +253,7 @@ TEST_F(OrderBookTest, MultipleInsertsAndCancel) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   CancelOrderRequest can2{.order_id = 1112};
@@ -251,7 +264,7 @@ TEST_F(OrderBookTest, MultipleInsertsAndCancel) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
   EXPECT_EQ(order_id_index().size(), 0);
 }
 
@@ -265,7 +278,7 @@ TEST_F(OrderBookTest, NoTradeOccurs) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest buy{
@@ -277,7 +290,7 @@ TEST_F(OrderBookTest, NoTradeOccurs) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 2);
+  EXPECT_EQ(price_index_size(), 2);
   EXPECT_EQ(order_id_index().size(), 2);
 }
 
@@ -291,7 +304,7 @@ TEST_F(OrderBookTest, TradeOccursBothFullfilledIncomingBuy) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest buy{
@@ -310,7 +323,7 @@ TEST_F(OrderBookTest, TradeOccursBothFullfilledIncomingBuy) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
   EXPECT_EQ(order_id_index().size(), 0);
 }
 
@@ -324,7 +337,7 @@ TEST_F(OrderBookTest, TradeOccursBothFullfilledIncomingSell) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest sell{
@@ -343,7 +356,7 @@ TEST_F(OrderBookTest, TradeOccursBothFullfilledIncomingSell) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
   EXPECT_EQ(order_id_index().size(), 0);
 }
 
@@ -357,7 +370,7 @@ TEST_F(OrderBookTest, TradeOccursRestingSellFullfilled) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest buy{
@@ -377,7 +390,7 @@ TEST_F(OrderBookTest, TradeOccursRestingSellFullfilled) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 }
 
@@ -391,7 +404,7 @@ TEST_F(OrderBookTest, TradeOccursRestingBuyFullfilled) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest sell{
@@ -411,7 +424,7 @@ TEST_F(OrderBookTest, TradeOccursRestingBuyFullfilled) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 }
 
@@ -425,7 +438,7 @@ TEST_F(OrderBookTest, TradeOccursIncomingBuyFullfilled) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest buy{
@@ -445,7 +458,7 @@ TEST_F(OrderBookTest, TradeOccursIncomingBuyFullfilled) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 }
 
@@ -459,7 +472,7 @@ TEST_F(OrderBookTest, TradeOccursIncomingSellFullfilled) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest sell{
@@ -479,7 +492,7 @@ TEST_F(OrderBookTest, TradeOccursIncomingSellFullfilled) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 }
 
@@ -493,7 +506,7 @@ TEST_F(OrderBookTest, IncomingBuyOrderMatchMultipleRestingOrdersFullfills) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest sell2{
@@ -505,7 +518,7 @@ TEST_F(OrderBookTest, IncomingBuyOrderMatchMultipleRestingOrdersFullfills) {
 
   EXPECT_EQ(sell_order_map().size(), 2);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 2);
+  EXPECT_EQ(price_index_size(), 2);
   EXPECT_EQ(order_id_index().size(), 2);
 
   AddOrderRequest buy{
@@ -534,7 +547,7 @@ TEST_F(OrderBookTest, IncomingBuyOrderMatchMultipleRestingOrdersFullfills) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
   EXPECT_EQ(order_id_index().size(), 0);
 }
 
@@ -548,7 +561,7 @@ TEST_F(OrderBookTest, IncomingSellOrderMatchMultipleRestingOrdersFullfills) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest buy2{
@@ -560,7 +573,7 @@ TEST_F(OrderBookTest, IncomingSellOrderMatchMultipleRestingOrdersFullfills) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 2);
-  EXPECT_EQ(price_index().size(), 2);
+  EXPECT_EQ(price_index_size(), 2);
   EXPECT_EQ(order_id_index().size(), 2);
 
   AddOrderRequest sell{
@@ -589,7 +602,7 @@ TEST_F(OrderBookTest, IncomingSellOrderMatchMultipleRestingOrdersFullfills) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
   EXPECT_EQ(order_id_index().size(), 0);
 }
 
@@ -603,7 +616,7 @@ TEST_F(OrderBookTest, MultipleRestingSellOrdersSamePriceOneExecutes) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest sell2{
@@ -614,9 +627,9 @@ TEST_F(OrderBookTest, MultipleRestingSellOrdersSamePriceOneExecutes) {
   EXPECT_EQ(oss.str(), "");
 
   EXPECT_EQ(sell_order_map().size(), 1);
-  EXPECT_EQ(sell_order_map().begin()->second.size(), 2);
+  EXPECT_EQ(sell_order_map().begin()->second.orders.size(), 2);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 2);
 
   AddOrderRequest buy{
@@ -635,7 +648,7 @@ TEST_F(OrderBookTest, MultipleRestingSellOrdersSamePriceOneExecutes) {
 
   EXPECT_EQ(sell_order_map().size(), 1);
   EXPECT_EQ(buy_order_map().size(), 0);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 }
 
@@ -649,7 +662,7 @@ TEST_F(OrderBookTest, MultipleRestingBuyOrdersSamePriceOneExecutes) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 1);
 
   AddOrderRequest buy2{
@@ -661,8 +674,8 @@ TEST_F(OrderBookTest, MultipleRestingBuyOrdersSamePriceOneExecutes) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(buy_order_map().begin()->second.size(), 2);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(buy_order_map().begin()->second.orders.size(), 2);
+  EXPECT_EQ(price_index_size(), 1);
   EXPECT_EQ(order_id_index().size(), 2);
 
   AddOrderRequest sell{
@@ -681,8 +694,999 @@ TEST_F(OrderBookTest, MultipleRestingBuyOrdersSamePriceOneExecutes) {
 
   EXPECT_EQ(sell_order_map().size(), 0);
   EXPECT_EQ(buy_order_map().size(), 1);
-  EXPECT_EQ(price_index().size(), 1);
+  EXPECT_EQ(price_index_size(), 1);
+  EXPECT_EQ(order_id_index().size(), 1);
+}
+
+TEST_F(OrderBookTest, LadderInsertAndCancel) {
+  UseTickGrid({.tick_size = 0.5, .min_price = 1, .max_price = 100});
+  AddOrderRequest sell{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.5};
+  b->ProcessOrder(sell);
+  AddOrderRequest buy{
+      .order_id = 1112, .side = Side::kBuy, .qty = 15, .price = 10.0};
+  b->ProcessOrder(buy);
+
+  // Nothing is printed when no trade occurs.
+  EXPECT_EQ(oss.str(), "");
+
+  EXPECT_EQ(sell_order_ladder().size(), 1);
+  EXPECT_EQ(buy_order_ladder().size(), 1);
+  // Neither the b-trees nor the price index are used.
+  EXPECT_EQ(sell_order_map().size(), 0);
+  EXPECT_EQ(buy_order_map().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
+  EXPECT_EQ(order_id_index().size(), 2);
+
+  CancelOrderRequest can1{.order_id = 1111};
+  b->ProcessOrder(can1);
+  CancelOrderRequest can2{.order_id = 1112};
+  b->ProcessOrder(can2);
+
+  EXPECT_EQ(oss.str(), "");
+  EXPECT_EQ(ess.str(), "");
+  EXPECT_EQ(sell_order_ladder().size(), 0);
+  EXPECT_EQ(buy_order_ladder().size(), 0);
+  EXPECT_EQ(order_id_index().size(), 0);
+}
+
+TEST_F(OrderBookTest, LadderOffGridPriceRejected) {
+  UseTickGrid({.tick_size = 0.5, .min_price = 1, .max_price = 100});
+  AddOrderRequest off_grid{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.25};
+  b->ProcessOrder(off_grid);
+  AddOrderRequest out_of_band{
+      .order_id = 1112, .side = Side::kBuy, .qty = 15, .price = 100.5};
+  b->ProcessOrder(out_of_band);
+
+  EXPECT_EQ(oss.str(), "");
+  EXPECT_EQ(ess.str(),
+            "Unable to process: Price is not on the tick grid: 11.25\n"
+            "Unable to process: Price is not on the tick grid: 100.5\n");
+  EXPECT_EQ(sell_order_ladder().size(), 0);
+  EXPECT_EQ(buy_order_ladder().size(), 0);
+  EXPECT_EQ(order_id_index().size(), 0);
+}
+
+TEST_F(OrderBookTest, LadderIncomingBuySweepsMultipleLevels) {
+  UseTickGrid({.tick_size = 1, .min_price = 1, .max_price = 100});
+  AddOrderRequest sell1{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.0};
+  b->ProcessOrder(sell1);
+  AddOrderRequest sell2{
+      .order_id = 1113, .side = Side::kSell, .qty = 5, .price = 10.0};
+  b->ProcessOrder(sell2);
+  AddOrderRequest sell3{
+      .order_id = 1114, .side = Side::kSell, .qty = 5, .price = 50.0};
+  b->ProcessOrder(sell3);
+
+  EXPECT_EQ(sell_order_ladder().size(), 3);
+
+  AddOrderRequest buy{
+      .order_id = 1112, .side = Side::kBuy, .qty = 25, .price = 12.0};
+  b->ProcessOrder(buy);
+
+  std::ostringstream expected;
+  TradeEvent te1{.qty = 5, .price = 10.0};
+  OrderPartiallyFilled incoming_partial{.order_id = 1112, .remaining = 20};
+  OrderFullyFilled resting_full1{.order_id = 1113};
+  expected << te1 << std::endl
+           << incoming_partial << std::endl
+           << resting_full1 << std::endl;
+  TradeEvent te2{.qty = 15, .price = 11.0};
+  OrderPartiallyFilled incoming_partial2{.order_id = 1112, .remaining = 5};
+  OrderFullyFilled resting_full2{.order_id = 1111};
+  expected << te2 << std::endl
+           << incoming_partial2 << std::endl
+           << resting_full2 << std::endl;
+
+  EXPECT_EQ(oss.str(), expected.str());
+
+  // The remainder of the buy order rests, the sell at 50 is untouched.
+  EXPECT_EQ(sell_order_ladder().size(), 1);
+  EXPECT_EQ(sell_order_ladder().begin()->first, 50.0);
+  EXPECT_EQ(buy_order_ladder().size(), 1);
+  EXPECT_EQ(buy_order_ladder().begin()->first, 12.0);
+  EXPECT_EQ(order_id_index().size(), 2);
+}
+
+TEST_F(OrderBookTest, LadderDecimalTickTradePrice) {
+  UseTickGrid({.tick_size = 0.1, .min_price = 0.1, .max_price = 10});
+  b->ProcessOrder(
+      AddOrderRequest{.order_id = 1, .side = Side::kBuy, .qty = 5, .price = 0.3});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 2, .side = Side::kSell, .qty = 3, .price = 0.3});
+  // The trade is at the price of the order, not at 0.1 + 2 * 0.1.
+  EXPECT_EQ(oss.str(), "2,3,0.3\n3,2\n4,1,2\n");
+}
+
+TEST_F(OrderBookTest, LadderIncomingSellTimePriority) {
+  UseTickGrid({.tick_size = 1, .min_price = 1, .max_price = 100});
+  AddOrderRequest buy1{
+      .order_id = 1111, .side = Side::kBuy, .qty = 15, .price = 11.0};
+  b->ProcessOrder(buy1);
+  AddOrderRequest buy2{
+      .order_id = 1113, .side = Side::kBuy, .qty = 5, .price = 11.0};
+  b->ProcessOrder(buy2);
+
+  EXPECT_EQ(buy_order_ladder().size(), 1);
+  EXPECT_EQ(buy_order_ladder().begin()->second.orders.size(), 2);
+
+  AddOrderRequest sell{
+      .order_id = 1112, .side = Side::kSell, .qty = 15, .price = 9.0};
+  b->ProcessOrder(sell);
+
+  std::ostringstream expected;
+  TradeEvent te{.qty = 15, .price = 11.0};
+  OrderFullyFilled incoming{.order_id = 1112};
+  OrderFullyFilled resting{.order_id = 1111};
+  expected << te << std::endl << incoming << std::endl << resting << std::endl;
+
+  EXPECT_EQ(oss.str(), expected.str());
+
+  EXPECT_EQ(sell_order_ladder().size(), 0);
+  EXPECT_EQ(buy_order_ladder().size(), 1);
+  EXPECT_EQ(buy_order_ladder().begin()->second.orders.front().id, 1113);
+  EXPECT_EQ(order_id_index().size(), 1);
+}
+
+TEST_F(OrderBookTest, ModifyReducesInPlace) {
+  AddOrderRequest sell1{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.0};
+  b->ProcessOrder(sell1);
+  AddOrderRequest sell2{
+      .order_id = 1113, .side = Side::kSell, .qty = 5, .price = 11.0};
+  b->ProcessOrder(sell2);
+
+  // Same price and less quantity, so the order keeps its time priority.
+  ModifyOrderRequest modify{.order_id = 1111, .qty = 10, .price = 11.0};
+  b->ProcessOrder(modify);
+  EXPECT_EQ(oss.str(), "");
+  EXPECT_EQ(sell_order_map().begin()->second.qty, 15);
+  EXPECT_EQ(sell_order_map().begin()->second.orders.front().id, 1111);
+  EXPECT_EQ(sell_order_map().begin()->second.orders.front().qty, 10);
+
+  AddOrderRequest buy{
+      .order_id = 1112, .side = Side::kBuy, .qty = 10, .price = 11.0};
+  b->ProcessOrder(buy);
+
+  std::ostringstream expected;
+  TradeEvent te{.qty = 10, .price = 11.0};
+  OrderFullyFilled incoming{.order_id = 1112};
+  OrderFullyFilled resting{.order_id = 1111};
+  expected << te << std::endl << incoming << std::endl << resting << std::endl;
+  EXPECT_EQ(oss.str(), expected.str());
+  EXPECT_EQ(ess.str(), "");
+  EXPECT_EQ(order_id_index().size(), 1);
+}
+
+TEST_F(OrderBookTest, ModifyLosesPriority) {
+  AddOrderRequest sell1{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.0};
+  b->ProcessOrder(sell1);
+  AddOrderRequest sell2{
+      .order_id = 1113, .side = Side::kSell, .qty = 5, .price = 11.0};
+  b->ProcessOrder(sell2);
+
+  // More quantity goes to the back of the queue.
+  ModifyOrderRequest modify{.order_id = 1111, .qty = 20, .price = 11.0};
+  b->ProcessOrder(modify);
+  EXPECT_EQ(oss.str(), "");
+  EXPECT_EQ(sell_order_map().begin()->second.qty, 25);
+  EXPECT_EQ(sell_order_map().begin()->second.orders.front().id, 1113);
+  EXPECT_EQ(order_id_index().size(), 2);
+
+  // So does a new price, even back to the old one.
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 1113, .qty = 5, .price = 12});
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 1113, .qty = 5, .price = 11});
+  EXPECT_EQ(sell_order_map().size(), 1);
+  EXPECT_EQ(sell_order_map().begin()->second.orders.front().id, 1111);
+  EXPECT_EQ(price_index_size(), 1);
+  EXPECT_EQ(order_id_index().size(), 2);
+  EXPECT_EQ(oss.str(), "");
+  EXPECT_EQ(ess.str(), "");
+}
+
+TEST_F(OrderBookTest, ModifyMatchesAtNewPrice) {
+  AddOrderRequest sell{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.0};
+  b->ProcessOrder(sell);
+  AddOrderRequest buy{
+      .order_id = 1112, .side = Side::kBuy, .qty = 20, .price = 10.0};
+  b->ProcessOrder(buy);
+
+  ModifyOrderRequest modify{.order_id = 1112, .qty = 20, .price = 11.0};
+  b->ProcessOrder(modify);
+
+  std::ostringstream expected;
+  TradeEvent te{.qty = 15, .price = 11.0};
+  OrderPartiallyFilled incoming{.order_id = 1112, .remaining = 5};
+  OrderFullyFilled resting{.order_id = 1111};
+  expected << te << std::endl << incoming << std::endl << resting << std::endl;
+  EXPECT_EQ(oss.str(), expected.str());
+
+  // What's left rests at the new price.
+  EXPECT_EQ(sell_order_map().size(), 0);
+  ASSERT_EQ(buy_order_map().size(), 1);
+  EXPECT_EQ(buy_order_map().begin()->first, 11.0);
+  EXPECT_EQ(buy_order_map().begin()->second.qty, 5);
+  EXPECT_EQ(price_index_size(), 1);
+  EXPECT_EQ(order_id_index().size(), 1);
+
+  // Fully filled by a modify, the order is gone.
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1113, .side = Side::kSell, .qty = 5, .price = 12.0});
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 1113, .qty = 5, .price = 11});
+  EXPECT_EQ(sell_order_map().size(), 0);
+  EXPECT_EQ(buy_order_map().size(), 0);
+  EXPECT_EQ(order_id_index().size(), 0);
+  EXPECT_EQ(ess.str(), "");
+}
+
+TEST_F(OrderBookTest, ModifyToZeroCancels) {
+  AddOrderRequest sell{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.0};
+  b->ProcessOrder(sell);
+  ModifyOrderRequest modify{.order_id = 1111, .qty = 0, .price = 11.0};
+  b->ProcessOrder(modify);
+
+  EXPECT_EQ(oss.str(), "");
+  EXPECT_EQ(ess.str(), "");
+  EXPECT_EQ(sell_order_map().size(), 0);
+  EXPECT_EQ(price_index_size(), 0);
+  EXPECT_EQ(order_id_index().size(), 0);
+}
+
+TEST_F(OrderBookTest, ModifyRejected) {
+  UseTickGrid({.tick_size = 0.5, .min_price = 1, .max_price = 100});
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 1111, .qty = 5, .price = 11});
+  AddOrderRequest sell{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.0};
+  b->ProcessOrder(sell);
+  b->ProcessOrder(
+      ModifyOrderRequest{.order_id = 1111, .qty = 5, .price = 11.25});
+
+  EXPECT_EQ(oss.str(), "");
+  EXPECT_EQ(ess.str(),
+            "No such order with id: 1111\n"
+            "Unable to process: Price is not on the tick grid: 11.25\n");
+  // The order is left as it was.
+  EXPECT_EQ(sell_order_ladder().size(), 1);
+  EXPECT_EQ(sell_order_ladder().begin()->second.qty, 15);
+  EXPECT_EQ(b->sequence(), 3);
+}
+
+TEST_F(OrderBookTest, ModifyIsCancelAndAdd) {
+  for (bool ladder : {false, true}) {
+    // A modify that isn't a reduction in place does what a cancel followed
+    // by an add does.
+    std::ostringstream replaced_oss;
+    std::unique_ptr<OrderBook> replaced;
+    if (ladder) {
+      TickGrid grid{.tick_size = 1, .min_price = 1, .max_price = 100};
+      UseTickGrid(grid);
+      replaced = std::make_unique<OrderBook>(
+          replaced_oss, ess, OrderBookOptions{.tick_grid = grid});
+    } else {
+      replaced = std::make_unique<OrderBook>(replaced_oss, ess);
+    }
+    std::mt19937_64 rng(5);
+    std::vector<AddOrderRequest> orders;
+    for (OrderId id = 1; id <= 5000; ++id) {
+      AddOrderRequest add{.order_id = id,
+                          .side = rng() % 2 == 0 ? Side::kBuy : Side::kSell,
+                          .qty = 1 + rng() % 10,
+                          .price = 40.0 + rng() % 20};
+      if (rng() % 2 == 0 || orders.empty()) {
+        b->ProcessOrder(add);
+        replaced->ProcessOrder(add);
+        orders.push_back(add);
+        continue;
+      }
+      AddOrderRequest& order = orders[rng() % orders.size()];
+      // Filled orders can't be modified.
+      if (order_id_index().find(order.order_id) == order_id_index().end()) {
+        continue;
+      }
+      order.qty = 1 + rng() % 10;
+      order.price = order.price + (rng() % 2 == 0 ? 1 : -1);
+      b->ProcessOrder(ModifyOrderRequest{
+          .order_id = order.order_id, .qty = order.qty, .price = order.price});
+      replaced->ProcessOrder(CancelOrderRequest{.order_id = order.order_id});
+      replaced->ProcessOrder(order);
+    }
+    EXPECT_EQ(oss.str(), replaced_oss.str());
+    EXPECT_EQ(ess.str(), "");
+    for (Side side : {Side::kBuy, Side::kSell}) {
+      std::vector<DepthLevel> depth = b->Depth(side, 100);
+      std::vector<DepthLevel> replaced_depth = replaced->Depth(side, 100);
+      ASSERT_EQ(depth.size(), replaced_depth.size());
+      for (size_t i = 0; i < depth.size(); ++i) {
+        EXPECT_EQ(depth[i].price, replaced_depth[i].price);
+        EXPECT_EQ(depth[i].qty, replaced_depth[i].qty);
+        EXPECT_EQ(depth[i].num_orders, replaced_depth[i].num_orders);
+      }
+    }
+    oss.str("");
+  }
+}
+
+TEST_F(OrderBookTest, ProcessBatch) {
+  for (bool ladder : {false, true}) {
+    // The same events and errors as processing the messages one at a time.
+    std::ostringstream single_oss;
+    std::ostringstream single_ess;
+    std::unique_ptr<OrderBook> single;
+    if (ladder) {
+      TickGrid grid{.tick_size = 1, .min_price = 1, .max_price = 100};
+      UseTickGrid(grid);
+      single = std::make_unique<OrderBook>(single_oss, single_ess,
+                                           OrderBookOptions{.tick_grid = grid});
+    } else {
+      single = std::make_unique<OrderBook>(single_oss, single_ess);
+    }
+    std::mt19937_64 rng(11);
+    std::vector<InputMessage> msgs;
+    for (OrderId id = 1; id <= 5000; ++id) {
+      switch (rng() % 4) {
+        case 0:
+          msgs.push_back(CancelOrderRequest{.order_id = 1 + rng() % id});
+          break;
+        case 1:
+          msgs.push_back(ModifyOrderRequest{.order_id = 1 + rng() % id,
+                                            .qty = rng() % 10,
+                                            .price = 40.0 + rng() % 20});
+          break;
+        default:
+          msgs.push_back(AddOrderRequest{
+              .order_id = rng() % 10 == 0 ? 1 : id,
+              .side = rng() % 2 == 0 ? Side::kBuy : Side::kSell,
+              .qty = 1 + rng() % 10,
+              .price = 40.0 + rng() % 20});
+      }
+    }
+    for (const InputMessage& msg : msgs) {
+      std::visit([&single](const auto& req) { single->ProcessOrder(req); },
+                 msg);
+    }
+    // In batches of growing sizes, and an empty one.
+    for (size_t i = 0, n = 1; i < msgs.size(); i += n++) {
+      b->ProcessBatch(msgs.data() + i, std::min(n, msgs.size() - i));
+    }
+    b->ProcessBatch(msgs.data(), 0);
+
+    EXPECT_NE(oss.str(), "");
+    EXPECT_NE(ess.str(), "");
+    EXPECT_EQ(oss.str(), single_oss.str());
+    EXPECT_EQ(ess.str(), single_ess.str());
+    EXPECT_EQ(b->sequence(), single->sequence());
+    oss.str("");
+    ess.str("");
+  }
+}
+
+TEST_F(OrderBookTest, CanceledOrdersAreCompacted) {
+  for (OrderId id = 0; id < 64; ++id) {
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = id, .side = Side::kSell, .qty = 10, .price = 11.0});
+  }
+  const OrderQueue& orders = sell_order_map().begin()->second.orders;
+  size_t capacity = orders.capacity();
+  // Cancels leave holes in the middle of the level, until they're compacted.
+  std::vector<OrderId> resting;
+  for (OrderId id = 0; id < 64; ++id) {
+    if (id % 4 == 0 || id == 63) {
+      resting.push_back(id);
+    } else {
+      b->ProcessOrder(CancelOrderRequest{.order_id = id});
+    }
+  }
+  std::vector<OrderId> ids;
+  for (const OrderQueue::Entry& order : orders) ids.push_back(order.id);
+  EXPECT_EQ(ids, resting);
+  EXPECT_FALSE(orders.NeedsCompaction());
+
+  // Orders moved by compaction can still be found.
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 32, .qty = 5, .price = 11});
+  b->ProcessOrder(CancelOrderRequest{.order_id = 60});
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 8, .qty = 10, .price = 12});
+  EXPECT_EQ(sell_order_map().begin()->second.qty, 10 * 14 + 5);
+
+  // Replacing orders at the back doesn't grow the level.
+  for (OrderId id = 100; id < 1000; ++id) {
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = id, .side = Side::kSell, .qty = 10, .price = 11.0});
+    b->ProcessOrder(CancelOrderRequest{.order_id = id == 100 ? 4 : id - 1});
+  }
+  EXPECT_EQ(orders.capacity(), capacity);
+
+  // They're still filled in time priority.
+  oss.str("");
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 2000, .side = Side::kBuy, .qty = 1000, .price = 12.0});
+  std::ostringstream expected;
+  Quantity remaining = 1000;
+  for (OrderId id : {0, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 63,
+                     999, 8}) {
+    Quantity qty = id == 32 ? 5 : 10;
+    remaining -= qty;
+    expected << TradeEvent{.qty = qty, .price = id == 8 ? 12.0 : 11.0}
+             << std::endl
+             << OrderPartiallyFilled{.order_id = 2000, .remaining = remaining}
+             << std::endl
+             << OrderFullyFilled{.order_id = id} << std::endl;
+  }
+  EXPECT_EQ(oss.str(), expected.str());
+  EXPECT_EQ(ess.str(), "");
+  EXPECT_EQ(order_id_index().size(), 1);
+}
+
+TEST_F(OrderBookTest, LevelQueuesAreReused) {
+  UseTickGrid({.tick_size = 1, .min_price = 1, .max_price = 100});
+  for (OrderId id = 0; id < 10; ++id) {
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = id, .side = Side::kSell, .qty = 10, .price = 11});
+  }
+  size_t capacity = sell_order_ladder().find(11)->second.orders.capacity();
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 10, .side = Side::kBuy, .qty = 100, .price = 11});
+  EXPECT_EQ(sell_order_ladder().size(), 0);
+
+  // The next level takes over the buffer of the one filled, whatever its side.
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 11, .side = Side::kBuy, .qty = 10, .price = 9});
+  const OrderQueue& orders = buy_order_ladder().find(9)->second.orders;
+  EXPECT_EQ(orders.capacity(), capacity);
+  EXPECT_EQ(orders.size(), 1);
+  EXPECT_EQ(orders.front().id, 11);
+
+  // So does the next one after a cancel.
+  b->ProcessOrder(CancelOrderRequest{.order_id = 11});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 12, .side = Side::kSell, .qty = 10, .price = 12});
+  EXPECT_EQ(sell_order_ladder().find(12)->second.orders.capacity(), capacity);
+  EXPECT_EQ(ess.str(), "");
+}
+
+TEST_F(OrderBookTest, PublishesToEventSink) {
+  std::vector<OutputEvent> events;
+  CallbackEventSink sink(
+      [&events](const OutputEvent& event) { events.push_back(event); });
+  b = std::make_unique<OrderBook>(sink, ess);
+
+  AddOrderRequest sell{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.0};
+  b->ProcessOrder(sell);
+  AddOrderRequest buy{
+      .order_id = 1112, .side = Side::kBuy, .qty = 10, .price = 12.0};
+  b->ProcessOrder(buy);
+
+  EXPECT_EQ(oss.str(), "");
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(std::get<TradeEvent>(events[0]).qty, 10);
+  EXPECT_EQ(std::get<TradeEvent>(events[0]).price, 11.0);
+  EXPECT_EQ(std::get<OrderFullyFilled>(events[1]).order_id, 1112);
+  EXPECT_EQ(std::get<OrderPartiallyFilled>(events[2]).order_id, 1111);
+  EXPECT_EQ(std::get<OrderPartiallyFilled>(events[2]).remaining, 5);
+}
+
+TEST_F(OrderBookTest, Depth) {
+  for (bool ladder : {false, true}) {
+    if (ladder) UseTickGrid({.tick_size = 1, .min_price = 1, .max_price = 100});
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = 1, .side = Side::kSell, .qty = 10, .price = 12.0});
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = 2, .side = Side::kSell, .qty = 5, .price = 12.0});
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = 3, .side = Side::kSell, .qty = 7, .price = 14.0});
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = 4, .side = Side::kSell, .qty = 1, .price = 13.0});
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = 5, .side = Side::kBuy, .qty = 3, .price = 10.0});
+
+    std::vector<DepthLevel> asks = b->Depth(Side::kSell, 2);
+    ASSERT_EQ(asks.size(), 2);
+    EXPECT_EQ(asks[0].price, 12.0);
+    EXPECT_EQ(asks[0].qty, 15);
+    EXPECT_EQ(asks[0].num_orders, 2);
+    EXPECT_EQ(asks[1].price, 13.0);
+    EXPECT_EQ(asks[1].qty, 1);
+    EXPECT_EQ(asks[1].num_orders, 1);
+    EXPECT_EQ(b->Depth(Side::kSell, 10).size(), 3);
+    EXPECT_EQ(b->Depth(Side::kSell, 0).size(), 0);
+
+    // A partial fill of the first order of the best level.
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = 6, .side = Side::kBuy, .qty = 4, .price = 12.0});
+    asks = b->Depth(Side::kSell, 1);
+    EXPECT_EQ(asks[0].qty, 11);
+    EXPECT_EQ(asks[0].num_orders, 2);
+
+    // Canceling the other one.
+    b->ProcessOrder(CancelOrderRequest{.order_id = 2});
+    asks = b->Depth(Side::kSell, 1);
+    EXPECT_EQ(asks[0].qty, 6);
+    EXPECT_EQ(asks[0].num_orders, 1);
+
+    // Sweeping through two levels, and resting the rest.
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = 7, .side = Side::kBuy, .qty = 10, .price = 13.0});
+    asks = b->Depth(Side::kSell, 10);
+    ASSERT_EQ(asks.size(), 1);
+    EXPECT_EQ(asks[0].price, 14.0);
+    EXPECT_EQ(asks[0].qty, 7);
+    std::vector<DepthLevel> bids = b->Depth(Side::kBuy, 10);
+    ASSERT_EQ(bids.size(), 2);
+    EXPECT_EQ(bids[0].price, 13.0);
+    EXPECT_EQ(bids[0].qty, 3);
+    EXPECT_EQ(bids[1].price, 10.0);
+    EXPECT_EQ(bids[1].qty, 3);
+  }
+}
+
+TEST_F(OrderBookTest, PublishesDepthUpdates) {
+  std::vector<OutputEvent> events;
+  CallbackEventSink sink(
+      [&events](const OutputEvent& event) { events.push_back(event); });
+  b = std::make_unique<OrderBook>(
+      sink, ess, OrderBookOptions{.publish_depth_updates = true});
+  auto depth_update = [&events](size_t i) {
+    return std::get<DepthUpdate>(events.at(i));
+  };
+
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1, .side = Side::kSell, .qty = 10, .price = 12.0});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 2, .side = Side::kSell, .qty = 5, .price = 12.0});
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(depth_update(1).side, Side::kSell);
+  EXPECT_EQ(depth_update(1).price, 12.0);
+  EXPECT_EQ(depth_update(1).qty, 15);
+  EXPECT_EQ(depth_update(1).num_orders, 2);
+
+  // One update per level, after its trades, then one for the order resting.
+  events.clear();
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 3, .side = Side::kBuy, .qty = 20, .price = 12.0});
+  ASSERT_EQ(events.size(), 8);
+  EXPECT_EQ(depth_update(6).side, Side::kSell);
+  EXPECT_EQ(depth_update(6).qty, 0);
+  EXPECT_EQ(depth_update(6).num_orders, 0);
+  EXPECT_EQ(depth_update(7).side, Side::kBuy);
+  EXPECT_EQ(depth_update(7).qty, 5);
+  EXPECT_EQ(depth_update(7).num_orders, 1);
+
+  events.clear();
+  b->ProcessOrder(CancelOrderRequest{.order_id = 3});
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(depth_update(0).price, 12.0);
+  EXPECT_EQ(depth_update(0).qty, 0);
+  EXPECT_EQ(depth_update(0).num_orders, 0);
+
+  // Rejected requests don't change the book.
+  events.clear();
+  b->ProcessOrder(CancelOrderRequest{.order_id = 3});
+  EXPECT_TRUE(events.empty());
+}
+
+TEST_F(OrderBookTest, LadderDecimalTickDepth) {
+  std::vector<OutputEvent> events;
+  CallbackEventSink sink(
+      [&events](const OutputEvent& event) { events.push_back(event); });
+  b = std::make_unique<OrderBook>(
+      sink, ess,
+      OrderBookOptions{
+          .tick_grid = TickGrid{.tick_size = 0.1, .min_price = 0.1,
+                                .max_price = 10},
+          .publish_depth_updates = true});
+
+  // The levels are at the prices of the orders, not at sums of ticks.
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1, .side = Side::kSell, .qty = 10, .price = 0.3});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 2, .side = Side::kSell, .qty = 5, .price = 0.7});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 3, .side = Side::kBuy, .qty = 4, .price = 0.2});
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(std::get<DepthUpdate>(events[0]).price, 0.3);
+  EXPECT_EQ(std::get<DepthUpdate>(events[1]).price, 0.7);
+  EXPECT_EQ(std::get<DepthUpdate>(events[2]).price, 0.2);
+
+  std::vector<DepthLevel> asks = b->Depth(Side::kSell, 10);
+  ASSERT_EQ(asks.size(), 2);
+  EXPECT_EQ(asks[0].price, 0.3);
+  EXPECT_EQ(asks[1].price, 0.7);
+  std::vector<DepthLevel> bids = b->Depth(Side::kBuy, 10);
+  ASSERT_EQ(bids.size(), 1);
+  EXPECT_EQ(bids[0].price, 0.2);
+  EXPECT_EQ(b->BestBidOffer().ask.price, 0.3);
+  EXPECT_EQ(b->BestBidOffer().bid.price, 0.2);
+
+  // Sweeping a level publishes its update at the same price.
+  events.clear();
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 4, .side = Side::kBuy, .qty = 10, .price = 0.3});
+  ASSERT_FALSE(events.empty());
+  EXPECT_EQ(std::get<DepthUpdate>(events.back()).price, 0.3);
+  EXPECT_EQ(std::get<DepthUpdate>(events.back()).qty, 0);
+  EXPECT_EQ(b->BestBidOffer().ask.price, 0.7);
+}
+
+TEST_F(OrderBookTest, BestBidOffer) {
+  for (bool ladder : {false, true}) {
+    if (ladder) UseTickGrid({.tick_size = 1, .min_price = 1, .max_price = 100});
+    // Orders around a moving price, and cancels, checked against the best
+    // levels of the book after every request.
+    std::mt19937_64 rng(3);
+    for (OrderId id = 1; id <= 5000; ++id) {
+      if (rng() % 3 == 0) {
+        b->ProcessOrder(CancelOrderRequest{.order_id = 1 + rng() % id});
+      } else {
+        b->ProcessOrder(
+            AddOrderRequest{.order_id = id,
+                            .side = rng() % 2 == 0 ? Side::kBuy : Side::kSell,
+                            .qty = 1 + rng() % 10,
+                            .price = 40.0 + id / 500 + rng() % 20});
+      }
+      const Bbo& bbo = b->BestBidOffer();
+      for (auto [side, best] : {std::make_pair(Side::kBuy, bbo.bid),
+                                std::make_pair(Side::kSell, bbo.ask)}) {
+        std::vector<DepthLevel> depth = b->Depth(side, 1);
+        if (depth.empty()) {
+          ASSERT_EQ(best.qty, 0) << id;
+          continue;
+        }
+        ASSERT_EQ(best.price, depth[0].price) << id;
+        ASSERT_EQ(best.qty, depth[0].qty) << id;
+        ASSERT_EQ(best.num_orders, depth[0].num_orders) << id;
+      }
+    }
+  }
+}
+
+TEST_F(OrderBookTest, PublishesBboUpdates) {
+  std::vector<OutputEvent> events;
+  CallbackEventSink sink(
+      [&events](const OutputEvent& event) { events.push_back(event); });
+  b = std::make_unique<OrderBook>(
+      sink, ess,
+      OrderBookOptions{.symbol = *Symbol::FromString("A"),
+                       .publish_bbo_updates = true});
+  auto last_bbo = [&events]() { return std::get<Bbo>(events.back()); };
+
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1, .side = Side::kSell, .qty = 10, .price = 12.0});
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(last_bbo().ask.price, 12.0);
+  EXPECT_EQ(last_bbo().ask.qty, 10);
+  EXPECT_EQ(last_bbo().bid.qty, 0);
+  EXPECT_EQ(last_bbo().symbol, *Symbol::FromString("A"));
+
+  // Behind the best offer, so nothing changes.
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 2, .side = Side::kSell, .qty = 5, .price = 13.0});
+  b->ProcessOrder(CancelOrderRequest{.order_id = 2});
+  b->ProcessOrder(CancelOrderRequest{.order_id = 2});
+  EXPECT_EQ(events.size(), 1);
+
+  // A partial fill publishes the trade events, then the BBO once.
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 3, .side = Side::kBuy, .qty = 4, .price = 12.0});
+  ASSERT_EQ(events.size(), 5);
+  EXPECT_EQ(last_bbo().ask.qty, 6);
+  EXPECT_EQ(last_bbo().bid.qty, 0);
+
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 4, .side = Side::kBuy, .qty = 4, .price = 11.0});
+  ASSERT_EQ(events.size(), 6);
+  EXPECT_EQ(last_bbo().bid.price, 11.0);
+  EXPECT_EQ(last_bbo().bid.num_orders, 1);
+
+  b->ProcessOrder(CancelOrderRequest{.order_id = 1});
+  ASSERT_EQ(events.size(), 7);
+  EXPECT_EQ(last_bbo().ask.qty, 0);
+  EXPECT_EQ(last_bbo().ask.num_orders, 0);
+  EXPECT_EQ(last_bbo().bid.qty, 4);
+}
+
+TEST_F(OrderBookTest, LadderDecimalTickBboUpdates) {
+  std::vector<OutputEvent> events;
+  CallbackEventSink sink(
+      [&events](const OutputEvent& event) { events.push_back(event); });
+  b = std::make_unique<OrderBook>(
+      sink, ess,
+      OrderBookOptions{
+          .tick_grid = TickGrid{.tick_size = 0.1, .min_price = 0.1,
+                                .max_price = 10},
+          .publish_bbo_updates = true});
+  auto last_bbo = [&events]() { return std::get<Bbo>(events.back()); };
+
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1, .side = Side::kSell, .qty = 10, .price = 0.7});
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(last_bbo().ask.price, 0.7);
+
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 2, .side = Side::kBuy, .qty = 4, .price = 0.3});
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(last_bbo().bid.price, 0.3);
+  EXPECT_EQ(last_bbo().ask.price, 0.7);
+
+  // A better bid, then a trade at the best offer.
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 3, .side = Side::kBuy, .qty = 1, .price = 0.6});
+  EXPECT_EQ(last_bbo().bid.price, 0.6);
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 4, .side = Side::kSell, .qty = 1, .price = 0.6});
+  EXPECT_EQ(last_bbo().bid.price, 0.3);
+  EXPECT_EQ(last_bbo().ask.price, 0.7);
+}
+
+TEST_F(OrderBookTest, LatencyStats) {
+  LatencyStats stats;
+  auto count = [&stats](LatencyStage stage, MessageType type,
+                        Outcome outcome) {
+    return stats.histogram(stage, type, outcome).count();
+  };
+  b->set_latency_stats(&stats);
+
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1, .side = Side::kSell, .qty = 10, .price = 12.0});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 2, .side = Side::kBuy, .qty = 4, .price = 12.0});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 3, .side = Side::kBuy, .qty = 10, .price = 12.0});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 3, .side = Side::kBuy, .qty = 10, .price = 12.0});
+  b->ProcessOrder(CancelOrderRequest{.order_id = 3});
+  b->ProcessOrder(CancelOrderRequest{.order_id = 3});
+  // Not recorded while muted.
+  b->set_muted(true);
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 4, .side = Side::kBuy, .qty = 1, .price = 1.0});
+  b->set_muted(false);
+  b->set_latency_stats(nullptr);
+  b->ProcessOrder(CancelOrderRequest{.order_id = 4});
+
+  for (auto [type, outcome] : {std::make_pair(MessageType::kAddOrderRequest,
+                                              Outcome::kRested),
+                               std::make_pair(MessageType::kAddOrderRequest,
+                                              Outcome::kFullyFilled),
+                               std::make_pair(MessageType::kAddOrderRequest,
+                                              Outcome::kPartiallyFilled),
+                               std::make_pair(MessageType::kAddOrderRequest,
+                                              Outcome::kRejected),
+                               std::make_pair(MessageType::kCancelOrderRequest,
+                                              Outcome::kCanceled),
+                               std::make_pair(MessageType::kCancelOrderRequest,
+                                              Outcome::kRejected)}) {
+    EXPECT_EQ(count(LatencyStage::kTotal, type, outcome), 1);
+    EXPECT_EQ(count(LatencyStage::kMatch, type, outcome), 1);
+    // Only the requests that published events, and changed the book.
+    bool published = outcome != Outcome::kRested &&
+                     outcome != Outcome::kCanceled &&
+                     outcome != Outcome::kRejected;
+    EXPECT_EQ(count(LatencyStage::kPublish, type, outcome), published);
+    bool updated = outcome != Outcome::kFullyFilled &&
+                   outcome != Outcome::kRejected;
+    EXPECT_EQ(count(LatencyStage::kBookUpdate, type, outcome), updated);
+  }
+  EXPECT_EQ(oss.str(), "2,4,12\n3,2\n4,1,6\n2,6,12\n4,3,4\n3,1\n");
+  EXPECT_EQ(ess.str(),
+            "Unable to process: Order id is being repeated: 3\n"
+            "No such order with id: 3\n");
+}
+
+TEST_F(OrderBookTest, LatencyStatsOfModifies) {
+  LatencyStats stats;
+  auto count = [&stats](LatencyStage stage, Outcome outcome) {
+    return stats.histogram(stage, MessageType::kModifyOrderRequest, outcome)
+        .count();
+  };
+  b->set_latency_stats(&stats);
+
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1, .side = Side::kSell, .qty = 10, .price = 12.0});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 2, .side = Side::kBuy, .qty = 10, .price = 11.0});
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 1, .qty = 8, .price = 12});
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 2, .qty = 10, .price = 12});
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 1, .qty = 5, .price = 12});
+  b->ProcessOrder(ModifyOrderRequest{.order_id = 2, .qty = 0, .price = 12});
+
+  EXPECT_EQ(count(LatencyStage::kTotal, Outcome::kRested), 1);
+  EXPECT_EQ(count(LatencyStage::kBookUpdate, Outcome::kRested), 1);
+  EXPECT_EQ(count(LatencyStage::kTotal, Outcome::kPartiallyFilled), 1);
+  EXPECT_EQ(count(LatencyStage::kMatch, Outcome::kPartiallyFilled), 1);
+  EXPECT_EQ(count(LatencyStage::kPublish, Outcome::kPartiallyFilled), 1);
+  // Taken out of the book, and put back at the new price.
+  EXPECT_EQ(count(LatencyStage::kBookUpdate, Outcome::kPartiallyFilled), 1);
+  EXPECT_EQ(count(LatencyStage::kTotal, Outcome::kRejected), 1);
+  EXPECT_EQ(count(LatencyStage::kTotal, Outcome::kCanceled), 1);
+  EXPECT_EQ(ess.str(), "No such order with id: 1\n");
+}
+
+TEST_F(OrderBookTest, LatencyStatsSampled) {
+  LatencyStats stats(/*sample_interval=*/3);
+  b->set_latency_stats(&stats);
+  for (OrderId id = 1; id <= 10; ++id) {
+    b->ProcessOrder(AddOrderRequest{
+        .order_id = id, .side = Side::kSell, .qty = 1, .price = 12.0});
+  }
+  // The 1st, 4th, 7th and 10th.
+  EXPECT_EQ(stats
+                .histogram(LatencyStage::kTotal, MessageType::kAddOrderRequest,
+                           Outcome::kRested)
+                .count(),
+            4);
+}
+
+TEST_F(OrderBookTest, Muted) {
+  b->set_muted(true);
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1111, .side = Side::kSell, .qty = 15, .price = 11.0});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1112, .side = Side::kBuy, .qty = 10, .price = 12.0});
+  b->ProcessOrder(CancelOrderRequest{.order_id = 1});
+  EXPECT_EQ(oss.str(), "");
+  EXPECT_EQ(ess.str(), "");
+  // The book is updated all the same.
+  EXPECT_EQ(b->sequence(), 3);
   EXPECT_EQ(order_id_index().size(), 1);
+
+  b->set_muted(false);
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1113, .side = Side::kBuy, .qty = 5, .price = 12.0});
+  EXPECT_EQ(oss.str(), "2,5,11\n3,1113\n3,1111\n");
+  b->ProcessOrder(CancelOrderRequest{.order_id = 1});
+  EXPECT_EQ(ess.str(), "No such order with id: 1\n");
+}
+
+// Rests orders on a few levels on both sides of `book`.
+void AddRestingOrders(OrderBook& book) {
+  for (OrderId id = 1; id <= 12; ++id) {
+    AddOrderRequest req{.order_id = id,
+                        .side = id % 2 == 0 ? Side::kBuy : Side::kSell,
+                        .qty = id * 10,
+                        .price = id % 2 == 0 ? 10.0 - id % 3 : 12.0 + id % 3};
+    book.ProcessOrder(req);
+  }
+  book.ProcessOrder(CancelOrderRequest{.order_id = 5});
+}
+
+std::string SaveSnapshot(const OrderBook& book) {
+  std::ostringstream os;
+  EXPECT_TRUE(book.SaveSnapshot(os));
+  return os.str();
+}
+
+TEST_F(OrderBookTest, SnapshotRoundTrip) {
+  for (bool ladder : {false, true}) {
+    if (ladder) UseTickGrid({.tick_size = 1, .min_price = 1, .max_price = 100});
+    AddRestingOrders(*b);
+    std::string snapshot = SaveSnapshot(*b);
+
+    std::ostringstream os;
+    std::ostringstream es;
+    OrderBookOptions options;
+    if (ladder) options.tick_grid = {1, 1, 100};
+    OrderBook restored(os, es, options);
+    ASSERT_TRUE(restored.LoadSnapshot(snapshot)) << es.str();
+    EXPECT_EQ(restored.sequence(), 13);
+    EXPECT_EQ(SaveSnapshot(restored), snapshot);
+    for (Side side : {Side::kSell, Side::kBuy}) {
+      std::vector<DepthLevel> depth = b->Depth(side, 10);
+      std::vector<DepthLevel> restored_depth = restored.Depth(side, 10);
+      ASSERT_EQ(restored_depth.size(), depth.size());
+      for (size_t i = 0; i < depth.size(); ++i) {
+        EXPECT_EQ(restored_depth[i].price, depth[i].price);
+        EXPECT_EQ(restored_depth[i].qty, depth[i].qty);
+        EXPECT_EQ(restored_depth[i].num_orders, depth[i].num_orders);
+      }
+    }
+
+    // Both books match the same way, in price then time priority.
+    for (auto* book : {b.get(), &restored}) {
+      book->ProcessOrder(AddOrderRequest{
+          .order_id = 20, .side = Side::kBuy, .qty = 100, .price = 14.0});
+      book->ProcessOrder(AddOrderRequest{
+          .order_id = 21, .side = Side::kSell, .qty = 70, .price = 8.0});
+      book->ProcessOrder(CancelOrderRequest{.order_id = 8});
+    }
+    EXPECT_EQ(os.str(), oss.str());
+    EXPECT_EQ(es.str(), ess.str());
+    EXPECT_NE(os.str(), "");
+    EXPECT_EQ(restored.sequence(), b->sequence());
+    oss.str("");
+    ess.str("");
+  }
+}
+
+TEST_F(OrderBookTest, SnapshotOfEmptyBook) {
+  std::string snapshot = SaveSnapshot(*b);
+  EXPECT_EQ(snapshot.size(), 64);
+
+  OrderBook restored(oss, ess);
+  EXPECT_TRUE(restored.LoadSnapshot(snapshot));
+  EXPECT_EQ(restored.sequence(), 0);
+  EXPECT_EQ(ess.str(), "");
+}
+
+TEST_F(OrderBookTest, SnapshotIntoNonEmptyBook) {
+  AddRestingOrders(*b);
+  std::string snapshot = SaveSnapshot(*b);
+
+  EXPECT_FALSE(b->LoadSnapshot(snapshot));
+  EXPECT_EQ(ess.str(), "Unable to load snapshot: the order book isn't empty\n");
+  // The book is left as it was.
+  EXPECT_EQ(SaveSnapshot(*b), snapshot);
+}
+
+TEST_F(OrderBookTest, CorruptSnapshot) {
+  AddRestingOrders(*b);
+  std::string snapshot = SaveSnapshot(*b);
+  b = std::make_unique<OrderBook>(oss, ess);
+
+  std::string corrupt = snapshot;
+  corrupt[60] ^= 1;
+  EXPECT_FALSE(b->LoadSnapshot(corrupt));
+  EXPECT_FALSE(b->LoadSnapshot(snapshot.substr(0, snapshot.size() - 8)));
+  EXPECT_FALSE(b->LoadSnapshot(""));
+  EXPECT_EQ(ess.str(),
+            "Unable to load snapshot: checksum mismatch\n"
+            "Unable to load snapshot: checksum mismatch\n"
+            "Unable to load snapshot: truncated\n");
+  EXPECT_EQ(order_id_index().size(), 0);
+
+  EXPECT_TRUE(b->LoadSnapshot(snapshot));
+}
+
+TEST_F(OrderBookTest, SnapshotOfAnotherSymbol) {
+  std::string snapshot = SaveSnapshot(*b);
+  b = std::make_unique<OrderBook>(
+      oss, ess, OrderBookOptions{.symbol = *Symbol::FromString("ABC")});
+
+  EXPECT_FALSE(b->LoadSnapshot(snapshot));
+  EXPECT_EQ(ess.str(), "Unable to load snapshot: snapshot of another symbol\n");
+}
+
+TEST_F(OrderBookTest, SnapshotOffTickGrid) {
+  AddRestingOrders(*b);
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 20, .side = Side::kBuy, .qty = 1, .price = 7.5});
+  std::string snapshot = SaveSnapshot(*b);
+  UseTickGrid({.tick_size = 1, .min_price = 1, .max_price = 100});
+
+  EXPECT_FALSE(b->LoadSnapshot(snapshot));
+  EXPECT_EQ(ess.str(),
+            "Unable to load snapshot: price is not on the tick grid\n");
+  // Whatever was loaded before the bad price is dropped.
+  EXPECT_EQ(sell_order_ladder().size(), 0);
+  EXPECT_EQ(buy_order_ladder().size(), 0);
+  EXPECT_EQ(order_id_index().size(), 0);
+}
+
+TEST_F(OrderBookTest, SnapshotDecimalTickGrid) {
+  UseTickGrid({.tick_size = 0.1, .min_price = 0.1, .max_price = 10});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 1, .side = Side::kSell, .qty = 10, .price = 0.7});
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 2, .side = Side::kBuy, .qty = 5, .price = 0.3});
+  std::string snapshot = SaveSnapshot(*b);
+
+  // The saved prices are those of the orders, so they load into a book
+  // without a tick grid at the same levels.
+  b = std::make_unique<OrderBook>(oss, ess);
+  ASSERT_TRUE(b->LoadSnapshot(snapshot));
+  EXPECT_EQ(b->Depth(Side::kSell, 1).at(0).price, 0.7);
+  EXPECT_EQ(b->Depth(Side::kBuy, 1).at(0).price, 0.3);
+
+  UseTickGrid({.tick_size = 0.1, .min_price = 0.1, .max_price = 10});
+  ASSERT_TRUE(b->LoadSnapshot(snapshot));
+  b->ProcessOrder(AddOrderRequest{
+      .order_id = 3, .side = Side::kSell, .qty = 2, .price = 0.3});
+  EXPECT_EQ(oss.str(), "2,2,0.3\n3,3\n4,2,3\n");
+  EXPECT_EQ(ess.str(), "");
 }
 
-}  // namespace mukhi::matching_engine
\ No newline at end of file
+}  // namespace mukhi::matching_engine
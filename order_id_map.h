@@ -0,0 +1,166 @@
+#ifndef MATCHING_ENGINE_ORDER_ID_MAP_H
+#define MATCHING_ENGINE_ORDER_ID_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "messages.h"
+
+namespace mukhi::matching_engine {
+
+/*
+Hash map from `OrderId` to `T` backed by a single flat array of slots, to be
+used instead of `std::unordered_map<OrderId, T>` by the order book.
+
+Collisions are resolved with linear probing, so a lookup usually touches a
+single cache line and never chases pointers. Erasing shifts the following
+entries of the probe sequence back into the freed slot instead of leaving a
+tombstone behind, which keeps probe sequences as short as if the erased entry
+was never inserted.
+
+The table doubles in size when it gets more than half full. Inserting is
+amortized O(1), and doesn't allocate unless the table grows. Lookups and
+erasures are O(1) on average.
+
+Iterators are plain pointers to the entries. Inserting invalidates all
+iterators, erasing invalidates the iterators to the erased entry and to the
+entries that come after it in the array.
+
+This class is not thread-safe.
+*/
+template <typename T>
+class OrderIdMap {
+ public:
+  using key_type = OrderId;
+  using mapped_type = T;
+  using value_type = std::pair<OrderId, T>;
+  using iterator = value_type*;
+
+  // Sizes the table to hold `capacity` entries without growing.
+  explicit OrderIdMap(size_t capacity = 0) { Rehash(SlotsFor(capacity)); }
+
+  OrderIdMap(const OrderIdMap&) = delete;
+  OrderIdMap& operator=(const OrderIdMap&) = delete;
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // Number of entries the table can hold without growing.
+  size_t capacity() const { return (mask_ + 1) / 2; }
+
+  iterator end() const { return nullptr; }
+
+  // Grows the table, if needed, to hold `capacity` entries without growing
+  // again.
+  void reserve(size_t capacity) {
+    if (SlotsFor(capacity) > mask_ + 1) Rehash(SlotsFor(capacity));
+  }
+
+  // Erases all entries, keeping the capacity.
+  void clear() {
+    for (size_t i = 0; i <= mask_; ++i) slots_[i].first = kEmpty;
+    max_id_entry_.reset();
+    size_ = 0;
+  }
+
+  iterator find(OrderId id) const {
+    if (id == kEmpty) return max_id_entry_ ? max_id_entry_.get() : end();
+    for (size_t i = Home(id);; i = (i + 1) & mask_) {
+      if (slots_[i].first == id) return &slots_[i];
+      if (slots_[i].first == kEmpty) return end();
+    }
+  }
+
+  // Mirrors `std::unordered_map::emplace`, doesn't overwrite existing entries.
+  std::pair<iterator, bool> emplace(value_type kv) {
+    if (kv.first == kEmpty) {
+      if (max_id_entry_) return {max_id_entry_.get(), false};
+      max_id_entry_ = std::make_unique<value_type>(std::move(kv));
+      ++size_;
+      return {max_id_entry_.get(), true};
+    }
+    if (2 * (size_ + 1) > mask_ + 1) Rehash(2 * (mask_ + 1));
+    size_t i = Home(kv.first);
+    for (; slots_[i].first != kEmpty; i = (i + 1) & mask_) {
+      if (slots_[i].first == kv.first) return {&slots_[i], false};
+    }
+    slots_[i] = std::move(kv);
+    ++size_;
+    return {&slots_[i], true};
+  }
+
+  size_t erase(OrderId id) {
+    iterator itr = find(id);
+    if (itr == end()) return 0;
+    erase(itr);
+    return 1;
+  }
+
+  void erase(iterator itr) {
+    --size_;
+    if (itr == max_id_entry_.get()) {
+      max_id_entry_.reset();
+      return;
+    }
+    // Backward shift: move up every following entry whose home slot isn't
+    // between the hole and the entry itself (cyclically).
+    size_t hole = static_cast<size_t>(itr - slots_.get());
+    for (size_t i = (hole + 1) & mask_; slots_[i].first != kEmpty;
+         i = (i + 1) & mask_) {
+      size_t home = Home(slots_[i].first);
+      bool stays = hole <= i ? (hole < home && home <= i)
+                             : (hole < home || home <= i);
+      if (!stays) {
+        slots_[hole] = std::move(slots_[i]);
+        hole = i;
+      }
+    }
+    slots_[hole].first = kEmpty;
+  }
+
+  // Hints the CPU to start loading the home slot of `id`.
+  void Prefetch(OrderId id) const { __builtin_prefetch(&slots_[Home(id)]); }
+
+ private:
+  // Marks an empty slot. An entry with this id is kept out of the table.
+  static constexpr OrderId kEmpty = std::numeric_limits<OrderId>::max();
+  static constexpr size_t kMinSlots = 16;
+
+  static size_t SlotsFor(size_t capacity) {
+    size_t slots = kMinSlots;
+    while (slots < 2 * capacity) slots *= 2;
+    return slots;
+  }
+
+  size_t Home(OrderId id) const {
+    // Fibonacci hashing spreads sequential ids, the common case, evenly.
+    return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> shift_);
+  }
+
+  void Rehash(size_t num_slots) {
+    std::unique_ptr<value_type[]> old = std::move(slots_);
+    size_t old_num_slots = old ? mask_ + 1 : 0;
+    slots_ = std::make_unique<value_type[]>(num_slots);
+    for (size_t i = 0; i < num_slots; ++i) slots_[i].first = kEmpty;
+    mask_ = num_slots - 1;
+    shift_ = 64 - __builtin_ctzll(num_slots);
+    for (size_t i = 0; i < old_num_slots; ++i) {
+      if (old[i].first == kEmpty) continue;
+      size_t j = Home(old[i].first);
+      while (slots_[j].first != kEmpty) j = (j + 1) & mask_;
+      slots_[j] = std::move(old[i]);
+    }
+  }
+
+  std::unique_ptr<value_type[]> slots_;
+  size_t mask_ = 0;
+  int shift_ = 64;
+  size_t size_ = 0;
+  std::unique_ptr<value_type> max_id_entry_;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_ORDER_ID_MAP_H
@@ -0,0 +1,118 @@
+#include "order_id_map.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+namespace mukhi::matching_engine {
+
+TEST(OrderIdMap, EmplaceFindErase) {
+  OrderIdMap<int> m;
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.find(7), m.end());
+
+  auto [itr, inserted] = m.emplace({7, 70});
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(itr->first, 7);
+  EXPECT_EQ(itr->second, 70);
+  EXPECT_EQ(m.size(), 1);
+  EXPECT_EQ(m.find(7), itr);
+
+  EXPECT_EQ(m.erase(7), 1);
+  EXPECT_EQ(m.find(7), m.end());
+  EXPECT_EQ(m.erase(7), 0);
+  EXPECT_TRUE(m.empty());
+}
+
+TEST(OrderIdMap, EmplaceDoesNotOverwrite) {
+  OrderIdMap<int> m;
+  m.emplace({7, 70});
+  auto [itr, inserted] = m.emplace({7, 71});
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(itr->second, 70);
+  EXPECT_EQ(m.size(), 1);
+}
+
+TEST(OrderIdMap, MaxOrderId) {
+  constexpr OrderId kMax = std::numeric_limits<OrderId>::max();
+  OrderIdMap<int> m;
+  EXPECT_EQ(m.find(kMax), m.end());
+  EXPECT_TRUE(m.emplace({kMax, 1}).second);
+  EXPECT_FALSE(m.emplace({kMax, 2}).second);
+  EXPECT_EQ(m.find(kMax)->second, 1);
+  EXPECT_EQ(m.size(), 1);
+  m.erase(m.find(kMax));
+  EXPECT_EQ(m.find(kMax), m.end());
+  EXPECT_TRUE(m.empty());
+}
+
+TEST(OrderIdMap, InitialCapacity) {
+  OrderIdMap<int> m(1000);
+  EXPECT_GE(m.capacity(), 1000);
+  size_t capacity = m.capacity();
+  for (OrderId id = 0; id < capacity; ++id) m.emplace({id, 0});
+  // Filling up to the capacity doesn't grow the table.
+  EXPECT_EQ(m.capacity(), capacity);
+  m.emplace({capacity, 0});
+  EXPECT_GT(m.capacity(), capacity);
+}
+
+TEST(OrderIdMap, ReserveAndClear) {
+  OrderIdMap<int> m;
+  m.emplace({1, 10});
+  m.emplace({std::numeric_limits<OrderId>::max(), 20});
+  m.reserve(1000);
+  EXPECT_GE(m.capacity(), 1000);
+  EXPECT_EQ(m.find(1)->second, 10);
+
+  size_t capacity = m.capacity();
+  m.clear();
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.find(1), m.end());
+  EXPECT_EQ(m.find(std::numeric_limits<OrderId>::max()), m.end());
+  EXPECT_EQ(m.capacity(), capacity);
+  EXPECT_TRUE(m.emplace({1, 11}).second);
+}
+
+TEST(OrderIdMap, GrowsAndKeepsEntries) {
+  OrderIdMap<OrderId> m;
+  for (OrderId id = 0; id < 10000; ++id) m.emplace({id * 3, id});
+  EXPECT_EQ(m.size(), 10000);
+  for (OrderId id = 0; id < 10000; ++id) {
+    ASSERT_NE(m.find(id * 3), m.end());
+    EXPECT_EQ(m.find(id * 3)->second, id);
+    EXPECT_EQ(m.find(id * 3 + 1), m.end());
+  }
+}
+
+// Compares against `std::unordered_map` under a random mix of operations on a
+// small key space, so that probe sequences collide and wrap around a lot.
+TEST(OrderIdMap, RandomOperationsMatchUnorderedMap) {
+  std::mt19937_64 rng(42);
+  OrderIdMap<uint64_t> m;
+  std::unordered_map<OrderId, uint64_t> expected;
+  for (int i = 0; i < 200000; ++i) {
+    OrderId id = rng() % 512;
+    if (rng() % 2 == 0) {
+      uint64_t value = rng();
+      bool inserted = m.emplace({id, value}).second;
+      EXPECT_EQ(inserted, expected.emplace(id, value).second);
+    } else {
+      EXPECT_EQ(m.erase(id), expected.erase(id));
+    }
+    ASSERT_EQ(m.size(), expected.size());
+  }
+  for (OrderId id = 0; id < 512; ++id) {
+    auto itr = expected.find(id);
+    if (itr == expected.end()) {
+      EXPECT_EQ(m.find(id), m.end());
+    } else {
+      ASSERT_NE(m.find(id), m.end());
+      EXPECT_EQ(m.find(id)->second, itr->second);
+    }
+  }
+}
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,18 @@
+#include "order_queue.h"
+
+#include <algorithm>
+
+namespace mukhi::matching_engine {
+
+void OrderQueue::Grow() {
+  size_t capacity = std::max(kInitialCapacity, 2 * capacity_);
+  // Left uninitialized, entries are only read once written.
+  std::unique_ptr<Entry[]> buf(new Entry[capacity]);
+  for (Ticket ticket = head_; ticket != tail_; ++ticket) {
+    buf[ticket & (capacity - 1)] = at(ticket);
+  }
+  buf_ = std::move(buf);
+  capacity_ = capacity;
+}
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,198 @@
+#ifndef MATCHING_ENGINE_ORDER_QUEUE_H
+#define MATCHING_ENGINE_ORDER_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "messages.h"
+
+namespace mukhi::matching_engine {
+
+struct Order {
+  OrderId id;
+  Side side;
+  Quantity qty;
+  Price price;
+};
+
+/*
+The resting orders of a price level, in time priority, kept in a circular
+buffer.
+
+Orders are stored inline as their id and quantity, their side and price being
+those of the level, four to a cache line. So walking a level while matching is
+a sequential scan of memory rather than a pointer chase per order, and filling
+the front order pops it in O(1).
+
+An order is identified by its ticket, the position it was pushed at, which
+stays valid while the buffer grows and orders ahead of it are popped.
+Canceling an order leaves a tombstone behind, which iterating skips over, in
+O(1). Tombstones are dropped once they reach either end of the queue, and
+those in the middle are dropped by `Compact`, which moves orders back over them
+to new tickets. Compacting once tombstones outnumber orders (see
+`NeedsCompaction`) keeps the cost of both the tombstones and the moves
+amortized O(1) per cancel.
+
+The buffer doubles in size when it's full, and never shrinks.
+
+This class is not thread-safe.
+*/
+class OrderQueue {
+ public:
+  struct Entry {
+    OrderId id;
+    // 0 for a tombstone, resting orders always have a quantity.
+    Quantity qty;
+  };
+  using Ticket = uint64_t;
+
+  // Iterates over the orders, in time priority, skipping tombstones.
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Entry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Entry*;
+    using reference = const Entry&;
+
+    iterator() = default;
+
+    reference operator*() const { return queue_->at(ticket_); }
+    pointer operator->() const { return &queue_->at(ticket_); }
+    iterator& operator++() {
+      do {
+        ++ticket_;
+      } while (ticket_ != queue_->tail_ && queue_->at(ticket_).qty == 0);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    bool operator==(const iterator& other) const {
+      return ticket_ == other.ticket_;
+    }
+    bool operator!=(const iterator& other) const {
+      return ticket_ != other.ticket_;
+    }
+
+    Ticket ticket() const { return ticket_; }
+
+   private:
+    friend class OrderQueue;
+    iterator(const OrderQueue* queue, Ticket ticket)
+        : queue_(queue), ticket_(ticket) {}
+
+    const OrderQueue* queue_ = nullptr;
+    Ticket ticket_ = 0;
+  };
+
+  OrderQueue() = default;
+  OrderQueue(OrderQueue&& other) noexcept { *this = std::move(other); }
+  OrderQueue& operator=(OrderQueue&& other) noexcept {
+    buf_ = std::move(other.buf_);
+    capacity_ = std::exchange(other.capacity_, 0);
+    head_ = std::exchange(other.head_, 0);
+    tail_ = std::exchange(other.tail_, 0);
+    size_ = std::exchange(other.size_, 0);
+    return *this;
+  }
+
+  // The front is never a tombstone.
+  iterator begin() const { return iterator(this, head_); }
+  iterator end() const { return iterator(this, tail_); }
+
+  bool empty() const { return size_ == 0; }
+  // Number of orders, tombstones excluded.
+  size_t size() const { return size_; }
+  // Number of orders and tombstones the buffer holds without growing.
+  size_t capacity() const { return capacity_; }
+
+  Entry& front() { return at(head_); }
+  const Entry& front() const { return at(head_); }
+
+  // The order of `ticket`, which must be in the queue.
+  Entry& at(Ticket ticket) { return buf_[ticket & (capacity_ - 1)]; }
+  const Entry& at(Ticket ticket) const {
+    return buf_[ticket & (capacity_ - 1)];
+  }
+
+  // Adds an order at the back of the queue and returns its ticket.
+  Ticket push_back(OrderId id, Quantity qty) {
+    if (tail_ - head_ == capacity_) Grow();
+    at(tail_) = Entry{.id = id, .qty = qty};
+    ++size_;
+    return tail_++;
+  }
+
+  // Removes the front order.
+  void pop_front() {
+    ++head_;
+    --size_;
+    DropTombstones();
+  }
+
+  // Removes the order of `ticket`, leaving a tombstone behind unless it's at
+  // either end.
+  void erase(Ticket ticket) {
+    at(ticket).qty = 0;
+    --size_;
+    DropTombstones();
+  }
+
+  // Whether compacting would drop more tombstones than it moves orders.
+  bool NeedsCompaction() const {
+    size_t tombstones = tail_ - head_ - size_;
+    return tombstones >= kMinTombstonesToCompact && tombstones > size_;
+  }
+
+  /**
+  Drops the tombstones in the middle of the queue, moving the orders behind
+  them forward. Calls `moved(id, ticket)` with the new ticket of every order
+  moved, and leaves the others where they are.
+  */
+  template <typename Moved>
+  void Compact(Moved moved) {
+    Ticket to = head_;
+    for (Ticket from = head_; from != tail_; ++from) {
+      Entry entry = at(from);
+      if (entry.qty == 0) continue;
+      if (from != to) {
+        at(to) = entry;
+        moved(entry.id, to);
+      }
+      ++to;
+    }
+    tail_ = to;
+  }
+
+ private:
+  static constexpr size_t kInitialCapacity = 4;
+  // Below this, tombstones cost less to skip than compacting does.
+  static constexpr size_t kMinTombstonesToCompact = 8;
+
+  // Doubles the buffer, keeping every order at its ticket.
+  void Grow();
+
+  // Keeps both ends of the queue off tombstones.
+  void DropTombstones() {
+    while (head_ != tail_ && at(head_).qty == 0) ++head_;
+    while (tail_ != head_ && at(tail_ - 1).qty == 0) --tail_;
+  }
+
+  std::unique_ptr<Entry[]> buf_;
+  // A power of two, or 0 until the first order is pushed.
+  size_t capacity_ = 0;
+  // Tickets of the front order and one past the back one.
+  Ticket head_ = 0;
+  Ticket tail_ = 0;
+  size_t size_ = 0;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_ORDER_QUEUE_H
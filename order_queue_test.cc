@@ -0,0 +1,145 @@
+#include "order_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+namespace mukhi::matching_engine {
+
+std::vector<OrderId> Ids(const OrderQueue& q) {
+  std::vector<OrderId> ids;
+  for (const OrderQueue::Entry& e : q) ids.push_back(e.id);
+  return ids;
+}
+
+TEST(OrderQueue, PushAndPop) {
+  OrderQueue q;
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(q.begin(), q.end());
+
+  OrderQueue::Ticket t1 = q.push_back(1, 10);
+  OrderQueue::Ticket t2 = q.push_back(2, 20);
+  EXPECT_EQ(q.size(), 2);
+  EXPECT_EQ(q.front().id, 1);
+  EXPECT_EQ(q.at(t2).qty, 20);
+  EXPECT_EQ(Ids(q), (std::vector<OrderId>{1, 2}));
+
+  q.pop_front();
+  EXPECT_EQ(q.size(), 1);
+  EXPECT_EQ(q.front().id, 2);
+  EXPECT_EQ(q.begin().ticket(), t2);
+  EXPECT_NE(t1, t2);
+
+  q.pop_front();
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(q.begin(), q.end());
+}
+
+TEST(OrderQueue, TicketsSurviveWraparoundAndGrowth) {
+  OrderQueue q;
+  std::map<OrderId, OrderQueue::Ticket> tickets;
+  // Pops and pushes move the orders around the buffer before it grows.
+  for (OrderId id = 0; id < 3; ++id) tickets[id] = q.push_back(id, id + 1);
+  q.pop_front();
+  tickets.erase(0);
+  size_t capacity = q.capacity();
+  for (OrderId id = 3; id < 5; ++id) tickets[id] = q.push_back(id, id + 1);
+  EXPECT_EQ(q.capacity(), capacity);
+  for (OrderId id = 5; id < 40; ++id) tickets[id] = q.push_back(id, id + 1);
+  EXPECT_GT(q.capacity(), capacity);
+
+  EXPECT_EQ(q.size(), tickets.size());
+  for (const auto& [id, ticket] : tickets) {
+    EXPECT_EQ(q.at(ticket).id, id);
+    EXPECT_EQ(q.at(ticket).qty, id + 1);
+  }
+}
+
+TEST(OrderQueue, EraseInTheMiddleLeavesTombstone) {
+  OrderQueue q;
+  q.push_back(1, 10);
+  OrderQueue::Ticket t2 = q.push_back(2, 20);
+  OrderQueue::Ticket t3 = q.push_back(3, 30);
+
+  q.erase(t2);
+  EXPECT_EQ(q.size(), 2);
+  EXPECT_EQ(Ids(q), (std::vector<OrderId>{1, 3}));
+  EXPECT_EQ(q.at(t3).id, 3);
+
+  // Once at the front, the tombstone is dropped along with the order ahead.
+  q.pop_front();
+  EXPECT_EQ(q.front().id, 3);
+  EXPECT_EQ(q.begin().ticket(), t3);
+}
+
+TEST(OrderQueue, EraseAtTheEnds) {
+  OrderQueue q;
+  OrderQueue::Ticket t1 = q.push_back(1, 10);
+  OrderQueue::Ticket t2 = q.push_back(2, 20);
+  OrderQueue::Ticket t3 = q.push_back(3, 30);
+  OrderQueue::Ticket t4 = q.push_back(4, 40);
+
+  q.erase(t3);
+  // The tombstone of 3 goes with 4, and that of 1 with itself.
+  q.erase(t4);
+  q.erase(t1);
+  EXPECT_EQ(q.size(), 1);
+  EXPECT_EQ(q.begin().ticket(), t2);
+  EXPECT_EQ(++q.begin(), q.end());
+  EXPECT_FALSE(q.NeedsCompaction());
+
+  q.erase(t2);
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(q.begin(), q.end());
+}
+
+TEST(OrderQueue, CompactMovesOrdersOverTombstones) {
+  OrderQueue q;
+  std::map<OrderId, OrderQueue::Ticket> tickets;
+  for (OrderId id = 0; id < 32; ++id) tickets[id] = q.push_back(id, 1);
+  // Keeps 0, 10, 20, 30 and 31.
+  for (OrderId id = 1; id < 30; ++id) {
+    if (id % 10 == 0) continue;
+    q.erase(tickets[id]);
+    tickets.erase(id);
+  }
+  EXPECT_TRUE(q.NeedsCompaction());
+
+  std::vector<OrderId> moved;
+  q.Compact([&](OrderId id, OrderQueue::Ticket ticket) {
+    moved.push_back(id);
+    tickets[id] = ticket;
+  });
+  EXPECT_EQ(moved, (std::vector<OrderId>{10, 20, 30, 31}));
+  EXPECT_FALSE(q.NeedsCompaction());
+  EXPECT_EQ(Ids(q), (std::vector<OrderId>{0, 10, 20, 30, 31}));
+  for (const auto& [id, ticket] : tickets) EXPECT_EQ(q.at(ticket).id, id);
+  // Tickets are contiguous again.
+  EXPECT_EQ(tickets[31], tickets[0] + 4);
+}
+
+TEST(OrderQueue, FewTombstonesDontNeedCompaction) {
+  OrderQueue q;
+  std::vector<OrderQueue::Ticket> tickets;
+  for (OrderId id = 0; id < 8; ++id) tickets.push_back(q.push_back(id, 1));
+  for (OrderId id = 1; id < 7; ++id) q.erase(tickets[id]);
+  // 6 tombstones outnumber 2 orders, but are cheaper to skip.
+  EXPECT_FALSE(q.NeedsCompaction());
+  EXPECT_EQ(Ids(q), (std::vector<OrderId>{0, 7}));
+}
+
+TEST(OrderQueue, MovesOrders) {
+  OrderQueue q;
+  OrderQueue::Ticket t = q.push_back(1, 10);
+  q.push_back(2, 20);
+
+  OrderQueue moved(std::move(q));
+  EXPECT_EQ(moved.at(t).id, 1);
+  EXPECT_EQ(Ids(moved), (std::vector<OrderId>{1, 2}));
+
+  q = std::move(moved);
+  EXPECT_EQ(Ids(q), (std::vector<OrderId>{1, 2}));
+}
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,220 @@
+#include "orderflow.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace mukhi::matching_engine {
+
+OrderFlowGenerator::OrderFlowGenerator(const OrderFlowOptions& options)
+    : options_(options),
+      rng_(options.seed),
+      unit_(0, 1),
+      mid_step_(0, options.mid_volatility),
+      depth_(1 / std::max(options.mean_depth, 1.0)),
+      aggression_(0.5),
+      qty_(1, std::max<Quantity>(options.max_qty, 1)),
+      next_order_id_(options.first_order_id) {
+  // Find the smallest power of ten that turns the tick size into an integer.
+  scale_ = 1;
+  while (scale_ < 1e9 &&
+         std::fabs(options.tick_size * scale_ -
+                   std::round(options.tick_size * scale_)) > 1e-6) {
+    scale_ *= 10;
+  }
+  tick_units_ = std::llround(options.tick_size * scale_);
+  center_ticks_ = std::round(options.initial_mid / options.tick_size);
+  mid_ticks_ = center_ticks_;
+  // Keep passive buys well above zero.
+  min_mid_ticks_ = static_cast<int64_t>(10 * options.mean_depth) + 1;
+  candidates_.reserve(options.cancel_window);
+  for (size_t i = 0; i < options.num_symbols; ++i) {
+    symbols_.push_back(*Symbol::FromString("S" + std::to_string(i)));
+  }
+}
+
+int64_t OrderFlowGenerator::ToTicks(Price price) const {
+  return std::llround(price * scale_) / tick_units_;
+}
+
+Price OrderFlowGenerator::ToPrice(int64_t ticks) const {
+  // A single division of integers is correctly rounded, so the price is the
+  // closest double to the decimal value.
+  return static_cast<double>(ticks * tick_units_) / scale_;
+}
+
+void OrderFlowGenerator::Track(const AddOrderRequest& order) {
+  if (candidates_.size() == options_.cancel_window) {
+    // Stop tracking the order deepest in the book, which is the least likely
+    // to be reached by the mid.
+    int64_t mid = std::llround(mid_ticks_);
+    bool bid = asks_.empty() ||
+               (!bids_.empty() &&
+                mid - bids_.begin()->first >= asks_.rbegin()->first - mid);
+    Untrack(bid ? bids_.begin()->second : asks_.rbegin()->second);
+  }
+  Levels& levels = order.side == Side::kBuy ? bids_ : asks_;
+  candidates_.push_back(Candidate{
+      .order = order,
+      .level = levels.emplace(ToTicks(order.price), candidates_.size())});
+}
+
+void OrderFlowGenerator::Untrack(size_t i) {
+  Levels& levels = candidates_[i].order.side == Side::kBuy ? bids_ : asks_;
+  levels.erase(candidates_[i].level);
+  if (i + 1 < candidates_.size()) {
+    candidates_[i] = candidates_.back();
+    candidates_[i].level->second = i;
+  }
+  candidates_.pop_back();
+}
+
+std::optional<size_t> OrderFlowGenerator::Crossed(
+    const AddOrderRequest& order) const {
+  int64_t ticks = ToTicks(order.price);
+  if (order.side == Side::kBuy) {
+    if (!asks_.empty() && asks_.begin()->first <= ticks) {
+      return asks_.begin()->second;
+    }
+  } else if (!bids_.empty() && bids_.rbegin()->first >= ticks) {
+    return bids_.rbegin()->second;
+  }
+  return std::nullopt;
+}
+
+AddOrderRequest OrderFlowGenerator::NextAdd() {
+  mid_ticks_ += options_.mid_reversion * (center_ticks_ - mid_ticks_) +
+                mid_step_(rng_);
+  mid_ticks_ = std::max(mid_ticks_, static_cast<double>(min_mid_ticks_));
+  int64_t mid = std::llround(mid_ticks_);
+
+  AddOrderRequest req;
+  req.order_id = next_order_id_++;
+  req.side = unit_(rng_) < 0.5 ? Side::kBuy : Side::kSell;
+  req.qty = qty_(rng_);
+  // Positive offsets are passive, negative ones cross the mid.
+  marketable_ = unit_(rng_) < options_.marketable_fraction;
+  int64_t offset = marketable_ ? -(1 + aggression_(rng_)) : 1 + depth_(rng_);
+  int64_t ticks = req.side == Side::kBuy ? mid - offset : mid + offset;
+  req.price = ToPrice(std::max<int64_t>(ticks, 1));
+  if (!symbols_.empty()) req.symbol = symbols_[rng_() % symbols_.size()];
+  return req;
+}
+
+ModifyOrderRequest OrderFlowGenerator::NextModify(size_t i) {
+  Candidate& candidate = candidates_[i];
+  AddOrderRequest& order = candidate.order;
+  if (order.qty > 1 && unit_(rng_) < 0.5) {
+    // Reduced in place.
+    order.qty = 1 + rng_() % (order.qty - 1);
+  } else {
+    int64_t offset = 1 + static_cast<int64_t>(rng_() % 3);
+    if (unit_(rng_) < 0.5) offset = -offset;
+    int64_t ticks = ToTicks(order.price) + offset;
+    // Moved away from the other side of the book rather than onto it.
+    if (order.side == Side::kBuy
+            ? !asks_.empty() && ticks >= asks_.begin()->first
+            : !bids_.empty() && ticks <= bids_.rbegin()->first) {
+      ticks -= 2 * offset;
+    }
+    order.price = ToPrice(std::max<int64_t>(ticks, 1));
+    order.qty = qty_(rng_);
+    Levels& levels = order.side == Side::kBuy ? bids_ : asks_;
+    levels.erase(candidate.level);
+    candidate.level = levels.emplace(ToTicks(order.price), i);
+  }
+  return ModifyOrderRequest{.order_id = order.order_id,
+                            .qty = order.qty,
+                            .price = order.price,
+                            .symbol = order.symbol};
+}
+
+CancelOrderRequest OrderFlowGenerator::NextCancel(size_t i) {
+  CancelOrderRequest req{.order_id = candidates_[i].order.order_id,
+                         .symbol = candidates_[i].order.symbol};
+  Untrack(i);
+  return req;
+}
+
+InputMessage OrderFlowGenerator::Next() {
+  while (!next_add_.has_value()) {
+    if (candidates_.empty()) {
+      next_add_ = NextAdd();
+      break;
+    }
+    double draw = unit_(rng_);
+    if (draw >= options_.cancel_ratio + options_.modify_ratio) {
+      next_add_ = NextAdd();
+      break;
+    }
+    size_t i = rng_() % candidates_.size();
+    if (draw >= options_.cancel_ratio) return NextModify(i);
+    if (cancels_ahead_ == 0) return NextCancel(i);
+    // Already sent ahead of an add, see below.
+    --cancels_ahead_;
+  }
+  if (!marketable_) {
+    // The orders a passive order would trade with are those the mid has moved
+    // through since they were added. Cancel them first, as their owners would
+    // have, and count them towards `cancel_ratio`.
+    if (std::optional<size_t> i = Crossed(*next_add_)) {
+      ++cancels_ahead_;
+      return NextCancel(*i);
+    }
+  }
+  AddOrderRequest req = *next_add_;
+  next_add_.reset();
+  // Marketable orders trade on arrival, there's rarely anything left of them
+  // to cancel.
+  if (!marketable_ && options_.cancel_window > 0) Track(req);
+  return req;
+}
+
+namespace {
+char* AppendSymbol(char* p, const Symbol& symbol) {
+  if (symbol.empty()) return p;
+  *p++ = ',';
+  std::string_view s = symbol.view();
+  std::memcpy(p, s.data(), s.size());
+  return p + s.size();
+}
+}  // namespace
+
+size_t FormatCsv(const InputMessage& msg, char* out) {
+  char* p = out;
+  char* end = out + kMaxCsvLineSize;
+  if (const auto* add = std::get_if<AddOrderRequest>(&msg)) {
+    *p++ = '0';
+    *p++ = ',';
+    p = std::to_chars(p, end, add->order_id).ptr;
+    *p++ = ',';
+    *p++ = add->side == Side::kBuy ? '0' : '1';
+    *p++ = ',';
+    p = std::to_chars(p, end, add->qty).ptr;
+    *p++ = ',';
+    // Shortest representation that round trips, e.g. 1075.5 and not 1075.50.
+    p = std::to_chars(p, end, add->price, std::chars_format::fixed).ptr;
+    p = AppendSymbol(p, add->symbol);
+  } else if (const auto* modify = std::get_if<ModifyOrderRequest>(&msg)) {
+    *p++ = '5';
+    *p++ = ',';
+    p = std::to_chars(p, end, modify->order_id).ptr;
+    *p++ = ',';
+    p = std::to_chars(p, end, modify->qty).ptr;
+    *p++ = ',';
+    p = std::to_chars(p, end, modify->price, std::chars_format::fixed).ptr;
+    p = AppendSymbol(p, modify->symbol);
+  } else {
+    const auto& cancel = std::get<CancelOrderRequest>(msg);
+    *p++ = '1';
+    *p++ = ',';
+    p = std::to_chars(p, end, cancel.order_id).ptr;
+    p = AppendSymbol(p, cancel.symbol);
+  }
+  *p++ = '\n';
+  return static_cast<size_t>(p - out);
+}
+
+}  // namespace mukhi::matching_engine
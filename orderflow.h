@@ -0,0 +1,140 @@
+#ifndef MATCHING_ENGINE_ORDERFLOW_H
+#define MATCHING_ENGINE_ORDERFLOW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "messages.h"
+
+namespace mukhi::matching_engine {
+
+struct OrderFlowOptions {
+  // Seed of the random number generator, equal seeds produce equal flows.
+  uint64_t seed = 1;
+  // Fraction of the messages that cancel an earlier order.
+  double cancel_ratio = 0.3;
+  // Fraction of the messages that modify an earlier order, half of them by
+  // lowering its quantity and half by moving it a few ticks with a new
+  // quantity.
+  double modify_ratio = 0;
+  // Fraction of the add order requests priced through the mid, so that most of
+  // them trade on arrival. Passive orders never do.
+  double marketable_fraction = 0.1;
+  // Prices are multiples of `tick_size`, which must be positive and have at
+  // most 9 decimal places.
+  Price tick_size = 1;
+  Price initial_mid = 100000;
+  // Standard deviation of the random walk of the mid per message, in ticks.
+  double mid_volatility = 0.1;
+  // Fraction of its distance from `initial_mid` the mid moves back by per
+  // message, which keeps it within a few `mid_volatility / sqrt(2 *
+  // mid_reversion)` ticks of it. With 0, the mid drifts without bound.
+  double mid_reversion = 0.001;
+  // Mean distance of passive orders from the mid, in ticks.
+  double mean_depth = 10;
+  // Quantities are uniformly distributed in `[1, max_qty]`.
+  Quantity max_qty = 100;
+  OrderId first_order_id = 1;
+  // Cancels and modifies are drawn from a sample of at most this many earlier
+  // orders.
+  size_t cancel_window = 1 << 16;
+  // Orders are spread uniformly over this many instruments, with symbols `S0`,
+  // `S1` and so on, which share the same mid. With 0, all orders are for the
+  // default instrument and carry no symbol.
+  size_t num_symbols = 0;
+};
+
+/*
+Generates a synthetic, but realistic, stream of input messages for load testing
+and benchmarks.
+
+Add order requests are placed around a mid that moves as a mean-reverting
+random walk. Passive orders rest at a geometrically distributed number of ticks
+away from the mid, while marketable orders cross it by a few ticks, so that the
+fraction of adds that trade follows `marketable_fraction`. Cancel requests
+target a random order from a bounded sample of the passive orders added so far,
+so memory use doesn't depend on the length of the flow, and so do modify
+requests. Once the sample is full, the order deepest in the book drops out of
+it. Since the generator doesn't match orders, some cancels and modifies target
+orders that have been filled in the meantime, just like in real flow.
+
+Passive orders must not trade with the orders the mid has moved through since
+they were added, so those of the sample a passive order would cross are
+canceled right before it, in place of the next cancels drawn. Modifies don't
+move orders onto the other side of the book either.
+
+This class is not thread-safe.
+*/
+class OrderFlowGenerator {
+ public:
+  explicit OrderFlowGenerator(const OrderFlowOptions& options);
+
+  InputMessage Next();
+
+ private:
+  // Passive orders by price in ticks, with their index in `candidates_`.
+  using Levels = std::multimap<int64_t, size_t>;
+  struct Candidate {
+    AddOrderRequest order;
+    Levels::iterator level;
+  };
+
+  // Adds `order` to the candidates, making room for it if needed.
+  void Track(const AddOrderRequest& order);
+  // Removes the candidate at index `i`.
+  void Untrack(size_t i);
+  // Returns the index of a candidate `order` would trade with, if any.
+  std::optional<size_t> Crossed(const AddOrderRequest& order) const;
+  AddOrderRequest NextAdd();
+  // Modifies the candidate at index `i`.
+  ModifyOrderRequest NextModify(size_t i);
+  // Cancels the candidate at index `i`.
+  CancelOrderRequest NextCancel(size_t i);
+  int64_t ToTicks(Price price) const;
+  // Converts a number of ticks to a price without accumulating rounding errors.
+  Price ToPrice(int64_t ticks) const;
+
+  const OrderFlowOptions options_;
+  std::mt19937_64 rng_;
+  std::uniform_real_distribution<double> unit_;
+  std::normal_distribution<double> mid_step_;
+  std::geometric_distribution<int64_t> depth_;
+  std::geometric_distribution<int64_t> aggression_;
+  std::uniform_int_distribution<Quantity> qty_;
+
+  // `tick_size` as an integer number of `1 / scale_` units.
+  int64_t tick_units_;
+  double scale_;
+  double center_ticks_;
+  double mid_ticks_;
+  int64_t min_mid_ticks_;
+  OrderId next_order_id_;
+  std::vector<Symbol> symbols_;
+  // Orders that cancels and modifies may target, as last added or modified.
+  std::vector<Candidate> candidates_;
+  Levels bids_;
+  Levels asks_;
+  // The add to send once the candidates it would trade with are canceled.
+  std::optional<AddOrderRequest> next_add_;
+  bool marketable_ = false;
+  // Cancels sent ahead of adds, which take the place of later cancels.
+  uint64_t cancels_ahead_ = 0;
+};
+
+// Enough for any message, including prices of up to 309 integer digits.
+constexpr size_t kMaxCsvLineSize = 384;
+
+/**
+ Formats `msg` as a line of the CSV input format (including the new line) into
+`out`, which must have room for at least `kMaxCsvLineSize` bytes. Returns the
+number of bytes written.
+*/
+size_t FormatCsv(const InputMessage& msg, char* out);
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_ORDERFLOW_H
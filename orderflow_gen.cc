@@ -0,0 +1,194 @@
+// Writes a synthetic order flow in the engine's input format, e.g.:
+//
+// $ bazel-bin/orderflow_gen --messages=100000000 --seed=7 --output=flow.txt
+//
+// Run with --help to list all the flags.
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "orderflow.h"
+
+namespace {
+
+using mukhi::matching_engine::EncodeBinary;
+using mukhi::matching_engine::FormatCsv;
+using mukhi::matching_engine::InputMessage;
+using mukhi::matching_engine::kMaxBinaryMessageSize;
+using mukhi::matching_engine::kMaxCsvLineSize;
+using mukhi::matching_engine::OrderFlowGenerator;
+using mukhi::matching_engine::OrderFlowOptions;
+
+struct Flags {
+  uint64_t messages = 1000000;
+  std::string format = "csv";
+  std::string output;
+  OrderFlowOptions flow;
+};
+
+constexpr char kUsage[] = R"(Flags:
+  --messages=N             Number of messages to write (default 1000000).
+  --format=csv|binary      Output format (default csv).
+  --output=PATH            Output file (default stdout).
+  --seed=N                 Seed of the random number generator.
+  --cancel_ratio=F         Fraction of messages that are cancels.
+  --modify_ratio=F         Fraction of messages that are modifies (default 0).
+  --marketable_fraction=F  Fraction of adds that cross the mid.
+  --tick_size=F            Price increment.
+  --initial_mid=F          Starting mid price.
+  --mid_volatility=F       Std deviation of the mid per message, in ticks.
+  --mid_reversion=F        Fraction of its distance from the initial mid the
+                           mid moves back by per message.
+  --mean_depth=F           Mean distance of passive orders from the mid, in
+                           ticks.
+  --max_qty=N              Maximum order quantity.
+  --first_order_id=N       Id of the first order.
+  --cancel_window=N        Number of earlier orders cancels and modifies are
+                           drawn from.
+  --num_symbols=N          Number of instruments, 0 for the default one only.
+)";
+
+// Parses `--<name>=<value>` and returns the value, or nullptr if `arg` is not
+// `name`.
+const char* FlagValue(std::string_view arg, std::string_view name) {
+  if (arg.substr(0, 2) != "--" || arg.substr(2, name.size()) != name ||
+      arg.substr(2 + name.size(), 1) != "=") {
+    return nullptr;
+  }
+  return arg.data() + 3 + name.size();
+}
+
+bool ParseFlags(int argc, char** argv, Flags& flags) {
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg(argv[i]);
+    const char* v;
+    if ((v = FlagValue(arg, "messages"))) {
+      flags.messages = std::strtoull(v, nullptr, 10);
+    } else if ((v = FlagValue(arg, "format"))) {
+      flags.format = v;
+    } else if ((v = FlagValue(arg, "output"))) {
+      flags.output = v;
+    } else if ((v = FlagValue(arg, "seed"))) {
+      flags.flow.seed = std::strtoull(v, nullptr, 10);
+    } else if ((v = FlagValue(arg, "cancel_ratio"))) {
+      flags.flow.cancel_ratio = std::strtod(v, nullptr);
+    } else if ((v = FlagValue(arg, "modify_ratio"))) {
+      flags.flow.modify_ratio = std::strtod(v, nullptr);
+    } else if ((v = FlagValue(arg, "marketable_fraction"))) {
+      flags.flow.marketable_fraction = std::strtod(v, nullptr);
+    } else if ((v = FlagValue(arg, "tick_size"))) {
+      flags.flow.tick_size = std::strtod(v, nullptr);
+    } else if ((v = FlagValue(arg, "initial_mid"))) {
+      flags.flow.initial_mid = std::strtod(v, nullptr);
+    } else if ((v = FlagValue(arg, "mid_volatility"))) {
+      flags.flow.mid_volatility = std::strtod(v, nullptr);
+    } else if ((v = FlagValue(arg, "mid_reversion"))) {
+      flags.flow.mid_reversion = std::strtod(v, nullptr);
+    } else if ((v = FlagValue(arg, "mean_depth"))) {
+      flags.flow.mean_depth = std::strtod(v, nullptr);
+    } else if ((v = FlagValue(arg, "max_qty"))) {
+      flags.flow.max_qty = std::strtoull(v, nullptr, 10);
+    } else if ((v = FlagValue(arg, "first_order_id"))) {
+      flags.flow.first_order_id = std::strtoull(v, nullptr, 10);
+    } else if ((v = FlagValue(arg, "cancel_window"))) {
+      flags.flow.cancel_window = std::strtoull(v, nullptr, 10);
+    } else if ((v = FlagValue(arg, "num_symbols"))) {
+      flags.flow.num_symbols = std::strtoull(v, nullptr, 10);
+    } else {
+      std::cerr << "Unknown flag: " << arg << std::endl;
+      return false;
+    }
+  }
+  if (flags.flow.tick_size <= 0) {
+    std::cerr << "--tick_size must be positive." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Formats messages into a large buffer and writes it out in big chunks.
+class Writer {
+ public:
+  using FormatFunction = size_t (*)(const InputMessage&, char*);
+
+  Writer(FILE* file, FormatFunction format, size_t max_message_size)
+      : file_(file),
+        format_(format),
+        max_message_size_(max_message_size),
+        buf_(kBufferSize) {}
+
+  bool Write(const InputMessage& msg) {
+    if (size_ + max_message_size_ > buf_.size() && !Flush()) return false;
+    size_ += format_(msg, buf_.data() + size_);
+    return true;
+  }
+
+  bool Flush() {
+    bool ok = std::fwrite(buf_.data(), 1, size_, file_) == size_;
+    size_ = 0;
+    return ok && std::fflush(file_) == 0;
+  }
+
+ private:
+  static constexpr size_t kBufferSize = 1 << 20;
+
+  FILE* file_;
+  FormatFunction format_;
+  size_t max_message_size_;
+  std::vector<char> buf_;
+  size_t size_ = 0;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1 && std::string_view(argv[1]) == "--help") {
+    std::cout << kUsage;
+    return 0;
+  }
+  Flags flags;
+  if (!ParseFlags(argc, argv, flags)) {
+    std::cerr << kUsage;
+    return 1;
+  }
+
+  Writer::FormatFunction format;
+  size_t max_message_size;
+  if (flags.format == "csv") {
+    format = FormatCsv;
+    max_message_size = kMaxCsvLineSize;
+  } else if (flags.format == "binary") {
+    format = EncodeBinary;
+    max_message_size = kMaxBinaryMessageSize;
+  } else {
+    std::cerr << "Unknown format: " << flags.format << std::endl;
+    return 1;
+  }
+
+  FILE* file = stdout;
+  if (!flags.output.empty()) {
+    file = std::fopen(flags.output.c_str(), "wb");
+    if (file == nullptr) {
+      std::perror(flags.output.c_str());
+      return 1;
+    }
+  }
+
+  OrderFlowGenerator generator(flags.flow);
+  Writer writer(file, format, max_message_size);
+  for (uint64_t i = 0; i < flags.messages; ++i) {
+    if (!writer.Write(generator.Next())) {
+      std::perror("write");
+      return 1;
+    }
+  }
+  if (!writer.Flush() || (file != stdout && std::fclose(file) != 0)) {
+    std::perror("write");
+    return 1;
+  }
+  return 0;
+}
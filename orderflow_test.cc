@@ -0,0 +1,261 @@
+#include "orderflow.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "event_sink.h"
+#include "order_book.h"
+
+namespace mukhi::matching_engine {
+
+std::string Csv(const InputMessage& msg) {
+  char buf[kMaxCsvLineSize];
+  return std::string(buf, FormatCsv(msg, buf));
+}
+
+TEST(FormatCsv, AddOrderRequest) {
+  EXPECT_EQ(Csv(AddOrderRequest{
+                .order_id = 123, .side = Side::kBuy, .qty = 9, .price = 1000}),
+            "0,123,0,9,1000\n");
+  EXPECT_EQ(Csv(AddOrderRequest{.order_id = 1000000,
+                                .side = Side::kSell,
+                                .qty = 45,
+                                .price = 1075.5}),
+            "0,1000000,1,45,1075.5\n");
+  EXPECT_EQ(Csv(AddOrderRequest{.order_id = 1,
+                                .side = Side::kSell,
+                                .qty = 1,
+                                .price = 10000000}),
+            "0,1,1,1,10000000\n");
+}
+
+TEST(FormatCsv, CancelOrderRequest) {
+  EXPECT_EQ(Csv(CancelOrderRequest{.order_id = 123}), "1,123\n");
+}
+
+TEST(FormatCsv, ModifyOrderRequest) {
+  EXPECT_EQ(Csv(ModifyOrderRequest{.order_id = 123, .qty = 9, .price = 1075.5}),
+            "5,123,9,1075.5\n");
+  EXPECT_EQ(Csv(ModifyOrderRequest{.order_id = 123,
+                                   .qty = 0,
+                                   .price = 1000,
+                                   .symbol = *Symbol::FromString("AAPL")}),
+            "5,123,0,1000,AAPL\n");
+}
+
+TEST(FormatCsv, Symbol) {
+  Symbol symbol = *Symbol::FromString("AAPL");
+  EXPECT_EQ(Csv(AddOrderRequest{.order_id = 123,
+                                .side = Side::kBuy,
+                                .qty = 9,
+                                .price = 1000,
+                                .symbol = symbol}),
+            "0,123,0,9,1000,AAPL\n");
+  EXPECT_EQ(Csv(CancelOrderRequest{.order_id = 123, .symbol = symbol}),
+            "1,123,AAPL\n");
+}
+
+TEST(OrderFlowGenerator, Symbols) {
+  OrderFlowGenerator g(OrderFlowOptions{.num_symbols = 3});
+  std::map<OrderId, std::string> symbols;
+  for (int i = 0; i < 10000; ++i) {
+    InputMessage msg = g.Next();
+    if (const auto* add = std::get_if<AddOrderRequest>(&msg)) {
+      symbols[add->order_id] = std::string(add->symbol.view());
+    } else {
+      // Cancels are for the instrument of the order.
+      const auto& cancel = std::get<CancelOrderRequest>(msg);
+      EXPECT_EQ(cancel.symbol.view(), symbols.at(cancel.order_id));
+    }
+  }
+  std::set<std::string> distinct;
+  for (const auto& [id, symbol] : symbols) distinct.insert(symbol);
+  EXPECT_EQ(distinct, (std::set<std::string>{"S0", "S1", "S2"}));
+}
+
+TEST(OrderFlowGenerator, SameSeedSameFlow) {
+  OrderFlowGenerator g1(OrderFlowOptions{.seed = 7});
+  OrderFlowGenerator g2(OrderFlowOptions{.seed = 7});
+  OrderFlowGenerator g3(OrderFlowOptions{.seed = 8});
+  bool differs = false;
+  for (int i = 0; i < 1000; ++i) {
+    std::string line = Csv(g1.Next());
+    EXPECT_EQ(line, Csv(g2.Next()));
+    differs |= line != Csv(g3.Next());
+  }
+  EXPECT_TRUE(differs);
+}
+
+TEST(OrderFlowGenerator, FlowIsParsable) {
+  OrderFlowGenerator g(OrderFlowOptions{.tick_size = 0.01,
+                                        .initial_mid = 1075.25,
+                                        .mid_volatility = 2});
+  std::ostringstream es;
+  for (int i = 0; i < 10000; ++i) {
+    InputMessage msg = g.Next();
+    std::string line = Csv(msg);
+    ASSERT_EQ(line.back(), '\n');
+    line.pop_back();
+    std::optional<InputMessage> parsed = parse(line, es);
+    ASSERT_NE(parsed, std::nullopt) << line;
+    if (const auto* add = std::get_if<AddOrderRequest>(&msg)) {
+      const auto& parsed_add = std::get<AddOrderRequest>(*parsed);
+      EXPECT_EQ(parsed_add.order_id, add->order_id);
+      EXPECT_EQ(parsed_add.side, add->side);
+      EXPECT_EQ(parsed_add.qty, add->qty);
+      EXPECT_EQ(parsed_add.price, add->price);
+      // Prices are on the grid.
+      double ticks = add->price / 0.01;
+      EXPECT_NEAR(ticks, std::round(ticks), 1e-6) << line;
+    } else {
+      EXPECT_EQ(std::get<CancelOrderRequest>(*parsed).order_id,
+                std::get<CancelOrderRequest>(msg).order_id);
+    }
+  }
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST(OrderFlowGenerator, Ratios) {
+  OrderFlowOptions options{.cancel_ratio = 0.4,
+                           .marketable_fraction = 0,
+                           .initial_mid = 1000,
+                           .mid_volatility = 0,
+                           .max_qty = 10,
+                           .first_order_id = 100};
+  OrderFlowGenerator g(options);
+  int cancels = 0;
+  std::set<OrderId> added;
+  std::set<OrderId> canceled;
+  constexpr int kMessages = 100000;
+  for (int i = 0; i < kMessages; ++i) {
+    InputMessage msg = g.Next();
+    if (const auto* add = std::get_if<AddOrderRequest>(&msg)) {
+      EXPECT_TRUE(added.insert(add->order_id).second);
+      EXPECT_GE(add->order_id, 100);
+      EXPECT_GE(add->qty, 1);
+      EXPECT_LE(add->qty, 10);
+      // Nothing is marketable, and the mid doesn't move.
+      if (add->side == Side::kBuy) {
+        EXPECT_LT(add->price, 1000);
+      } else {
+        EXPECT_GT(add->price, 1000);
+      }
+    } else {
+      ++cancels;
+      OrderId id = std::get<CancelOrderRequest>(msg).order_id;
+      // Only orders that were added, and only once.
+      EXPECT_EQ(added.count(id), 1);
+      EXPECT_TRUE(canceled.insert(id).second);
+    }
+  }
+  EXPECT_NEAR(static_cast<double>(cancels) / kMessages, 0.4, 0.02);
+}
+
+TEST(OrderFlowGenerator, Modifies) {
+  OrderFlowOptions options{.cancel_ratio = 0.2,
+                           .modify_ratio = 0.4,
+                           .tick_size = 0.5,
+                           .max_qty = 10};
+  OrderFlowGenerator g(options);
+  int modifies = 0;
+  int reductions = 0;
+  std::map<OrderId, AddOrderRequest> orders;
+  std::ostringstream es;
+  constexpr int kMessages = 100000;
+  for (int i = 0; i < kMessages; ++i) {
+    InputMessage msg = g.Next();
+    if (const auto* add = std::get_if<AddOrderRequest>(&msg)) {
+      orders[add->order_id] = *add;
+    } else if (const auto* modify = std::get_if<ModifyOrderRequest>(&msg)) {
+      ++modifies;
+      // Only orders that were added and not canceled.
+      auto itr = orders.find(modify->order_id);
+      ASSERT_NE(itr, orders.end());
+      AddOrderRequest& order = itr->second;
+      if (modify->price == order.price) {
+        EXPECT_LT(modify->qty, order.qty);
+        ++reductions;
+      } else {
+        EXPECT_LE(std::fabs(modify->price - order.price), 1.5);
+      }
+      EXPECT_GE(modify->qty, 1);
+      double ticks = modify->price / 0.5;
+      EXPECT_NEAR(ticks, std::round(ticks), 1e-6);
+      order.qty = modify->qty;
+      order.price = modify->price;
+
+      std::string line = Csv(msg);
+      line.pop_back();
+      std::optional<InputMessage> parsed = parse(line, es);
+      ASSERT_NE(parsed, std::nullopt) << line;
+      EXPECT_EQ(std::get<ModifyOrderRequest>(*parsed).price, modify->price);
+    } else {
+      EXPECT_EQ(orders.erase(std::get<CancelOrderRequest>(msg).order_id), 1);
+    }
+  }
+  EXPECT_NEAR(static_cast<double>(modifies) / kMessages, 0.4, 0.02);
+  // About half of the modifies, less those of orders of quantity 1.
+  EXPECT_NEAR(static_cast<double>(reductions) / modifies, 0.45, 0.05);
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST(OrderFlowGenerator, MarketableFraction) {
+  OrderFlowGenerator g(OrderFlowOptions{.cancel_ratio = 0,
+                                        .marketable_fraction = 0.25,
+                                        .initial_mid = 1000,
+                                        .mid_volatility = 0});
+  int marketable = 0;
+  constexpr int kMessages = 100000;
+  for (int i = 0; i < kMessages; ++i) {
+    auto add = std::get<AddOrderRequest>(g.Next());
+    if (add.side == Side::kBuy ? add.price > 1000 : add.price < 1000) {
+      ++marketable;
+    }
+  }
+  EXPECT_NEAR(static_cast<double>(marketable) / kMessages, 0.25, 0.02);
+}
+
+TEST(OrderFlowGenerator, TradeRateFollowsMarketableFraction) {
+  for (double fraction : {0.0, 0.1, 0.3}) {
+    OrderFlowGenerator g(OrderFlowOptions{.marketable_fraction = fraction});
+    int trades = 0;
+    CallbackEventSink sink([&trades](const OutputEvent& event) {
+      if (std::holds_alternative<TradeEvent>(event)) ++trades;
+    });
+    std::ostringstream es;
+    OrderBook book(sink, es);
+    int adds = 0;
+    int trading_adds = 0;
+    int cancels = 0;
+    constexpr int kMessages = 200000;
+    for (int i = 0; i < kMessages; ++i) {
+      InputMessage msg = g.Next();
+      int before = trades;
+      std::visit([&book](const auto& req) { book.ProcessOrder(req); }, msg);
+      if (std::holds_alternative<AddOrderRequest>(msg)) {
+        ++adds;
+        if (trades > before) ++trading_adds;
+      } else {
+        ++cancels;
+      }
+    }
+    // Passive orders don't trade on arrival, even as the mid moves, and most
+    // marketable ones do.
+    double rate = static_cast<double>(trading_adds) / adds;
+    EXPECT_LE(rate, fraction + 0.005) << fraction;
+    EXPECT_GE(rate, 0.8 * fraction) << fraction;
+    if (fraction == 0) {
+      EXPECT_EQ(trades, 0);
+    }
+    // Canceling the orders the mid moved through keeps the ratio of cancels.
+    EXPECT_NEAR(static_cast<double>(cancels) / kMessages, 0.3, 0.01)
+        << fraction;
+  }
+}
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,73 @@
+#include "pipeline.h"
+
+#include <functional>
+#include <utility>
+
+namespace mukhi::matching_engine {
+
+namespace {
+// Number of items taken off a ring at once.
+constexpr size_t kBatchSize = 64;
+}  // namespace
+
+Pipeline::Pipeline(size_t ring_capacity)
+    : inputs_(ring_capacity), events_(ring_capacity), book_sink_(events_) {}
+
+Pipeline::~Pipeline() { Finish(); }
+
+void Pipeline::Start(OrderBook& book, std::ostream& es, EventSink& output) {
+  matcher_ = std::thread(&Pipeline::Match, this, std::ref(book), std::ref(es));
+  publisher_ = std::thread(&Pipeline::Publish, this, std::ref(output));
+}
+
+void Pipeline::Push(const InputMessage& msg) {
+  std::visit([this](const auto& req) { inputs_.Push(req); }, msg);
+}
+
+void Pipeline::PushError(std::string error) {
+  inputs_.Push(std::move(error));
+}
+
+void Pipeline::Finish() {
+  if (!matcher_.joinable()) return;
+  inputs_.Close();
+  matcher_.join();
+  publisher_.join();
+}
+
+void Pipeline::Match(OrderBook& book, std::ostream& es) {
+  Input batch[kBatchSize];
+  while (size_t n = inputs_.PopBatch(batch, kBatchSize)) {
+    for (size_t i = 0; i < n; ++i) {
+      if (const auto* error = std::get_if<std::string>(&batch[i])) {
+        es << *error << std::flush;
+      } else if (const auto* add = std::get_if<AddOrderRequest>(&batch[i])) {
+        book.ProcessOrder(*add);
+      } else if (const auto* cancel =
+                     std::get_if<CancelOrderRequest>(&batch[i])) {
+        book.ProcessOrder(*cancel);
+      } else {
+        book.ProcessOrder(std::get<ModifyOrderRequest>(batch[i]));
+      }
+    }
+  }
+  events_.Close();
+}
+
+void Pipeline::Publish(EventSink& output) {
+  OutputEvent batch[kBatchSize];
+  while (true) {
+    size_t n = events_.TryPopBatch(batch, kBatchSize);
+    if (n == 0) {
+      // Caught up with the matching thread, deliver what we have before
+      // waiting for more.
+      output.Flush();
+      n = events_.PopBatch(batch, kBatchSize);
+      if (n == 0) break;
+    }
+    for (size_t i = 0; i < n; ++i) PublishEvent(batch[i], output);
+  }
+  output.Flush();
+}
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,95 @@
+#ifndef MATCHING_ENGINE_PIPELINE_H
+#define MATCHING_ENGINE_PIPELINE_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <variant>
+
+#include "event_sink.h"
+#include "messages.h"
+#include "order_book.h"
+#include "spsc_ring.h"
+
+namespace mukhi::matching_engine {
+
+/*
+Runs matching and publishing on threads of their own, so that reading and
+parsing the input, matching orders and formatting events overlap and the
+throughput is that of the slowest of them instead of their sum.
+
+The thread pushing input (the reader) hands messages to the matching thread,
+which owns the order book, over a ring. The order book publishes events into a
+second ring, drained by the publishing thread into the output sink. Both rings
+are bounded, so a slow stage holds back the ones before it, and a stage with
+nothing to do sleeps until there is, see `SpscRing`.
+
+Parse errors are pushed into the first ring as well, and written out by the
+matching thread along with the errors of the order book, so errors and events
+come out in exactly the same order as when processing serially.
+
+A pipeline is used once: `Start`, any number of `Push` and `PushError` from a
+single thread, then `Finish`.
+*/
+class Pipeline {
+ public:
+  static constexpr size_t kDefaultRingCapacity = 1 << 14;
+
+  explicit Pipeline(size_t ring_capacity = kDefaultRingCapacity);
+  // Finishes the pipeline if it's still running.
+  ~Pipeline();
+
+  // The sink the order book must publish to.
+  EventSink& book_sink() { return book_sink_; }
+
+  /**
+  Starts the matching thread, which processes messages with `book` and writes
+  errors to `es`, and the publishing thread, which writes events to `output`.
+  */
+  void Start(OrderBook& book, std::ostream& es, EventSink& output);
+
+  void Push(const InputMessage& msg);
+  // `error` is written to the error stream as is.
+  void PushError(std::string error);
+
+  // Waits for all the input pushed so far to be processed and its events to be
+  // published and flushed.
+  void Finish();
+
+ private:
+  using Input = std::variant<AddOrderRequest, CancelOrderRequest,
+                             ModifyOrderRequest, std::string>;
+
+  // Publishes events into the ring of the publishing thread.
+  class RingSink : public EventSink {
+   public:
+    explicit RingSink(SpscRing<OutputEvent>& ring) : ring_(ring) {}
+
+    void OnTradeEvent(const TradeEvent& event) override { ring_.Push(event); }
+    void OnOrderFullyFilled(const OrderFullyFilled& event) override {
+      ring_.Push(event);
+    }
+    void OnOrderPartiallyFilled(const OrderPartiallyFilled& event) override {
+      ring_.Push(event);
+    }
+    void OnDepthUpdate(const DepthUpdate& event) override { ring_.Push(event); }
+    void OnBboUpdate(const Bbo& event) override { ring_.Push(event); }
+
+   private:
+    SpscRing<OutputEvent>& ring_;
+  };
+
+  void Match(OrderBook& book, std::ostream& es);
+  void Publish(EventSink& output);
+
+  SpscRing<Input> inputs_;
+  SpscRing<OutputEvent> events_;
+  RingSink book_sink_;
+  std::thread matcher_;
+  std::thread publisher_;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_PIPELINE_H
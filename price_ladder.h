@@ -0,0 +1,252 @@
+#ifndef MATCHING_ENGINE_PRICE_LADDER_H
+#define MATCHING_ENGINE_PRICE_LADDER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "messages.h"
+
+namespace mukhi::matching_engine {
+
+/**
+ Describes the fixed set of prices an instrument can trade at: every multiple of
+`tick_size` in the closed band `[min_price, max_price]`.
+*/
+struct TickGrid {
+  Price tick_size = 0;
+  Price min_price = 0;
+  Price max_price = 0;
+};
+
+/*
+A contiguous array of price levels, one slot per tick of a `TickGrid`, that can
+be used as a drop-in replacement of `std::map<Price, T, Compare>` by the order
+book.
+
+Slots are laid out in priority order as defined by `Compare` (i.e. for
+`std::less` the lowest price is at slot 0, for `std::greater` the highest), so
+the best level is always the occupied slot with the smallest index. The index
+of the best level is cached and occupied slots are tracked in a two level
+bitset, so:
+
+* Finding, inserting or erasing a level: O(1) without any allocation.
+
+* Advancing from a level to the next occupied one: O(g/4096), where g is the
+number of empty ticks between the two levels.
+
+All the memory is allocated upfront, therefore the band of a grid should be
+kept reasonably tight around the prices that can actually trade.
+
+Iterators and references stay valid until the element they point to is erased.
+
+This class is not thread-safe.
+*/
+template <typename T, typename Compare>
+class PriceLadder {
+ public:
+  static_assert(std::is_same_v<Compare, std::less<Price>> ||
+                    std::is_same_v<Compare, std::greater<Price>>,
+                "PriceLadder only supports std::less or std::greater");
+
+  using key_type = Price;
+  using mapped_type = T;
+  using value_type = std::pair<const Price, T>;
+
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = PriceLadder::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_type*;
+    using reference = value_type&;
+
+    iterator() = default;
+
+    reference operator*() const { return ladder_->slots_[slot_]; }
+    pointer operator->() const { return &ladder_->slots_[slot_]; }
+    iterator& operator++() {
+      slot_ = ladder_->NextOccupied(slot_ + 1);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    bool operator==(const iterator& other) const {
+      return slot_ == other.slot_;
+    }
+    bool operator!=(const iterator& other) const {
+      return slot_ != other.slot_;
+    }
+
+   private:
+    friend class PriceLadder;
+    iterator(PriceLadder* ladder, size_t slot) : ladder_(ladder), slot_(slot) {}
+
+    PriceLadder* ladder_ = nullptr;
+    size_t slot_ = 0;
+  };
+
+  explicit PriceLadder(const TickGrid& grid)
+      : grid_(grid),
+        num_slots_(static_cast<size_t>(
+                       std::llround((grid.max_price - grid.min_price) /
+                                    grid.tick_size)) +
+                   1),
+        occupied_((num_slots_ + 63) / 64, 0),
+        summary_((occupied_.size() + 63) / 64, 0),
+        best_(num_slots_) {
+    slots_.reserve(num_slots_);
+    for (size_t slot = 0; slot < num_slots_; ++slot) {
+      slots_.emplace_back(PriceAt(slot), T());
+    }
+  }
+
+  // Slots point into the ladder itself, so it can't be copied around.
+  PriceLadder(const PriceLadder&) = delete;
+  PriceLadder& operator=(const PriceLadder&) = delete;
+
+  iterator begin() { return iterator(this, best_); }
+  iterator end() { return iterator(this, num_slots_); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Returns true if `price` is on the grid and within its band.
+  bool Contains(Price price) const { return ToSlot(price) != num_slots_; }
+
+  // Hints the CPU to start loading the level of `price`, and whether it's
+  // occupied, if it's on the grid.
+  void Prefetch(Price price) const {
+    size_t slot = ToSlot(price);
+    if (slot == num_slots_) return;
+    __builtin_prefetch(&slots_[slot]);
+    __builtin_prefetch(&occupied_[slot / 64]);
+  }
+
+  iterator find(Price price) {
+    size_t slot = ToSlot(price);
+    if (slot == num_slots_ || !IsOccupied(slot)) return end();
+    return iterator(this, slot);
+  }
+
+  /**
+   Mirrors `std::map::emplace`: occupies the level of `kv.first` with
+   `kv.second` unless it's already occupied. The price must be on the grid
+   (see `Contains`).
+   */
+  template <typename Pair>
+  std::pair<iterator, bool> emplace(Pair&& kv) {
+    size_t slot = ToSlot(kv.first);
+    if (IsOccupied(slot)) return {iterator(this, slot), false};
+    slots_[slot].second = std::forward<Pair>(kv).second;
+    occupied_[slot / 64] |= uint64_t{1} << (slot % 64);
+    summary_[slot / 4096] |= uint64_t{1} << (slot / 64 % 64);
+    ++size_;
+    if (slot < best_) best_ = slot;
+    return {iterator(this, slot), true};
+  }
+
+  // Frees the level pointed to by `itr` and returns the next occupied level.
+  iterator erase(iterator itr) {
+    size_t slot = itr.slot_;
+    slots_[slot].second = T();
+    occupied_[slot / 64] &= ~(uint64_t{1} << (slot % 64));
+    if (occupied_[slot / 64] == 0) {
+      summary_[slot / 4096] &= ~(uint64_t{1} << (slot / 64 % 64));
+    }
+    --size_;
+    size_t next = NextOccupied(slot + 1);
+    if (slot == best_) best_ = next;
+    return iterator(this, next);
+  }
+
+ private:
+  static constexpr bool kAscending = std::is_same_v<Compare, std::less<Price>>;
+
+  // The price of a slot is the exact same double as the orders at that price:
+  // on a grid of `kPriceDecimals` decimal places, it's computed from an integer
+  // number of units like `FixedPointToPrice` does when parsing, rather than by
+  // adding up ticks, which is off by rounding errors for decimal tick sizes.
+  Price PriceAt(size_t slot) const {
+    uint64_t tick = kAscending ? slot : num_slots_ - 1 - slot;
+    constexpr double kScale = 1e6;
+    static_assert(kPriceDecimals == 6, "kScale must be 10^kPriceDecimals");
+    double min_units = std::round(grid_.min_price * kScale);
+    double tick_units = std::round(grid_.tick_size * kScale);
+    double units = min_units + static_cast<double>(tick) * tick_units;
+    // 2^53, past which integers aren't exact in a double.
+    constexpr double kMaxExactUnits = 9007199254740992.0;
+    if (min_units < 0 || units >= kMaxExactUnits ||
+        std::fabs(grid_.min_price * kScale - min_units) > 1e-3 ||
+        std::fabs(grid_.tick_size * kScale - tick_units) > 1e-3) {
+      return grid_.min_price + static_cast<Price>(tick) * grid_.tick_size;
+    }
+    return FixedPointToPrice(static_cast<uint64_t>(units), kPriceDecimals);
+  }
+
+  // Returns `num_slots_` if `price` isn't on the grid.
+  size_t ToSlot(Price price) const {
+    double ticks = (price - grid_.min_price) / grid_.tick_size;
+    if (!(ticks > -0.5)) return num_slots_;
+    int64_t tick = std::llround(ticks);
+    // Tolerate the representation error of decimal prices in binary.
+    if (std::fabs(ticks - static_cast<double>(tick)) > 1e-6) return num_slots_;
+    if (static_cast<size_t>(tick) >= num_slots_) return num_slots_;
+    return kAscending ? static_cast<size_t>(tick)
+                      : num_slots_ - 1 - static_cast<size_t>(tick);
+  }
+
+  bool IsOccupied(size_t slot) const {
+    return (occupied_[slot / 64] >> (slot % 64)) & 1;
+  }
+
+  // First occupied slot at or after `slot`, `num_slots_` if there's none.
+  size_t NextOccupied(size_t slot) const {
+    if (slot >= num_slots_) return num_slots_;
+    size_t word = slot / 64;
+    uint64_t bits = occupied_[word] & (~uint64_t{0} << (slot % 64));
+    if (bits == 0) {
+      // Look for the next non-empty word in the summary.
+      size_t next_word = word + 1;
+      if (next_word == occupied_.size()) return num_slots_;
+      size_t summary_word = next_word / 64;
+      uint64_t summary_bits =
+          summary_[summary_word] & (~uint64_t{0} << (next_word % 64));
+      while (summary_bits == 0) {
+        if (++summary_word == summary_.size()) return num_slots_;
+        summary_bits = summary_[summary_word];
+      }
+      word = summary_word * 64 +
+             static_cast<size_t>(__builtin_ctzll(summary_bits));
+      bits = occupied_[word];
+    }
+    return word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+  }
+
+  const TickGrid grid_;
+  const size_t num_slots_;
+  std::vector<value_type> slots_;
+  // One bit per slot.
+  std::vector<uint64_t> occupied_;
+  // One bit per word of `occupied_` that has any bit set.
+  std::vector<uint64_t> summary_;
+  size_t best_;
+  size_t size_ = 0;
+};
+
+template <typename T>
+struct IsPriceLadder : std::false_type {};
+template <typename T, typename Compare>
+struct IsPriceLadder<PriceLadder<T, Compare>> : std::true_type {};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_PRICE_LADDER_H
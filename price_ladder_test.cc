@@ -0,0 +1,149 @@
+#include "price_ladder.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace mukhi::matching_engine {
+
+using AscendingLadder = PriceLadder<std::string, std::less<Price>>;
+using DescendingLadder = PriceLadder<std::string, std::greater<Price>>;
+
+TEST(PriceLadder, Contains) {
+  AscendingLadder l(
+      TickGrid{.tick_size = 0.5, .min_price = 10, .max_price = 20});
+  EXPECT_TRUE(l.Contains(10.0));
+  EXPECT_TRUE(l.Contains(10.5));
+  EXPECT_TRUE(l.Contains(20.0));
+  // Off the grid.
+  EXPECT_FALSE(l.Contains(10.25));
+  // Out of the band.
+  EXPECT_FALSE(l.Contains(9.5));
+  EXPECT_FALSE(l.Contains(20.5));
+  EXPECT_FALSE(l.Contains(-10.0));
+}
+
+TEST(PriceLadder, DecimalTickSize) {
+  AscendingLadder l(
+      TickGrid{.tick_size = 0.01, .min_price = 0.01, .max_price = 100});
+  EXPECT_TRUE(l.Contains(0.07));
+  EXPECT_TRUE(l.Contains(99.99));
+  EXPECT_FALSE(l.Contains(0.075));
+}
+
+TEST(PriceLadder, PricesAreThoseParsed) {
+  for (Price tick_size : {0.1, 0.01, 0.05}) {
+    AscendingLadder ascending(TickGrid{
+        .tick_size = tick_size, .min_price = tick_size, .max_price = 10});
+    DescendingLadder descending(TickGrid{
+        .tick_size = tick_size, .min_price = tick_size, .max_price = 10});
+    for (int tick = 1; tick * tick_size <= 10; ++tick) {
+      // E.g. 0.3, and not 0.1 + 2 * 0.1 = 0.30000000000000004.
+      std::string text = std::to_string(tick * tick_size);
+      auto price = ParseFixedPoint(text, kPriceDecimals);
+      ASSERT_TRUE(price.has_value()) << text;
+      Price parsed = FixedPointToPrice(*price, kPriceDecimals);
+      EXPECT_EQ(ascending.emplace(std::make_pair(parsed, text)).first->first,
+                parsed)
+          << text;
+      EXPECT_EQ(descending.emplace(std::make_pair(parsed, text)).first->first,
+                parsed)
+          << text;
+    }
+  }
+}
+
+TEST(PriceLadder, EmplaceAndFind) {
+  AscendingLadder l(TickGrid{.tick_size = 1, .min_price = 1, .max_price = 10});
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(l.find(5), l.end());
+
+  auto [itr, inserted] = l.emplace(std::make_pair(5.0, std::string("five")));
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(itr->first, 5.0);
+  EXPECT_EQ(itr->second, "five");
+  EXPECT_EQ(l.size(), 1);
+  EXPECT_EQ(l.find(5), itr);
+
+  // Emplacing again doesn't replace the existing level.
+  auto [itr2, inserted2] = l.emplace(std::make_pair(5.0, std::string("5")));
+  EXPECT_FALSE(inserted2);
+  EXPECT_EQ(itr2, itr);
+  EXPECT_EQ(itr2->second, "five");
+  EXPECT_EQ(l.size(), 1);
+}
+
+TEST(PriceLadder, AscendingIteration) {
+  AscendingLadder l(
+      TickGrid{.tick_size = 1, .min_price = 1, .max_price = 1000});
+  for (Price p : {700.0, 3.0, 65.0, 64.0, 1000.0, 1.0}) {
+    l.emplace(std::make_pair(p, std::string()));
+  }
+  std::vector<Price> prices;
+  for (auto& [price, value] : l) prices.push_back(price);
+  EXPECT_EQ(prices, (std::vector<Price>{1, 3, 64, 65, 700, 1000}));
+}
+
+TEST(PriceLadder, DescendingIteration) {
+  DescendingLadder l(
+      TickGrid{.tick_size = 1, .min_price = 1, .max_price = 1000});
+  for (Price p : {700.0, 3.0, 65.0, 64.0, 1000.0, 1.0}) {
+    l.emplace(std::make_pair(p, std::string()));
+  }
+  std::vector<Price> prices;
+  for (auto& [price, value] : l) prices.push_back(price);
+  EXPECT_EQ(prices, (std::vector<Price>{1000, 700, 65, 64, 3, 1}));
+}
+
+TEST(PriceLadder, IterationSkipsLargeGaps) {
+  AscendingLadder l(
+      TickGrid{.tick_size = 1, .min_price = 0, .max_price = 1000000});
+  for (Price p : {999999.0, 1000000.0, 0.0, 4095.0, 4096.0, 300000.0}) {
+    l.emplace(std::make_pair(p, std::string()));
+  }
+  std::vector<Price> prices;
+  for (auto& [price, value] : l) prices.push_back(price);
+  EXPECT_EQ(prices,
+            (std::vector<Price>{0, 4095, 4096, 300000, 999999, 1000000}));
+
+  l.erase(l.find(4096));
+  l.erase(l.find(4095));
+  auto next = l.erase(l.begin());
+  EXPECT_EQ(next->first, 300000.0);
+  EXPECT_EQ(l.begin(), next);
+}
+
+TEST(PriceLadder, EraseBestMovesToNextLevel) {
+  DescendingLadder l(
+      TickGrid{.tick_size = 1, .min_price = 1, .max_price = 1000});
+  l.emplace(std::make_pair(900.0, std::string("a")));
+  l.emplace(std::make_pair(10.0, std::string("b")));
+  ASSERT_EQ(l.begin()->first, 900.0);
+
+  auto next = l.erase(l.begin());
+  EXPECT_EQ(next->first, 10.0);
+  EXPECT_EQ(l.begin(), next);
+  EXPECT_EQ(l.size(), 1);
+  EXPECT_EQ(l.find(900), l.end());
+
+  next = l.erase(l.begin());
+  EXPECT_EQ(next, l.end());
+  EXPECT_EQ(l.begin(), l.end());
+  EXPECT_TRUE(l.empty());
+}
+
+TEST(PriceLadder, EraseResetsValue) {
+  AscendingLadder l(TickGrid{.tick_size = 1, .min_price = 1, .max_price = 10});
+  l.emplace(std::make_pair(2.0, std::string("two")));
+  l.emplace(std::make_pair(4.0, std::string("four")));
+  l.erase(l.find(4));
+  EXPECT_EQ(l.begin()->first, 2.0);
+  EXPECT_EQ(l.size(), 1);
+
+  auto [itr, inserted] = l.emplace(std::make_pair(4.0, std::string()));
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(itr->second, "");
+}
+
+}  // namespace mukhi::matching_engine
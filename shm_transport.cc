@@ -0,0 +1,284 @@
+#include "shm_transport.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include "spsc_ring.h"
+
+namespace mukhi::matching_engine {
+
+namespace {
+// "MESHMRNG", written last when the shared memory is created, so that clients
+// don't open it half initialized.
+constexpr uint64_t kShmMagic = 0x474e524d48534d45;
+// Room for the largest event, on whole cache lines.
+constexpr size_t kOutputSlotSize = 2 * kCacheLineSize;
+static_assert(kMaxBinaryEventSize <= kOutputSlotSize);
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<bool>::is_always_lock_free,
+              "Atomics in shared memory must be lock-free");
+
+size_t RoundUpToPowerOfTwo(size_t n) {
+  size_t size = 2;
+  while (size < n) size *= 2;
+  return size;
+}
+}  // namespace
+
+/*
+The shared memory starts with this header, followed by the slots of the input
+ring, then by those of the output ring. Everything written by different
+processes is on cache lines of its own.
+*/
+struct ShmRegion {
+  struct alignas(kCacheLineSize) InputSlot {
+    // The number of the message in the slot plus one once it's written, which
+    // becomes its number plus the capacity once it's read.
+    std::atomic<uint64_t> sequence;
+    char frame[kMaxBinaryMessageSize];
+  };
+  struct alignas(kCacheLineSize) Cursor {
+    // Position of the next event the consumer reads.
+    std::atomic<uint64_t> position;
+    std::atomic<bool> taken;
+  };
+
+  static size_t Size(uint64_t input_capacity, uint64_t output_capacity) {
+    return sizeof(ShmRegion) + input_capacity * sizeof(InputSlot) +
+           output_capacity * kOutputSlotSize;
+  }
+
+  InputSlot& input_slot(uint64_t n) {
+    return reinterpret_cast<InputSlot*>(this + 1)[n & (input_capacity - 1)];
+  }
+  char* output_slot(uint64_t position) {
+    return reinterpret_cast<char*>(this + 1) +
+           input_capacity * sizeof(InputSlot) +
+           (position & (output_capacity - 1)) * kOutputSlotSize;
+  }
+
+  std::atomic<uint64_t> magic;
+  uint64_t input_capacity;
+  uint64_t output_capacity;
+  // Number of messages claimed by clients.
+  alignas(kCacheLineSize) std::atomic<uint64_t> input_tail;
+  // Number of events published by the engine.
+  alignas(kCacheLineSize) std::atomic<uint64_t> output_tail;
+  alignas(kCacheLineSize) std::atomic<bool> closed;
+  Cursor cursors[kMaxShmConsumers];
+};
+
+std::unique_ptr<ShmTransport> ShmTransport::Create(
+    const ShmTransportOptions& options, std::ostream& es) {
+  uint64_t input_capacity = RoundUpToPowerOfTwo(options.input_capacity);
+  uint64_t output_capacity = RoundUpToPowerOfTwo(options.output_capacity);
+  size_t size = ShmRegion::Size(input_capacity, output_capacity);
+  const std::string& name = options.name;
+  ::shm_unlink(name.c_str());
+  int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+                      0600);
+  if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    es << "Unable to create shared memory " << name << " : "
+       << std::strerror(errno) << std::endl;
+    if (fd >= 0) {
+      ::close(fd);
+      ::shm_unlink(name.c_str());
+    }
+    return nullptr;
+  }
+  // The pages are faulted in now rather than on the first messages.
+  void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, 0);
+  // The mapping holds its own reference to the shared memory.
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    es << "Unable to map shared memory " << name << " : "
+       << std::strerror(errno) << std::endl;
+    ::shm_unlink(name.c_str());
+    return nullptr;
+  }
+  auto* region = new (addr) ShmRegion{};
+  region->input_capacity = input_capacity;
+  region->output_capacity = output_capacity;
+  for (uint64_t n = 0; n < input_capacity; ++n) {
+    new (&region->input_slot(n)) ShmRegion::InputSlot{};
+    region->input_slot(n).sequence.store(n, std::memory_order_relaxed);
+  }
+  region->magic.store(kShmMagic, std::memory_order_release);
+  return std::unique_ptr<ShmTransport>(new ShmTransport(name, region, size));
+}
+
+ShmTransport::~ShmTransport() {
+  Close();
+  ::munmap(region_, size_);
+  // Clients keep their mappings until they're done with them.
+  ::shm_unlink(name_.c_str());
+}
+
+size_t ShmTransport::TryPop(char* frame) {
+  ShmRegion::InputSlot& slot = region_->input_slot(head_);
+  if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) return 0;
+  // Clients aren't trusted with the length, a wrong one is reported by
+  // `ParseBinary`.
+  size_t length = std::clamp(BinaryMessageLength(slot.frame),
+                             kBinaryHeaderSize, kMaxBinaryMessageSize);
+  std::memcpy(frame, slot.frame, length);
+  slot.sequence.store(head_ + region_->input_capacity,
+                      std::memory_order_release);
+  ++head_;
+  return length;
+}
+
+char* ShmTransport::ClaimSlot() {
+  uint64_t capacity = region_->output_capacity;
+  if (sequence_ - cached_min_cursor_ >= capacity) {
+    Backoff backoff;
+    while (true) {
+      // Pairs with the fence of `ShmClient::Open`: a consumer either is seen
+      // here, or sees all the events published so far and starts after them.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      cached_min_cursor_ = sequence_;
+      for (const ShmRegion::Cursor& cursor : region_->cursors) {
+        if (cursor.taken.load(std::memory_order_relaxed)) {
+          cached_min_cursor_ =
+              std::min(cached_min_cursor_,
+                       cursor.position.load(std::memory_order_acquire));
+        }
+      }
+      if (sequence_ - cached_min_cursor_ < capacity) break;
+      if (closed()) return nullptr;
+      backoff.Pause();
+    }
+  }
+  return region_->output_slot(sequence_);
+}
+
+void ShmTransport::CommitSlot() {
+  region_->output_tail.store(++sequence_, std::memory_order_release);
+}
+
+void ShmTransport::Close() {
+  region_->closed.store(true, std::memory_order_release);
+}
+
+bool ShmTransport::closed() const {
+  return region_->closed.load(std::memory_order_acquire);
+}
+
+std::unique_ptr<ShmClient> ShmClient::Open(const std::string& name,
+                                           std::ostream& es) {
+  int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+  if (fd < 0) {
+    es << "Unable to open shared memory " << name << " : "
+       << std::strerror(errno) << std::endl;
+    return nullptr;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    es << "Unable to stat shared memory " << name << " : "
+       << std::strerror(errno) << std::endl;
+    ::close(fd);
+    return nullptr;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  void* addr = size < sizeof(ShmRegion)
+                   ? MAP_FAILED
+                   : ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    es << "Unable to map shared memory " << name << " : "
+       << (size < sizeof(ShmRegion) ? "Not a transport"
+                                    : std::strerror(errno))
+       << std::endl;
+    return nullptr;
+  }
+  auto* region = static_cast<ShmRegion*>(addr);
+  if (region->magic.load(std::memory_order_acquire) != kShmMagic ||
+      ShmRegion::Size(region->input_capacity, region->output_capacity) !=
+          size) {
+    es << "Unable to open shared memory " << name << " : Not a transport"
+       << std::endl;
+    ::munmap(addr, size);
+    return nullptr;
+  }
+  for (size_t i = 0; i < kMaxShmConsumers; ++i) {
+    ShmRegion::Cursor& cursor = region->cursors[i];
+    bool taken = false;
+    if (!cursor.taken.compare_exchange_strong(taken, true)) continue;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::unique_ptr<ShmClient> client(new ShmClient(region, size, i));
+    client->position_ =
+        region->output_tail.load(std::memory_order_acquire);
+    client->cached_tail_ = client->position_;
+    cursor.position.store(client->position_, std::memory_order_release);
+    return client;
+  }
+  es << "Unable to open shared memory " << name << " : All "
+     << kMaxShmConsumers << " consumers are taken" << std::endl;
+  ::munmap(addr, size);
+  return nullptr;
+}
+
+ShmClient::~ShmClient() {
+  region_->cursors[cursor_].taken.store(false, std::memory_order_release);
+  ::munmap(region_, size_);
+}
+
+bool ShmClient::TryPush(const InputMessage& msg) {
+  uint64_t n = region_->input_tail.load(std::memory_order_relaxed);
+  while (true) {
+    ShmRegion::InputSlot& slot = region_->input_slot(n);
+    auto diff = static_cast<int64_t>(
+        slot.sequence.load(std::memory_order_acquire) - n);
+    if (diff == 0) {
+      // The slot is free, claim it unless another client did first.
+      if (region_->input_tail.compare_exchange_weak(
+              n, n + 1, std::memory_order_relaxed)) {
+        EncodeBinary(msg, slot.frame);
+        slot.sequence.store(n + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // The message a lap ago wasn't read yet.
+      return false;
+    } else {
+      n = region_->input_tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void ShmClient::Push(const InputMessage& msg) {
+  Backoff backoff;
+  while (!TryPush(msg)) backoff.Pause();
+}
+
+std::optional<SequencedEvent> ShmClient::TryConsume(std::ostream& es) {
+  while (true) {
+    if (position_ == cached_tail_) {
+      cached_tail_ = region_->output_tail.load(std::memory_order_acquire);
+      if (position_ == cached_tail_) return std::nullopt;
+    }
+    const char* frame = region_->output_slot(position_);
+    size_t length = std::clamp(BinaryMessageLength(frame), kBinaryHeaderSize,
+                               kOutputSlotSize);
+    auto event = ParseBinaryEvent(std::string_view(frame, length), es);
+    // The slot can be reused from here on.
+    region_->cursors[cursor_].position.store(++position_,
+                                             std::memory_order_release);
+    if (event.has_value()) return event;
+  }
+}
+
+bool ShmClient::closed() const {
+  return region_->closed.load(std::memory_order_acquire);
+}
+
+}  // namespace mukhi::matching_engine
@@ -0,0 +1,204 @@
+#ifndef MATCHING_ENGINE_SHM_TRANSPORT_H
+#define MATCHING_ENGINE_SHM_TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "event_sink.h"
+#include "messages.h"
+
+namespace mukhi::matching_engine {
+
+struct ShmTransportOptions {
+  // Name of the POSIX shared memory object, e.g. "/matching_engine", which
+  // lives in /dev/shm on Linux. An object left there by a previous run is
+  // replaced.
+  std::string name;
+  // Number of messages, and of events, the rings hold. Rounded up to a power
+  // of two.
+  size_t input_capacity = 4096;
+  size_t output_capacity = 65536;
+};
+
+// Number of clients that can consume the events of a transport at once.
+constexpr size_t kMaxShmConsumers = 16;
+
+// Layout of the shared memory, see `shm_transport.cc`.
+struct ShmRegion;
+
+/*
+A transport between the engine and clients running on the same host, through
+rings in shared memory, which saves the system calls and copies of sockets.
+
+The shared memory holds two rings:
+
+* An input ring of binary messages (see `EncodeBinary`), which any number of
+  clients push to, and the engine pops from. Slots are claimed with a single
+  atomic increment and then carry the number of the message in them once it's
+  written, so that pushes don't wait on each other and the engine takes
+  messages in the order they were claimed.
+* An output ring of binary events, each one numbered by its position, which
+  the engine publishes to and every client consumes all of. Each consumer has
+  a cursor of its own in the shared memory, and the engine waits while the
+  ring is full for the slowest one, which applies backpressure to it like
+  `SpscRing` does.
+
+Both rings are written and read without locks or system calls: a message
+crosses from one process to the other in the time a cache line does. Both
+sides spin while waiting, see `Backoff`.
+
+A client that dies while holding a slot or a cursor stalls the engine, until
+the transport is closed.
+
+This is the engine side of the transport, which creates the shared memory and
+removes it on destruction. It's used from a single thread, except for `Close`.
+Clients use `ShmClient`.
+*/
+class ShmTransport {
+ public:
+  /**
+  Creates the shared memory. Returns nullptr and writes the reason to `es` if
+  it can't be created or mapped.
+  */
+  static std::unique_ptr<ShmTransport> Create(
+      const ShmTransportOptions& options, std::ostream& es);
+
+  ShmTransport(const ShmTransport&) = delete;
+  ShmTransport& operator=(const ShmTransport&) = delete;
+  ~ShmTransport();
+
+  /**
+  Pops the next message of the input ring into `frame`, which must have room
+  for `kMaxBinaryMessageSize` bytes. Returns its length, or 0 if there's none
+  yet.
+  */
+  size_t TryPop(char* frame);
+
+  /**
+  Publishes an event to the output ring, waiting while it's full. Once the
+  transport is closed, events that don't fit are dropped instead.
+  */
+  template <typename Event>
+  void Publish(const Event& event) {
+    if (char* frame = ClaimSlot(); frame != nullptr) {
+      EncodeBinary(event, sequence_ + 1, frame);
+      CommitSlot();
+    }
+  }
+
+  // The sequence number of the last event published, 0 if none was.
+  uint64_t sequence() const { return sequence_; }
+
+  /**
+  Tells the engine to stop once it has processed the messages already pushed,
+  and clients that no more events will be published. May be called from any
+  thread, or a signal handler.
+  */
+  void Close();
+  bool closed() const;
+
+ private:
+  ShmTransport(std::string name, ShmRegion* region, size_t size)
+      : name_(std::move(name)), region_(region), size_(size) {}
+
+  // Returns the slot of the next event, once all consumers have read the
+  // event it held, or nullptr if the transport is closed meanwhile.
+  char* ClaimSlot();
+  // Publishes the event written to the slot claimed.
+  void CommitSlot();
+
+  const std::string name_;
+  ShmRegion* const region_;
+  const size_t size_;
+  // Number of the next message of the input ring.
+  uint64_t head_ = 0;
+  uint64_t sequence_ = 0;
+  // The lowest cursor of the consumers, as of the last time they were read.
+  uint64_t cached_min_cursor_ = 0;
+};
+
+// Publishes events to the output ring of a transport, see
+// `ShmTransport::Publish`.
+class ShmEventSink : public EventSink {
+ public:
+  explicit ShmEventSink(ShmTransport& transport) : transport_(transport) {}
+
+  void OnTradeEvent(const TradeEvent& event) override {
+    transport_.Publish(event);
+  }
+  void OnOrderFullyFilled(const OrderFullyFilled& event) override {
+    transport_.Publish(event);
+  }
+  void OnOrderPartiallyFilled(const OrderPartiallyFilled& event) override {
+    transport_.Publish(event);
+  }
+  void OnDepthUpdate(const DepthUpdate& event) override {
+    transport_.Publish(event);
+  }
+  void OnBboUpdate(const Bbo& event) override { transport_.Publish(event); }
+
+ private:
+  ShmTransport& transport_;
+};
+
+/*
+The client side of a transport: pushes messages to the engine and consumes
+the events it publishes, which are all the events of the book. Clients pick
+the fills of their own orders by order id.
+
+A client consumes the events published from the time it's opened on. It takes
+one of the `kMaxShmConsumers` cursors of the transport, which it gives back on
+destruction. Clients must keep up with the events, since the engine waits for
+the slowest one.
+
+Objects of this class are used from a single thread. A process can open many.
+*/
+class ShmClient {
+ public:
+  /**
+  Opens the transport `name` created by the engine. Returns nullptr and writes
+  the reason to `es` if it doesn't exist, or if all the cursors are taken.
+  */
+  static std::unique_ptr<ShmClient> Open(const std::string& name,
+                                         std::ostream& es);
+
+  ShmClient(const ShmClient&) = delete;
+  ShmClient& operator=(const ShmClient&) = delete;
+  ~ShmClient();
+
+  // Pushes `msg` to the engine. Returns false if the input ring is full.
+  bool TryPush(const InputMessage& msg);
+  // Same as `TryPush`, but waits while the input ring is full.
+  void Push(const InputMessage& msg);
+
+  /**
+  Returns the next event, or `std::nullopt` if none was published yet. An
+  event that can't be decoded is reported on `es` and skipped.
+  */
+  std::optional<SequencedEvent> TryConsume(std::ostream& es);
+
+  // See `ShmTransport::Close`.
+  bool closed() const;
+
+ private:
+  ShmClient(ShmRegion* region, size_t size, size_t cursor)
+      : region_(region), size_(size), cursor_(cursor) {}
+
+  ShmRegion* const region_;
+  const size_t size_;
+  // Index of the cursor taken.
+  const size_t cursor_;
+  // Position of the next event, and the number of events published, as of
+  // the last time it was read.
+  uint64_t position_ = 0;
+  uint64_t cached_tail_ = 0;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_SHM_TRANSPORT_H
@@ -0,0 +1,201 @@
+#include "shm_transport.h"
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mukhi::matching_engine {
+
+// A name of its own for each test, and each run.
+std::string ShmName() {
+  return "/matching_engine_test_" + std::to_string(::getpid()) + "_" +
+         testing::UnitTest::GetInstance()->current_test_info()->name();
+}
+
+// Messages are compared by their binary encoding.
+std::string Encode(const InputMessage& msg) {
+  char buf[kMaxBinaryMessageSize];
+  return std::string(buf, EncodeBinary(msg, buf));
+}
+
+// Pops the next message, waiting for it.
+std::string Pop(ShmTransport& transport) {
+  char frame[kMaxBinaryMessageSize];
+  size_t length;
+  while ((length = transport.TryPop(frame)) == 0) std::this_thread::yield();
+  return std::string(frame, length);
+}
+
+TEST(ShmTransport, PushAndPop) {
+  std::ostringstream es;
+  auto transport = ShmTransport::Create(
+      {.name = ShmName(), .input_capacity = 4}, es);
+  ASSERT_NE(transport, nullptr) << es.str();
+  auto client = ShmClient::Open(ShmName(), es);
+  ASSERT_NE(client, nullptr) << es.str();
+  char frame[kMaxBinaryMessageSize];
+  EXPECT_EQ(transport->TryPop(frame), 0);
+
+  // Goes around the ring a few times.
+  for (OrderId round = 0; round < 3; ++round) {
+    std::vector<InputMessage> msgs = {
+        AddOrderRequest{.order_id = round,
+                        .side = Side::kSell,
+                        .qty = 10,
+                        .price = 1075.5,
+                        .symbol = *Symbol::FromString("AAPL")},
+        CancelOrderRequest{.order_id = round},
+        ModifyOrderRequest{.order_id = round, .qty = 5, .price = 1000},
+        CancelOrderRequest{.order_id = round + 1}};
+    for (const InputMessage& msg : msgs) EXPECT_TRUE(client->TryPush(msg));
+    // Full.
+    EXPECT_FALSE(client->TryPush(CancelOrderRequest{.order_id = 7}));
+    for (const InputMessage& msg : msgs) {
+      size_t length = transport->TryPop(frame);
+      EXPECT_EQ(std::string(frame, length), Encode(msg));
+    }
+    EXPECT_EQ(transport->TryPop(frame), 0);
+  }
+}
+
+TEST(ShmTransport, ManyProducers) {
+  constexpr int kClients = 4;
+  constexpr OrderId kMessages = 20000;
+  std::ostringstream es;
+  auto transport = ShmTransport::Create(
+      {.name = ShmName(), .input_capacity = 64}, es);
+  ASSERT_NE(transport, nullptr) << es.str();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kClients; ++i) {
+    auto client = ShmClient::Open(ShmName(), es);
+    ASSERT_NE(client, nullptr) << es.str();
+    threads.emplace_back([i, client = std::move(client)] {
+      for (OrderId n = 0; n < kMessages; ++n) {
+        client->Push(CancelOrderRequest{.order_id = i * kMessages + n});
+      }
+    });
+  }
+  // The messages of each client are popped in the order it pushed them.
+  std::vector<OrderId> next(kClients, 0);
+  std::ostringstream errors;
+  for (OrderId n = 0; n < kClients * kMessages; ++n) {
+    auto msg = ParseBinary(Pop(*transport), errors);
+    ASSERT_TRUE(msg.has_value()) << errors.str();
+    OrderId id = std::get<CancelOrderRequest>(*msg).order_id;
+    ASSERT_EQ(id % kMessages, next[id / kMessages]++);
+  }
+  for (std::thread& thread : threads) thread.join();
+  char frame[kMaxBinaryMessageSize];
+  EXPECT_EQ(transport->TryPop(frame), 0);
+}
+
+TEST(ShmTransport, BroadcastsEvents) {
+  std::ostringstream es;
+  auto transport = ShmTransport::Create({.name = ShmName()}, es);
+  ASSERT_NE(transport, nullptr) << es.str();
+  // Events published before a client opens the transport aren't consumed.
+  transport->Publish(OrderFullyFilled{.order_id = 1});
+  auto a = ShmClient::Open(ShmName(), es);
+  auto b = ShmClient::Open(ShmName(), es);
+  ASSERT_NE(a, nullptr) << es.str();
+  ASSERT_NE(b, nullptr) << es.str();
+  EXPECT_FALSE(a->TryConsume(es).has_value());
+
+  ShmEventSink sink(*transport);
+  sink.OnTradeEvent(TradeEvent{.qty = 3, .price = 100.25});
+  sink.OnOrderPartiallyFilled(
+      OrderPartiallyFilled{.order_id = 2, .remaining = 4});
+  EXPECT_EQ(transport->sequence(), 3);
+  for (ShmClient* client : {a.get(), b.get()}) {
+    auto trade = client->TryConsume(es);
+    ASSERT_TRUE(trade.has_value()) << es.str();
+    EXPECT_EQ(trade->sequence, 2);
+    EXPECT_EQ(std::get<TradeEvent>(trade->event).price, 100.25);
+    auto fill = client->TryConsume(es);
+    ASSERT_TRUE(fill.has_value()) << es.str();
+    EXPECT_EQ(fill->sequence, 3);
+    EXPECT_EQ(std::get<OrderPartiallyFilled>(fill->event).remaining, 4);
+    EXPECT_FALSE(client->TryConsume(es).has_value());
+  }
+  EXPECT_EQ(es.str(), "");
+}
+
+TEST(ShmTransport, WaitsForSlowestConsumer) {
+  constexpr OrderId kEvents = 10000;
+  std::ostringstream es;
+  auto transport = ShmTransport::Create(
+      {.name = ShmName(), .output_capacity = 4}, es);
+  ASSERT_NE(transport, nullptr) << es.str();
+  std::vector<std::unique_ptr<ShmClient>> clients;
+  for (int i = 0; i < 2; ++i) {
+    clients.push_back(ShmClient::Open(ShmName(), es));
+    ASSERT_NE(clients.back(), nullptr) << es.str();
+  }
+  std::thread publisher([&] {
+    for (OrderId id = 1; id <= kEvents; ++id) {
+      transport->Publish(OrderFullyFilled{.order_id = id});
+    }
+  });
+  // Consumed in turns, so that either one is the slowest at times.
+  std::vector<OrderId> next(clients.size(), 1);
+  while (next[0] <= kEvents || next[1] <= kEvents) {
+    for (size_t i = 0; i < clients.size(); ++i) {
+      auto event = clients[i]->TryConsume(es);
+      if (!event.has_value()) {
+        std::this_thread::yield();
+        continue;
+      }
+      ASSERT_EQ(event->sequence, next[i]);
+      ASSERT_EQ(std::get<OrderFullyFilled>(event->event).order_id, next[i]);
+      ++next[i];
+    }
+  }
+  publisher.join();
+}
+
+TEST(ShmTransport, DropsEventsOnceClosed) {
+  std::ostringstream es;
+  auto transport = ShmTransport::Create(
+      {.name = ShmName(), .output_capacity = 2}, es);
+  ASSERT_NE(transport, nullptr) << es.str();
+  auto client = ShmClient::Open(ShmName(), es);
+  ASSERT_NE(client, nullptr) << es.str();
+  transport->Close();
+  EXPECT_TRUE(client->closed());
+  for (OrderId id = 1; id <= 3; ++id) {
+    transport->Publish(OrderFullyFilled{.order_id = id});
+  }
+  EXPECT_EQ(transport->sequence(), 2);
+}
+
+TEST(ShmTransport, TooManyConsumers) {
+  std::ostringstream es;
+  auto transport = ShmTransport::Create({.name = ShmName()}, es);
+  ASSERT_NE(transport, nullptr) << es.str();
+  std::vector<std::unique_ptr<ShmClient>> clients;
+  for (size_t i = 0; i < kMaxShmConsumers; ++i) {
+    clients.push_back(ShmClient::Open(ShmName(), es));
+    ASSERT_NE(clients.back(), nullptr) << es.str();
+  }
+  EXPECT_EQ(ShmClient::Open(ShmName(), es), nullptr);
+  EXPECT_EQ(es.str(), "Unable to open shared memory " + ShmName() +
+                          " : All 16 consumers are taken\n");
+  // Cursors are given back.
+  clients.pop_back();
+  EXPECT_NE(ShmClient::Open(ShmName(), es), nullptr);
+}
+
+TEST(ShmTransport, RemovedOnDestruction) {
+  std::ostringstream es;
+  ShmTransport::Create({.name = ShmName()}, es).reset();
+  EXPECT_EQ(ShmClient::Open(ShmName(), es), nullptr);
+  EXPECT_EQ(es.str(), "Unable to open shared memory " + ShmName() +
+                          " : No such file or directory\n");
+}
+
+}  // namespace mukhi::matching_engine
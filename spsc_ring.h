@@ -0,0 +1,223 @@
+#ifndef MATCHING_ENGINE_SPSC_RING_H
+#define MATCHING_ENGINE_SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mukhi::matching_engine {
+
+// Size of a cache line on the targets we care about, used to keep the state
+// written by different threads on different lines.
+constexpr size_t kCacheLineSize = 64;
+
+/*
+Backs off while waiting on another thread: spins for a little while, which is
+cheapest when the wait is short, then yields the CPU, which lets the other
+thread run when they share a core. Once it has yielded for a while, the wait is
+unlikely to be short and a waiter that can block should do so, see `Exhausted`.
+*/
+class Backoff {
+ public:
+  void Pause() {
+    if (spins_ < kMaxSpins) {
+      ++spins_;
+#if defined(__x86_64__)
+      __builtin_ia32_pause();
+#endif
+    } else {
+      ++yields_;
+      std::this_thread::yield();
+    }
+  }
+
+  // Whether spinning and yielding have gone on long enough that it's cheaper
+  // to block.
+  bool Exhausted() const { return yields_ >= kMaxYields; }
+
+ private:
+  static constexpr int kMaxSpins = 128;
+  static constexpr int kMaxYields = 256;
+  int spins_ = 0;
+  int yields_ = 0;
+};
+
+/*
+A bounded, lock-free queue between exactly one producer thread and one consumer
+thread.
+
+The producer and the consumer each own an index, kept on its own cache line,
+along with a cached copy of the other thread's index, so that they only read
+each other's line when the ring looks full (or empty) according to the cache.
+The consumer takes items in batches, with a single update of its index per
+batch. The producer waits while the ring is full, which applies backpressure to
+it when the consumer falls behind.
+
+A consumer waiting for items spins and yields for a while, see `Backoff`, then
+goes to sleep on a condition variable until the producer pushes or closes the
+ring, so that an idle consumer doesn't take a CPU. The price is a memory fence
+on every push, for the producer to see whether the consumer is asleep, and the
+wake-up latency of the first item after an idle period. The producer waiting on
+a full ring doesn't sleep, as the consumer is busy draining it.
+
+Once the producer calls `Close`, the consumer drains the remaining items and is
+then told that there are no more.
+*/
+template <typename T>
+class SpscRing {
+ public:
+  // `capacity` is rounded up to a power of two.
+  explicit SpscRing(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  size_t capacity() const { return slots_.size(); }
+
+  // Producer only. Returns false if the ring is full.
+  bool TryPush(T&& value) {
+    size_t tail = producer_.tail.load(std::memory_order_relaxed);
+    if (tail - producer_.cached_head == slots_.size()) {
+      producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+      if (tail - producer_.cached_head == slots_.size()) return false;
+    }
+    slots_[tail & mask_] = std::move(value);
+    producer_.tail.store(tail + 1, std::memory_order_release);
+    Wake();
+    return true;
+  }
+
+  // Producer only. Waits while the ring is full.
+  void Push(T value) {
+    Backoff backoff;
+    while (!TryPush(std::move(value))) backoff.Pause();
+  }
+
+  // Producer only. No items may be pushed afterwards.
+  void Close() {
+    closed_.store(true, std::memory_order_release);
+    Wake();
+  }
+
+  // Consumer only. Moves up to `max` items into `out` and returns their
+  // number, 0 if the ring is empty.
+  size_t TryPopBatch(T* out, size_t max) {
+    size_t head = consumer_.head.load(std::memory_order_relaxed);
+    if (consumer_.cached_tail == head) {
+      consumer_.cached_tail = producer_.tail.load(std::memory_order_acquire);
+      if (consumer_.cached_tail == head) return 0;
+    }
+    size_t n = std::min(max, consumer_.cached_tail - head);
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = std::move(slots_[(head + i) & mask_]);
+    }
+    consumer_.head.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer only. Same as `TryPopBatch` but waits for at least one item.
+  // Returns 0 only once the ring is closed and drained.
+  size_t PopBatch(T* out, size_t max) { return Pop(out, max, std::nullopt); }
+
+  // Consumer only. Same as `PopBatch` but also returns 0 once `deadline` has
+  // passed.
+  size_t PopBatchUntil(T* out, size_t max,
+                       std::chrono::steady_clock::time_point deadline) {
+    return Pop(out, max, deadline);
+  }
+
+ private:
+  struct alignas(kCacheLineSize) Producer {
+    std::atomic<size_t> tail = 0;
+    size_t cached_head = 0;
+  };
+  struct alignas(kCacheLineSize) Consumer {
+    std::atomic<size_t> head = 0;
+    size_t cached_tail = 0;
+  };
+
+  // Where the consumer sleeps. `sleeping` is only written under `mutex`.
+  struct alignas(kCacheLineSize) Waiter {
+    std::atomic<bool> sleeping = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+
+  size_t Pop(T* out, size_t max,
+             std::optional<std::chrono::steady_clock::time_point> deadline) {
+    Backoff backoff;
+    while (true) {
+      // Read before trying, so that the items pushed before closing are seen.
+      bool closed = closed_.load(std::memory_order_acquire);
+      if (size_t n = TryPopBatch(out, max); n > 0 || closed) return n;
+      if (deadline.has_value() &&
+          std::chrono::steady_clock::now() >= *deadline) {
+        return 0;
+      }
+      if (!backoff.Exhausted()) {
+        backoff.Pause();
+      } else if (!Sleep(deadline)) {
+        return 0;
+      }
+    }
+  }
+
+  // Consumer only. Sleeps until the producer pushes or closes the ring.
+  // Returns false if `deadline` passed first.
+  bool Sleep(std::optional<std::chrono::steady_clock::time_point> deadline) {
+    std::unique_lock lock(waiter_.mutex);
+    waiter_.sleeping.store(true, std::memory_order_relaxed);
+    // Pairs with the fence in `Wake`: either the producer sees that we're
+    // sleeping, or we see what it pushed.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool woken = true;
+    if (producer_.tail.load(std::memory_order_relaxed) ==
+            consumer_.head.load(std::memory_order_relaxed) &&
+        !closed_.load(std::memory_order_relaxed)) {
+      auto awake = [this] {
+        return !waiter_.sleeping.load(std::memory_order_relaxed);
+      };
+      if (deadline.has_value()) {
+        woken = waiter_.cv.wait_until(lock, *deadline, awake);
+      } else {
+        waiter_.cv.wait(lock, awake);
+      }
+    }
+    waiter_.sleeping.store(false, std::memory_order_relaxed);
+    return woken;
+  }
+
+  // Producer only. Wakes the consumer if it's sleeping.
+  void Wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!waiter_.sleeping.load(std::memory_order_relaxed)) return;
+    {
+      std::lock_guard lock(waiter_.mutex);
+      waiter_.sleeping.store(false, std::memory_order_relaxed);
+    }
+    waiter_.cv.notify_one();
+  }
+
+  Producer producer_;
+  Consumer consumer_;
+  alignas(kCacheLineSize) std::atomic<bool> closed_ = false;
+  Waiter waiter_;
+  std::vector<T> slots_;
+  size_t mask_;
+};
+
+}  // namespace mukhi::matching_engine
+
+#endif  // MATCHING_ENGINE_SPSC_RING_H
@@ -0,0 +1,101 @@
+#include "spsc_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace mukhi::matching_engine {
+
+TEST(SpscRing, Capacity) {
+  EXPECT_EQ(SpscRing<int>(0).capacity(), 2);
+  EXPECT_EQ(SpscRing<int>(8).capacity(), 8);
+  EXPECT_EQ(SpscRing<int>(9).capacity(), 16);
+}
+
+TEST(SpscRing, PushAndPop) {
+  SpscRing<std::string> ring(4);
+  std::string out[8];
+  EXPECT_EQ(ring.TryPopBatch(out, 8), 0);
+
+  // Goes around the ring a few times.
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(ring.TryPush(std::to_string(round * 4 + i)));
+    }
+    // Full.
+    EXPECT_FALSE(ring.TryPush("x"));
+
+    EXPECT_EQ(ring.TryPopBatch(out, 3), 3);
+    EXPECT_EQ(out[0], std::to_string(round * 4));
+    EXPECT_EQ(out[2], std::to_string(round * 4 + 2));
+    EXPECT_EQ(ring.TryPopBatch(out, 8), 1);
+    EXPECT_EQ(out[0], std::to_string(round * 4 + 3));
+    EXPECT_EQ(ring.TryPopBatch(out, 8), 0);
+  }
+}
+
+TEST(SpscRing, Close) {
+  SpscRing<int> ring(4);
+  ring.Push(1);
+  ring.Push(2);
+  ring.Close();
+  int out[4];
+  // Items pushed before closing are still delivered.
+  EXPECT_EQ(ring.PopBatch(out, 4), 2);
+  EXPECT_EQ(ring.PopBatch(out, 4), 0);
+}
+
+TEST(SpscRing, PopBatchUntil) {
+  SpscRing<int> ring(4);
+  int out[4];
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(ring.PopBatchUntil(out, 4, start + std::chrono::milliseconds(20)),
+            0);
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+
+  ring.Push(1);
+  EXPECT_EQ(ring.PopBatchUntil(out, 4, start), 1);
+  EXPECT_EQ(out[0], 1);
+}
+
+TEST(SpscRing, WakesSleepingConsumer) {
+  SpscRing<int> ring(4);
+  std::thread producer([&ring] {
+    // Long enough for the consumer to go to sleep.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ring.Push(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ring.Close();
+  });
+  int out[4];
+  EXPECT_EQ(ring.PopBatch(out, 4), 1);
+  EXPECT_EQ(out[0], 1);
+  EXPECT_EQ(ring.PopBatch(out, 4), 0);
+  producer.join();
+}
+
+TEST(SpscRing, ProducerAndConsumerThreads) {
+  constexpr uint64_t kItems = 200000;
+  SpscRing<uint64_t> ring(64);
+  std::thread producer([&ring] {
+    for (uint64_t i = 0; i < kItems; ++i) ring.Push(i);
+    ring.Close();
+  });
+
+  uint64_t expected = 0;
+  uint64_t out[16];
+  while (size_t n = ring.PopBatch(out, 16)) {
+    for (size_t i = 0; i < n; ++i) {
+      // Everything arrives, in order.
+      ASSERT_EQ(out[i], expected++);
+    }
+  }
+  producer.join();
+  EXPECT_EQ(expected, kItems);
+}
+
+}  // namespace mukhi::matching_engine